@@ -16,6 +16,7 @@
 #include "../Render/Swapchain.h"
 
 #include "../Render/Texture2D.h"
+#include "../Render/TextureRegistry.h"
 
 #include "../Events/Events.h"
 
@@ -35,6 +36,10 @@ namespace ZVK
 
 		void Init(const std::string& title, int width, int height);
 
+		// No window, surface or swapchain. Frames are rendered into an offscreen image of the given size
+		// that Renderer::ReadPixels copies back, GLFW is never initialized
+		void InitHeadless(const std::string& title, uint32_t width, uint32_t height);
+
 		VkCommandBuffer BeginSingleTimeCommands();
 		void EndSingleTimeCommands(VkCommandBuffer cmdBuffer);
 
@@ -58,15 +63,18 @@ namespace ZVK
 		VkFormat FindDepthFormat();
 
 		inline ZWindow& GetWindow() const { return *p_window; }
-		inline GLFWwindow* GetGLFWWindnow() const { return p_window->GetWindow(); }
+		inline GLFWwindow* GetGLFWWindnow() const { return p_window ? p_window->GetWindow() : nullptr; }
 		inline ZDevice* GetDevice() const { return p_device; }
 		inline ZSwapchain* GetSwapchain() const { return p_swapchain; }
+		inline TextureRegistry* GetTextureRegistry() const { return p_textureRegistry; }
 
 		inline const VkInstance& GetInstance() const { return m_instance; }
 		inline const VkSurfaceKHR& GetSurface() const { return m_surface; }
 
 		inline const VkCommandPool GetCmdPool() const { return m_cmdPool; }
 
+		inline bool IsHeadless() const { return m_isHeadless; }
+
 		inline bool EnabledValidationLayers() const { return m_enableValidationLayers; }
 		inline const VkDebugUtilsMessengerEXT& GetDebugMessenger() const { return m_debugMessenger; }
 		inline const std::vector<const char*>& GetValidationLayers() const { return m_validationLayers; }
@@ -106,13 +114,16 @@ namespace ZVK
 		std::unique_ptr<ZWindow> p_window;
 		ZDevice* p_device;
 		ZSwapchain* p_swapchain;
+		TextureRegistry* p_textureRegistry = nullptr;
 
 		Dispatcher<SwapchainRecreateEvent> m_recreateDispatcher;
 		Dispatcher<SwapchainCleanupEvent> m_swapchainCleanupDispatcher;
 
 		VkInstance m_instance;
 		VkDebugUtilsMessengerEXT m_debugMessenger;
-		VkSurfaceKHR m_surface;
+		VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+
+		bool m_isHeadless = false;
 
 		VkCommandPool m_cmdPool;
 		std::vector<VkCommandBuffer> m_cmdBuffers;
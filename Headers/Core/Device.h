@@ -61,7 +61,8 @@ namespace ZVK
 
 		VkSampleCountFlagBits m_msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
-		const std::vector<const char*> m_deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		// Headless nothing is presented so the swapchain extension is dropped
+		std::vector<const char*> m_deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
 		Core* p_core = nullptr;
 	};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace ZVK
+{
+	// A fixed set of worker threads that split loops into ranges.
+	// With no worker threads every loop runs on the calling thread in order
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount = GetDefaultThreadCount());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		// Calls func(begin, end) on ranges covering [0, count), a range is never smaller than minRangeSize
+		// unless it's the last one. The calling thread works on a range too and the call returns
+		// once every range is done, func must not write to anything another range touches
+		void ParallelFor(uint32_t count, uint32_t minRangeSize,
+			const std::function<void(uint32_t, uint32_t)>& func);
+
+		inline uint32_t GetThreadCount() const { return (uint32_t)m_threads.size(); }
+
+		// One thread less than the hardware threads so the calling thread has a core to itself
+		static uint32_t GetDefaultThreadCount();
+
+	private:
+		void workerLoop();
+
+	private:
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobAvailable;
+		std::condition_variable m_jobsDone;
+
+		std::vector<std::function<void()>> m_jobs;
+		uint32_t m_pendingJobs = 0;
+
+		bool m_isStopping = false;
+	};
+}
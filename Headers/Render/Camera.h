@@ -33,6 +33,9 @@ namespace ZVK
 
 		Vec2 GetScreenPos(const Vec2& pos) const;
 
+		// The world space rect the camera sees as (min x, min y, max x, max y)
+		Vec4 GetVisibleRect() const;
+
 		void SetProjection(float left, float right, float bottom, float top);
 
 		// void SetTranslationSpeed(float speed) { if(speed >= 0) m_translationSpeed = speed; }
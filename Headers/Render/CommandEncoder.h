@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vulkan/vulkan.h>
+
+// Descriptor sets the encoder keeps track of, sets past this are always bound
+#define MAX_ENCODER_DESCRIPTOR_SETS 4
+
+// The least push constant space every device has, larger pushes are never skipped
+#define MAX_ENCODER_PUSH_CONSTANT_SIZE 128
+
+namespace ZVK
+{
+	// Binds and dynamic state calls that reached the command buffer and the ones that
+	// were skipped because they wouldn't have changed anything
+	struct EncoderStats
+	{
+		uint32_t IssuedCount = 0;
+		uint32_t SkippedCount = 0;
+	};
+
+	// Records binds and dynamic state into a command buffer and skips the ones that are already set.
+	// It only knows about the calls made through it, so everything bound to its command buffer has to go through it
+	class CommandEncoder
+	{
+	public:
+		CommandEncoder() = default;
+		explicit CommandEncoder(VkCommandBuffer cmdBuffer) { Reset(cmdBuffer); }
+
+		// Forgets the bound state, must be called whenever the encoder moves to a command buffer that was just begun
+		void Reset(VkCommandBuffer cmdBuffer);
+
+		inline VkCommandBuffer GetCommandBuffer() const { return m_cmdBuffer; }
+
+		void SetViewport(const VkViewport& viewport);
+		void SetScissor(const VkRect2D& scissor);
+
+		void BindPipeline(VkPipeline pipeline);
+
+		// Only the range of sets that changed is bound. Binding with a different layout binds every set
+		void BindDescriptorSets(VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+			const VkDescriptorSet* pSets);
+
+		// Skipped when the same bytes were the last ones pushed with the layout since the pipeline changed
+		void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size,
+			const void* pData);
+
+		void BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset);
+		void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+		// Kept across Reset so a frame's command buffers can share the totals
+		inline const EncoderStats& GetStats() const { return m_stats; }
+		inline void ResetStats() { m_stats = EncoderStats(); }
+
+	private:
+		VkCommandBuffer m_cmdBuffer = VK_NULL_HANDLE;
+
+		VkViewport m_viewport{};
+		VkRect2D m_scissor{};
+		bool m_isViewportSet = false;
+		bool m_isScissorSet = false;
+
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+		VkPipelineLayout m_layout = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, MAX_ENCODER_DESCRIPTOR_SETS> m_descriptorSets{};
+
+		VkPipelineLayout m_pushConstantLayout = VK_NULL_HANDLE;
+		VkShaderStageFlags m_pushConstantStages = 0;
+		uint32_t m_pushConstantOffset = 0;
+		uint32_t m_pushConstantSize = 0;
+		std::array<uint8_t, MAX_ENCODER_PUSH_CONSTANT_SIZE> m_pushConstants{};
+
+		VkBuffer m_vertexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize m_vertexOffset = 0;
+
+		VkBuffer m_indexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize m_indexOffset = 0;
+		VkIndexType m_indexType = VK_INDEX_TYPE_UINT16;
+
+		EncoderStats m_stats;
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vulkan/vulkan.h>
+
+// Descriptor sets a packet binds at the most, starting from set 0
+#define MAX_PACKET_DESCRIPTOR_SETS 2
+
+// Push constant bytes a packet carries at the most, enough for a view projection matrix
+#define MAX_PACKET_PUSH_CONSTANT_SIZE 64
+
+namespace ZVK
+{
+	enum class DrawPacketType : uint32_t
+	{
+		DRAW         = 0, // Draws Count vertices of the vertex buffer
+		DRAW_INDEXED = 1, // Draws Count indices of the index buffer
+		EXECUTE      = 2  // Executes CmdBuffer, a recorded secondary command buffer. Only uses the sort key
+	};
+
+	// Everything one draw records. Packets are plain data so the frame's packets are kept in one array,
+	// sorted by their keys and recorded by one loop. The fields are laid out without padding,
+	// so a value initialized packet that's filled in the same way has the same bytes every frame
+	struct DrawPacket
+	{
+		uint64_t SortKey; // See MakeSortKey, packets with the same key keep the order they were added in
+		DrawPacketType Type;
+
+		// The packet uses memory that only lives for the frame, like the dynamic vertex buffer.
+		// A frame with one of these is never submitted again
+		VkBool32 IsTransient;
+
+		VkCommandBuffer CmdBuffer;
+
+		VkPipeline Pipeline;
+		VkPipelineLayout PipelineLayout;
+		VkDescriptorSet DescriptorSets[MAX_PACKET_DESCRIPTOR_SETS];
+
+		VkBuffer VertexBuffer;
+		VkDeviceSize VertexOffset;
+
+		VkBuffer IndexBuffer;
+		VkDeviceSize IndexOffset;
+
+		VkViewport Viewport;
+		VkRect2D Scissor;
+
+		uint32_t DescriptorSetCount;
+		VkIndexType IndexType;
+
+		uint32_t Count; // Vertices, or indices for DRAW_INDEXED
+		uint32_t InstanceCount;
+		uint32_t FirstIndex; // DRAW_INDEXED only
+		int32_t BaseVertex; // DRAW_INDEXED only, added to every index
+
+		// Pushed at offset 0
+		VkShaderStageFlags PushConstantStages;
+		uint32_t PushConstantSize;
+		uint8_t PushConstants[MAX_PACKET_PUSH_CONSTANT_SIZE];
+	};
+
+	// The record cache hashes packets as raw bytes so padding would make equal packets hash differently.
+	// Dispatchable handles are 4 bytes on 32 bit targets which pads the struct, so those aren't supported
+	static_assert(sizeof(DrawPacket) == 224, "DrawPacket has padding, its bytes can't be hashed");
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vulkan/vulkan.h>
+
+#define ROW_MAJOR
+#include "../Math/ZMath.h"
+
+namespace ZVK
+{
+	// The camera and viewport a draw call was made with. Renderers take a copy at every draw call
+	// so the same objects can be drawn more than once a frame, like a minimap or split screen.
+	// Laid out without padding so views can be compared with memcmp
+	struct DrawView
+	{
+		Mat4 ViewProjection;
+		VkViewport Viewport;
+		VkRect2D Scissor;
+	};
+
+	// viewportInfo = x, y, width, height like the renderers' SetViewport
+	inline DrawView MakeDrawView(const Mat4& viewProjection, const Vec4& viewportInfo,
+		const Vec2i& scissorOffset, const VkExtent2D& scissorExtent)
+	{
+		DrawView view{};
+		view.ViewProjection = viewProjection;
+
+		view.Viewport.x = viewportInfo.x;
+		view.Viewport.y = viewportInfo.y;
+		view.Viewport.width = viewportInfo.z;
+		view.Viewport.height = viewportInfo.w;
+		view.Viewport.minDepth = 0.f;
+		view.Viewport.maxDepth = 1.f;
+
+		view.Scissor.offset = { scissorOffset.x, scissorOffset.y };
+		view.Scissor.extent = scissorExtent;
+
+		return view;
+	}
+}
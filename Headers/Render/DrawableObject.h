@@ -44,38 +44,42 @@ namespace ZVK
 		inline float GetRotationY() const { return m_rotation.y; }
 		inline float GetRotationZ() const { return m_rotation.z; }
 
+		// Changes every time the object is modified, renderers compare it to
+		// the version they last built vertices for to skip unchanged objects
+		inline uint32_t GetVersion() const { return m_version; }
+
 		inline float GetR() const { return m_colour.x; }
 		inline float GetG() const { return m_colour.y; }
 		inline float GetB() const { return m_colour.z; }
 		inline float GetA() const { return m_colour.w; }
 
-		inline void SetPos(Vec3 pos)               { m_pos        = pos;        }
-		inline void SetDimensions(Vec3 dimensions) { m_dimensions = dimensions; }
-		inline void SetScale(Vec3 scale)           { m_scale      = scale;      }
-		inline void SetColour(Vec4 colour)         { m_colour     = colour;     }
-		inline void SetRotation(Vec3 rotation)     { m_rotation   = rotation;   }
+		inline void SetPos(Vec3 pos)               { m_pos        = pos; ++m_version;        }
+		inline void SetDimensions(Vec3 dimensions) { m_dimensions = dimensions; ++m_version; }
+		inline void SetScale(Vec3 scale)           { m_scale      = scale; ++m_version;      }
+		inline void SetColour(Vec4 colour)         { m_colour     = colour; ++m_version;     }
+		inline void SetRotation(Vec3 rotation)     { m_rotation   = rotation; ++m_version;   }
 
-		inline void SetX(float x) { m_pos.x = x; }
-		inline void SetY(float y) { m_pos.y = y; }
-		inline void SetW(float z) { m_pos.z = z; }
+		inline void SetX(float x) { m_pos.x = x; ++m_version; }
+		inline void SetY(float y) { m_pos.y = y; ++m_version; }
+		inline void SetW(float z) { m_pos.z = z; ++m_version; }
 
-		inline void SetWidth(float width)   { m_dimensions.x = width;  }
-		inline void SetHeight(float height) { m_dimensions.y = height; }
-		inline void SetDepth(float depth)   { m_dimensions.z = depth;  }
+		inline void SetWidth(float width)   { m_dimensions.x = width; ++m_version;  }
+		inline void SetHeight(float height) { m_dimensions.y = height; ++m_version; }
+		inline void SetDepth(float depth)   { m_dimensions.z = depth; ++m_version;  }
 
-		inline void SetScale(float scale) { m_scale = Vec3(scale, scale, scale); }
-		inline void SetScaleX(float scale) { m_scale.x = scale; }
-		inline void SetScaleY(float scale) { m_scale.y = scale; }
-		inline void SetScaleZ(float scale) { m_scale.z = scale; }
+		inline void SetScale(float scale) { m_scale = Vec3(scale, scale, scale); ++m_version; }
+		inline void SetScaleX(float scale) { m_scale.x = scale; ++m_version; }
+		inline void SetScaleY(float scale) { m_scale.y = scale; ++m_version; }
+		inline void SetScaleZ(float scale) { m_scale.z = scale; ++m_version; }
 		
-		inline void SetRotationX(float rotation) { m_rotation.x = rotation; }
-		inline void SetRotationY(float rotation) { m_rotation.y = rotation; }
-		inline void SetRotationZ(float rotation) { m_rotation.z = rotation; }
+		inline void SetRotationX(float rotation) { m_rotation.x = rotation; ++m_version; }
+		inline void SetRotationY(float rotation) { m_rotation.y = rotation; ++m_version; }
+		inline void SetRotationZ(float rotation) { m_rotation.z = rotation; ++m_version; }
 
-		inline void SetR(float r) { m_colour.x = r; }
-		inline void SetG(float g) { m_colour.y = g; }
-		inline void SetB(float b) { m_colour.z = b; }
-		inline void SetA(float a) { m_colour.w = a; }
+		inline void SetR(float r) { m_colour.x = r; ++m_version; }
+		inline void SetG(float g) { m_colour.y = g; ++m_version; }
+		inline void SetB(float b) { m_colour.z = b; ++m_version; }
+		inline void SetA(float a) { m_colour.w = a; ++m_version; }
 
 	protected:
 		Vec3 m_pos;
@@ -83,5 +87,7 @@ namespace ZVK
 		Vec3 m_scale = Vec3::One();
 		Vec3 m_rotation = Vec3::Zero();
 		Vec4 m_colour;
+
+		uint32_t m_version = 0;
 	};
 }
\ No newline at end of file
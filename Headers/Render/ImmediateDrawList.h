@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "DrawView.h"
+
+namespace ZVK
+{
+	// Elements (instances or quads) drawn for the current frame only. They're written into chunks of the
+	// renderer's dynamic vertex buffer, which is reset every frame, so nothing has to be freed and
+	// steady frames don't allocate. Elements added one after another with the same view share a draw
+	class ImmediateDrawList
+	{
+	public:
+		struct Draw
+		{
+			VkBuffer Buffer;
+			VkDeviceSize Offset;
+			uint32_t Count; // Elements
+			DrawView View;
+		};
+
+	public:
+		// elementSize is the bytes of one element, chunkElementCount how many are reserved at a time
+		ImmediateDrawList(VkDeviceSize elementSize, uint32_t chunkElementCount)
+			: m_elementSize(elementSize), m_chunkElementCount(chunkElementCount) {}
+
+		// Returns room for maxCount elements, End has to be given how many were written
+		void* Begin(RingBuffer& ring, uint32_t maxCount, const DrawView& view);
+		void End(uint32_t count);
+
+		inline const std::vector<Draw>& GetDraws() const { return m_draws; }
+		inline uint32_t GetElementCount() const { return m_elementCount; }
+
+		// Must be called once the draws are handed to the renderer, the memory is only valid for the frame it was written in
+		void Clear();
+
+	private:
+		VkDeviceSize m_elementSize;
+		uint32_t m_chunkElementCount;
+
+		// Keeps its capacity when it's cleared
+		std::vector<Draw> m_draws;
+		uint32_t m_elementCount = 0;
+
+		RingAllocation m_chunk;
+		uint32_t m_chunkUsed = 0;
+		uint32_t m_chunkCapacity = 0;
+	};
+}
@@ -260,6 +260,9 @@ namespace ZVK
 		inline const VkPipeline GetPipeline() const { return m_pipeline; }
 		inline const VkDescriptorPool GetDescriptorPool() const { return m_descriptorPool; }
 
+		// Goes into the sort key of the pipeline's draws so draws with the same pipeline end up next to each other
+		inline uint32_t GetID() const { return m_id; }
+
 		inline bool IsDescriptorSetAllocated() const { return m_isDiscriptorSetAllocated; }
 		inline void SetIsDescriptorSetAllocated(bool value) { m_isDiscriptorSetAllocated = value; }
 
@@ -303,6 +306,9 @@ namespace ZVK
 
 		bool m_isDiscriptorSetAllocated = false;
 
+		uint32_t m_id = s_idCounter++;
+		inline static uint32_t s_idCounter = 0;
+
 		std::function<void(SwapchainRecreateEvent&)> m_swapchainRecreateEvent;
 		std::function<void(SwapchainCleanupEvent&)> m_swapchainCleanupEvent;
 	};
@@ -1,76 +1,81 @@
 #pragma once
 
 #include "IPipeline.h"
+#include "VertexPacking.h"
 
 #define ROW_MAJOR
 #include "../../Math/ZMath.h"
 
 namespace ZVK
 {
-	struct ShapeVertex
+	// One record per shape, the vertex shader expands it into a quad. 48 bytes
+	struct ShapeInstance
 	{
-		Vec3 pos;
-		Vec4 colour;
-		Vec2 localPos;
-		float circleThickness;
-		float circleFade;
-		float shapeType;
+		Vec2 center;
+		// The quad's corners are center +- axisX +- axisY, they already include the shape's scale and rotation
+		Vec2 axisX;
+		Vec2 axisY;
+		int16_t depth; // See PackDepth, already includes the shape's depth
+		uint16_t shapeType; // ShapeType
+		uint32_t colour; // See PackColour
+		Vec4 params; // See IShape::GetShapeParams
 
 		static VkVertexInputBindingDescription GetBindingDescription()
 		{
 			VkVertexInputBindingDescription bindingDescription{};
 
 			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(ShapeVertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			bindingDescription.stride = sizeof(ShapeInstance);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
 			return bindingDescription;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 6> GetAttributeDescriptions()
+		static std::array<VkVertexInputAttributeDescription, 7> GetAttributeDescriptions()
 		{
-			std::array<VkVertexInputAttributeDescription, 6> attributeDescriptions{};
+			std::array<VkVertexInputAttributeDescription, 7> attributeDescriptions{};
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(ShapeVertex, pos);
+			attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(ShapeInstance, center);
 
 			attributeDescriptions[1].binding = 0;
 			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(ShapeVertex, colour);
+			attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(ShapeInstance, axisX);
 
 			attributeDescriptions[2].binding = 0;
 			attributeDescriptions[2].location = 2;
 			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-			attributeDescriptions[2].offset = offsetof(ShapeVertex, localPos);
+			attributeDescriptions[2].offset = offsetof(ShapeInstance, axisY);
 
 			attributeDescriptions[3].binding = 0;
 			attributeDescriptions[3].location = 3;
-			attributeDescriptions[3].format = VK_FORMAT_R32_SFLOAT;
-			attributeDescriptions[3].offset = offsetof(ShapeVertex, circleThickness);
+			attributeDescriptions[3].format = VK_FORMAT_R16_SNORM;
+			attributeDescriptions[3].offset = offsetof(ShapeInstance, depth);
 
 			attributeDescriptions[4].binding = 0;
 			attributeDescriptions[4].location = 4;
-			attributeDescriptions[4].format = VK_FORMAT_R32_SFLOAT;
-			attributeDescriptions[4].offset = offsetof(ShapeVertex, circleFade);
+			attributeDescriptions[4].format = VK_FORMAT_R16_UINT;
+			attributeDescriptions[4].offset = offsetof(ShapeInstance, shapeType);
 
 			attributeDescriptions[5].binding = 0;
 			attributeDescriptions[5].location = 5;
-			attributeDescriptions[5].format = VK_FORMAT_R32_SFLOAT;
-			attributeDescriptions[5].offset = offsetof(ShapeVertex, shapeType);
+			attributeDescriptions[5].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[5].offset = offsetof(ShapeInstance, colour);
 
-			return attributeDescriptions;
-		}
+			attributeDescriptions[6].binding = 0;
+			attributeDescriptions[6].location = 6;
+			attributeDescriptions[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[6].offset = offsetof(ShapeInstance, params);
 
-		bool operator==(const ShapeVertex& other) const
-		{
-			return pos == other.pos && colour == other.colour;
+			return attributeDescriptions;
 		}
 	};
 
-	struct ShapeUniformBufferObject
+	// Pushed with every draw
+	struct ShapePushConstants
 	{
 		Mat4 pv;
 	};
@@ -1,18 +1,26 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "IPipeline.h"
+#include "VertexPacking.h"
 
 #define ROW_MAJOR
 #include "../../Math/ZMath.h"
 
+// Baked draws a baked pipeline's descriptor pool has view sets for, in each frame in flight
+#define MAX_BAKED_SPRITE_DRAWS 256
+
 namespace ZVK
 {
+	// 20 bytes
 	struct SpriteVertex
 	{
-		Vec3 pos;
-		Vec4 colour;
-		Vec2 texCoord;
-		int texIndex;
+		Vec2 pos;
+		int16_t depth; // See PackDepth
+		uint16_t texIndex; // The sprite's slot in the texture registry
+		uint16_t texCoord[2]; // See PackUnorm16
+		uint32_t colour; // See PackColour
 
 		static VkVertexInputBindingDescription GetBindingDescription()
 		{
@@ -25,9 +33,9 @@ namespace ZVK
 			return bindingDescription;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+		static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions()
 		{
-			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+			std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
 
 			/* Formats:
 			* float: VK_FORMAT_R32_SFLOAT
@@ -38,47 +46,132 @@ namespace ZVK
 			* ivec2: VK_FORMAT_R32G32_SINT
 			* uvec4: VK_FORMAT_R32G32B32A32_UINT
 			* double: VK_FORMAT_R64_SFLOAT
+			*
+			* Normalized formats are read as floats
 			*/
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
 			attributeDescriptions[0].offset = offsetof(SpriteVertex, pos);
 
 			attributeDescriptions[1].binding = 0;
 			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
 			attributeDescriptions[1].offset = offsetof(SpriteVertex, colour);
 
 			attributeDescriptions[2].binding = 0;
 			attributeDescriptions[2].location = 2;
-			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_UNORM;
 			attributeDescriptions[2].offset = offsetof(SpriteVertex, texCoord);
 
 			attributeDescriptions[3].binding = 0;
 			attributeDescriptions[3].location = 3;
-			attributeDescriptions[3].format = VK_FORMAT_R32_SINT;
+			attributeDescriptions[3].format = VK_FORMAT_R16_UINT;
 			attributeDescriptions[3].offset = offsetof(SpriteVertex, texIndex);
 
+			attributeDescriptions[4].binding = 0;
+			attributeDescriptions[4].location = 4;
+			attributeDescriptions[4].format = VK_FORMAT_R16_SNORM;
+			attributeDescriptions[4].offset = offsetof(SpriteVertex, depth);
+
 			return attributeDescriptions;
 		}
 
 		bool operator==(const SpriteVertex& other) const
 		{
-			return pos == other.pos && colour == other.colour && texCoord == other.texCoord;
+			return pos == other.pos && depth == other.depth && texIndex == other.texIndex &&
+				texCoord[0] == other.texCoord[0] && texCoord[1] == other.texCoord[1] && colour == other.colour;
+		}
+	};
+
+	// One record per sprite, the vertex shader expands it into a quad. 36 bytes
+	struct SpriteInstance
+	{
+		Vec2 center; // The sprite rotates around it
+		int16_t depth; // See PackDepth, already includes the sprite's depth
+		uint16_t texIndex;
+		Vec2 size; // Already scaled
+		float rotation; // Rotation around the z axis
+		uint16_t uvInfo[4]; // Same layout as Sprite::GetUVInfo(), see PackUnorm16
+		uint32_t colour; // See PackColour
+
+		static VkVertexInputBindingDescription GetBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(SpriteInstance);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 7> GetAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 7> attributeDescriptions{};
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(SpriteInstance, center);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(SpriteInstance, size);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16_SNORM;
+			attributeDescriptions[2].offset = offsetof(SpriteInstance, depth);
+
+			attributeDescriptions[3].binding = 0;
+			attributeDescriptions[3].location = 3;
+			attributeDescriptions[3].format = VK_FORMAT_R32_SFLOAT;
+			attributeDescriptions[3].offset = offsetof(SpriteInstance, rotation);
+
+			attributeDescriptions[4].binding = 0;
+			attributeDescriptions[4].location = 4;
+			attributeDescriptions[4].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[4].offset = offsetof(SpriteInstance, uvInfo);
+
+			attributeDescriptions[5].binding = 0;
+			attributeDescriptions[5].location = 5;
+			attributeDescriptions[5].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[5].offset = offsetof(SpriteInstance, colour);
+
+			attributeDescriptions[6].binding = 0;
+			attributeDescriptions[6].location = 6;
+			attributeDescriptions[6].format = VK_FORMAT_R16_UINT;
+			attributeDescriptions[6].offset = offsetof(SpriteInstance, texIndex);
+
+			return attributeDescriptions;
 		}
 	};
 
-	struct UniformBufferObject
+	// Pushed with every draw
+	struct SpritePushConstants
 	{
 		Mat4 pv;
 	};
 
+	enum class SpriteVertexLayout
+	{
+		PER_VERTEX = 0, // SpriteVertex, 4 vertices per sprite
+		INSTANCED  = 1, // SpriteInstance, 1 instance per sprite
+
+		// SpriteVertex, the view projection is read from a uniform buffer at set 0 binding 0 instead
+		// of being pushed, so a recorded draw doesn't have to be recorded again when the camera moves
+		BAKED      = 2
+	};
+
 	class SpritePipeline : public IPipeline
 	{
 	public:
 		SpritePipeline(const std::string& vertPath, const std::string& fragPath,
-			PipelineConfigInfo* configInfo = nullptr);
+			PipelineConfigInfo* configInfo = nullptr,
+			SpriteVertexLayout vertexLayout = SpriteVertexLayout::PER_VERTEX);
 		~SpritePipeline() override;
 
 		SpritePipeline(const SpritePipeline&) = delete;
@@ -86,8 +179,13 @@ namespace ZVK
 		SpritePipeline& operator=(const SpritePipeline&) = delete;
 		SpritePipeline& operator=(SpritePipeline&&) = delete;
 
+		inline SpriteVertexLayout GetVertexLayout() const { return m_vertexLayout; }
+
 		void createGraphicsPipeline() override;
 		void createDescriptorSetLayout() override;
 		void createDescriptorPool() override;
+
+	private:
+		SpriteVertexLayout m_vertexLayout;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+#define ROW_MAJOR
+#include "../../Math/ZMath.h"
+
+namespace ZVK
+{
+	// The sprite and shape vertex formats are packed, these convert to the packed values
+
+	// snorm16, the camera's projection only keeps depths from -1 to 1
+	inline int16_t PackDepth(float z)
+	{
+		return (int16_t)lroundf(std::min(std::max(z, -1.f), 1.f) * 32767.f);
+	}
+
+	inline float UnpackDepth(int16_t depth) { return std::max((float)depth / 32767.f, -1.f); }
+
+	// unorm16, UVs outside of 0 to 1 are clamped
+	inline uint16_t PackUnorm16(float value)
+	{
+		return (uint16_t)lroundf(std::min(std::max(value, 0.f), 1.f) * 65535.f);
+	}
+
+	// RGBA8 with red in the lowest byte, the memory order of VK_FORMAT_R8G8B8A8_UNORM
+	inline uint32_t PackColour(const Vec4& colour)
+	{
+		auto toByte = [](float value)
+		{ return (uint32_t)lroundf(std::min(std::max(value, 0.f), 1.f) * 255.f); };
+
+		return toByte(colour.x) | (toByte(colour.y) << 8) | (toByte(colour.z) << 16) | (toByte(colour.w) << 24);
+	}
+}
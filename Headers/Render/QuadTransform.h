@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "DrawableObject.h"
+
+// Quads transformed per QuadCornerBatch, a multiple of 8 so the AVX path never needs a tail
+#define QUAD_BATCH_SIZE 64
+
+namespace ZVK
+{
+	// Structure of arrays for up to QUAD_BATCH_SIZE quads. Each corner is
+	// (Centre + (A * cornerX + B * cornerY + E, C * cornerX + D * cornerY + F))
+	// where the corner is +- half width and +- half height
+	struct QuadCornerBatch
+	{
+		alignas(32) float CentreX[QUAD_BATCH_SIZE];
+		alignas(32) float CentreY[QUAD_BATCH_SIZE];
+		alignas(32) float HalfWidth[QUAD_BATCH_SIZE];
+		alignas(32) float HalfHeight[QUAD_BATCH_SIZE];
+
+		alignas(32) float A[QUAD_BATCH_SIZE];
+		alignas(32) float B[QUAD_BATCH_SIZE];
+		alignas(32) float C[QUAD_BATCH_SIZE];
+		alignas(32) float D[QUAD_BATCH_SIZE];
+		alignas(32) float E[QUAD_BATCH_SIZE];
+		alignas(32) float F[QUAD_BATCH_SIZE];
+
+		// 4 corners a quad in top right, top left, bottom left, bottom right order
+		alignas(32) float CornerX[QUAD_BATCH_SIZE * 4];
+		alignas(32) float CornerY[QUAD_BATCH_SIZE * 4];
+
+		uint32_t Count = 0;
+	};
+
+	// Adds the object's quad to the batch, the batch must not be full.
+	// Sin and cos are only computed once and only when the object is rotated around z,
+	// objects that are only scaled (like a -1 flip) don't need any trig or matrices
+	void AddQuad(QuadCornerBatch& batch, const IDrawableObject& object);
+
+	// Same as above for a quad that's only rotated around z, for sprites that aren't objects
+	void AddQuad(QuadCornerBatch& batch, float x, float y, float width, float height,
+		float rotationZ, float scaleX, float scaleY);
+
+	// Uses AVX or SSE when the compiler targets them, otherwise the scalar version
+	void TransformQuadCorners(QuadCornerBatch& batch);
+	void TransformQuadCornersScalar(QuadCornerBatch& batch);
+
+	// World space axis aligned bounds of quads, kept as columns so they can be tested 8 at a time
+	struct QuadBounds
+	{
+		std::vector<float> MinX;
+		std::vector<float> MinY;
+		std::vector<float> MaxX;
+		std::vector<float> MaxY;
+
+		// New entries are empty
+		void Resize(size_t count);
+		void Clear();
+
+		// The bounds of the object's quad after it's scaled and rotated
+		void Set(uint32_t index, const IDrawableObject& object);
+
+		// Empty bounds never overlap anything
+		void SetEmpty(uint32_t index);
+	};
+
+	// pVisible[i] is set to 1 if quad i overlaps the rect and 0 if it's entirely outside of it.
+	// The rect is (min x, min y, max x, max y), returns the amount of visible quads
+	uint32_t CullQuadBounds(const QuadBounds& bounds, uint32_t count, const Vec4& visibleRect, uint8_t* pVisible);
+	uint32_t CullQuadBoundsScalar(const QuadBounds& bounds, uint32_t first, uint32_t count,
+		const Vec4& visibleRect, uint8_t* pVisible);
+}
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <memory>
 #include <vector>
+#include <functional>
 
 #include <array>
 
@@ -12,6 +14,12 @@
 #include <vulkan/vulkan.h>
 
 #include "Swapchain.h"
+#include "RingBuffer.h"
+#include "CommandEncoder.h"
+#include "DrawPacket.h"
+#include "SortKey.h"
+#include "../Core/ThreadPool.h"
+#include "../Core/Timer.h"
 #include "../Events/Events.h"
 
 #include "../Math/Vectors/Vector4.h"
@@ -20,18 +28,73 @@
 #define MAX_FRAMES_IN_FLIGHT 2
 #endif
 
+// Size of each frame's region in the dynamic vertex buffer, it grows if a frame needs more
+#define DEFAULT_DYNAMIC_VERTEX_BUFFER_SIZE (4 * 1024 * 1024)
+
+// Quads the shared quad index buffer can index when it's created, it grows if a draw needs more
+#define DEFAULT_QUAD_INDEX_CAPACITY 16384
+
+// With 4 vertices a quad this is the most quads 16 bit indices can reach
+#define MAX_UINT16_QUAD_COUNT 16384
+
+// Draw packets a recording thread gets at the least, fewer packets are recorded on fewer threads
+#define MIN_RECORDED_DRAW_PACKET_COUNT 32
+
 namespace ZVK
 {
-	class RenderCmd
+	// The time between the last two calls to Begin and how much of it Begin spent waiting
+	// for the GPU to be done with the frame's resources
+	struct FrameStats
+	{
+		int64_t FrameMicroseconds = 0;
+		int64_t FenceWaitMicroseconds = 0;
+	};
+
+	// Frames that submitted the command buffers recorded for an earlier frame again and frames that were recorded
+	struct RecordCacheStats
+	{
+		uint64_t HitCount = 0;
+		uint64_t RecordCount = 0;
+	};
+
+	// FNV-1a over everything a frame records, frames with the same hash record the same commands.
+	// Hashes 8 bytes a step since a frame's draw packets are hashed every frame
+	class RecordHash
 	{
 	public:
-		virtual void Execute() = 0;
+		void Add(const void* pData, size_t size)
+		{
+			const uint8_t* pBytes = (const uint8_t*)pData;
+			size_t i = 0;
+
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+			{
+				uint64_t word;
+				memcpy(&word, pBytes + i, sizeof(uint64_t));
+
+				m_hash = (m_hash ^ word) * 1099511628211ull;
+			}
+
+			for (; i < size; ++i)
+				m_hash = (m_hash ^ pBytes[i]) * 1099511628211ull;
+		}
+
+		template<typename T>
+		void Add(const T& value) { Add(&value, sizeof(T)); }
+
+		inline uint64_t Get() const { return m_hash; }
+
+	private:
+		uint64_t m_hash = 14695981039346656037ull;
 	};
 
 	class Renderer
 	{
 	public:
-		Renderer();
+		// Render systems split their vertex generation across workerThreadCount threads,
+		// 0 generates every vertex on the thread that draws
+		Renderer(VkDeviceSize dynamicVertexBufferSize = DEFAULT_DYNAMIC_VERTEX_BUFFER_SIZE,
+			uint32_t workerThreadCount = ThreadPool::GetDefaultThreadCount());
 		~Renderer();
 		Renderer(const Renderer&) = delete;
 		Renderer& operator=(const Renderer&) = delete;
@@ -39,11 +102,77 @@ namespace ZVK
 		void Begin();
 		void End();
 		
-		inline VkCommandBuffer& GetCurrentCommandBuffer() { return m_cmdBuffers[m_curFrame]; }
+		// The current frame's primary command buffer, draw packets are recorded into secondary ones
+		inline VkCommandBuffer& GetCurrentCommandBuffer() { return m_recordTargets[m_curTarget].CmdBuffer; }
 		inline uint32_t GetImageIndex() const { return m_imageIndex; }
 		inline uint32_t GetCurFrame() const { return m_curFrame; }
 		inline VkFence& GetCurrentFence() { return m_renderFences[m_curFrame]; }
 
+		// Headless only. Copies the last frame ended into pixels, width * height RGBA texels a row at a time
+		// in the swapchain's format. Waits for the GPU so it's meant for checks and captures, not every frame
+		void ReadPixels(std::vector<uint8_t>& pixels);
+
+		// The binds issued and skipped by every encoder that recorded the last frame
+		inline const EncoderStats& GetEncoderStats() const { return m_encoderStats; }
+
+		inline const FrameStats& GetFrameStats() const { return m_frameStats; }
+
+		// Counted since the renderer was created
+		inline const RecordCacheStats& GetRecordCacheStats() const { return m_recordCacheStats; }
+
+		// Vertices that change every frame are written here, the memory is only valid for the current frame
+		inline RingBuffer* GetDynamicVertexBuffer() const { return p_dynamicVertexBuffer.get(); }
+
+		inline ThreadPool* GetWorkerPool() const { return p_workerPool.get(); }
+
+		// Should only be called outside of Begin and End
+		void SetWorkerThreadCount(uint32_t workerThreadCount);
+
+		// Copies the data into a device local buffer before this frame's render pass starts.
+		// The data is staged in the dynamic vertex buffer so pData doesn't need to outlive the call.
+		// Should only be called from update vertex functions, ranges uploaded in the same frame can't overlap
+		void UploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+
+		// Destroys the buffer once the frames that might still be using it are done,
+		// the command buffers kept for later frames are recorded again
+		void DestroyBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory);
+
+		// Packets are only kept for the frame they're added in and are recorded in the order of their keys.
+		// Should only be called from update vertex functions
+		inline void AddDrawPacket(const DrawPacket& packet) { m_drawPackets.push_back(packet); }
+
+		// Records the packet's binds and draw, EXECUTE packets have to be executed by whoever records them
+		static void RecordDrawPacket(CommandEncoder& encoder, const DrawPacket& packet);
+
+		// Gives the packet the index buffer shared by every quad batch, quad i uses the vertices i * 4 to i * 4 + 3.
+		// 16 bit indices are used when quadCount fits in them. Should only be called from update vertex functions
+		void SetQuadIndexBuffer(DrawPacket& packet, uint32_t quadCount);
+
+		// Gives the packet 32 bit indices for this frame that draw the quads in the order given,
+		// pQuadOrder[i] is the quad drawn i-th. The indices are written to the dynamic vertex buffer
+		// so the packet is transient
+		void SetQuadIndices(DrawPacket& packet, const uint32_t* pQuadOrder, uint32_t quadCount);
+
+		// Changes when the shared quad index buffer grows, command buffers that bound the old one have to be recorded again
+		inline VkBuffer GetQuadIndexBuffer() const { return m_quadIndexBuffer; }
+
+		// Allocated from the core's command pool, free it with FreeCommandBuffer.
+		// The core's pool isn't thread safe so these are recorded on the main thread, in update vertex functions
+		VkCommandBuffer AllocateSecondaryCommandBuffer();
+
+		// Frees the command buffer once the frames that might still be using it are done,
+		// the command buffers kept for later frames are recorded again
+		void FreeCommandBuffer(VkCommandBuffer cmdBuffer);
+
+		// The command buffers kept for later frames are recorded again, needed when a command buffer
+		// they execute is recorded again
+		inline void InvalidateRecordCache() { m_isRecordCacheStale = true; }
+
+		// Begins a secondary command buffer that continues the swapchain's render pass.
+		// Reusable ones don't know the framebuffer so they can be executed with any swapchain image,
+		// and are begun with simultaneous use since more than one record target can execute them
+		void BeginSecondaryCommandBuffer(VkCommandBuffer cmdBuffer, bool isReusable);
+
 		inline Vec4 GetClearColour() const { return m_clearColour; }
 		inline void SetClearColour(Vec4 colour) { m_clearColour = colour; }
 		inline void SetClearColour(float r, float g, float b, float a = 1.0) { m_clearColour = { r,g,b,a }; };
@@ -55,48 +184,169 @@ namespace ZVK
 			m_clearColour.w = (float)a / 255.f;
 		}
 
-		// This should only be called in render systems
-		void AddRenderCmd(RenderCmd* cmd) { m_renderCmds.push_back(cmd); }
+		// Update vertex functions are called once a frame before the render pass is started,
+		// they upload through the renderer and add the frame's draw packets
+		using UpdateVertexFnc = std::function<void()>;
 
-		// This should only be called in render systems
-		void AddUpdateVertexCmd(RenderCmd* cmd) { m_updateVertexCmds.push_back(cmd); }
+		// This should only be called in render systems, returns the ID RemoveUpdateVertexFnc takes
+		uint32_t AddUpdateVertexFnc(UpdateVertexFnc fnc)
+		{
+			if (m_freeUpdateVertexFncIDs.empty())
+			{
+				m_updateVertexFncs.push_back(std::move(fnc));
+				return (uint32_t)m_updateVertexFncs.size() - 1;
+			}
 
-		void RemoveRenderCmd(RenderCmd* cmd)
-		{ m_renderCmds.erase(std::find(m_renderCmds.begin(), m_renderCmds.end(), cmd)); }
+			uint32_t id = m_freeUpdateVertexFncIDs.back();
+			m_freeUpdateVertexFncIDs.pop_back();
 
-		void RemoveUpdateVertexCmd(RenderCmd* cmd) 
-		{
-			m_updateVertexCmds.erase(std::find(m_updateVertexCmds.begin(), 
-				m_updateVertexCmds.end(), cmd));
+			m_updateVertexFncs[id] = std::move(fnc);
+			return id;
 		}
 
-		void ClearRenderCmds() { m_renderCmds.clear(); }
+		// The function's slot is emptied and given to the next function that's added
+		void RemoveUpdateVertexFnc(uint32_t id)
+		{
+			m_updateVertexFncs[id] = nullptr;
+			m_freeUpdateVertexFncIDs.push_back(id);
+		}
 
 	private:
+		// Resets and begins the current target's command buffers, only called when the frame has to be recorded
 		void beginFlush();
 		void endFlush();
 
-		void createCommandBuffers();
+		// Sorts m_packetOrder by the draw packets' keys
+		void sortDrawPackets();
+
+		// False when something in the frame only lives for the frame, a frame like that is never submitted again
+		bool hashRecordState(uint64_t& stateHash) const;
+
+		void recordUploads();
+		void destroyBuffers(uint32_t frameIndex);
+
+		// Records the draw packets m_packetOrder[firstPacket] to m_packetOrder[endPacket - 1] with the slot
+		void recordDrawPackets(uint32_t slotIndex, uint32_t firstPacket, uint32_t endPacket);
+
+		// Draw packets are recorded into secondary command buffers so recorded ones
+		// can be executed in between them
+		void beginSlotCmdBuffer(uint32_t slotIndex);
+		void endSlotCmdBuffer(uint32_t slotIndex);
+
+		// There is a slot for every thread of the worker pool and the calling thread, slots are never removed
+		void createRecordSlots(uint32_t slotCount);
+
+		// Targets are only added when the swapchain gets more images than before
+		void createRecordTargets(uint32_t imageCount);
+
+		// Makes sure every slot has a command pool for every target
+		void createRecordPools();
+
+		void createQuadIndexBuffer(uint32_t quadCapacity);
+
 		void createSyncObjects();
 
 		void windowCloseEvent(WindowClosedEvent& e);
+		void swapchainRecreateEvent(SwapchainRecreateEvent& e);
+
+	private:
+		struct BufferUpload
+		{
+			VkBuffer SrcBuffer;
+			VkBuffer DstBuffer;
+			VkBufferCopy Region;
+		};
+
+		// What was recorded for one swapchain image in one frame index. The target is only used again once
+		// its frame index's fence was waited on, so a frame recording the same can submit it as it is
+		struct RecordTarget
+		{
+			VkCommandBuffer CmdBuffer = VK_NULL_HANDLE; // The primary one
+			uint64_t StateHash = 0;
+			bool IsCached = false; // Nothing it recorded only lived for its frame
+		};
+
+		// Each thread recording the render pass has its own command pool for every target,
+		// so the threads never touch the same pool and a target's pool is reset at once
+		struct RecordSlot
+		{
+			std::vector<VkCommandPool> CmdPools;
+			std::vector<std::vector<VkCommandBuffer>> CmdBuffers;
+			uint32_t CmdBufferCount = 0; // Used by the current frame
+
+			CommandEncoder Encoder;
+
+			// The slot's secondary command buffers in the order they're executed, the ones
+			// of EXECUTE packets are in between the slot's own
+			std::vector<VkCommandBuffer> ExecutedCmdBuffers;
+		};
 
 	private:
 		uint32_t m_imageIndex;
-		uint32_t m_curFrame;
+		uint32_t m_curFrame = 0;
 		Vec4 m_clearColour;
 
 		bool m_isFrameBufferResized;
 
-		std::vector<VkCommandBuffer> m_cmdBuffers;
+		// ReadPixels has nothing to copy before the first frame is submitted
+		bool m_isFrameSubmitted = false;
+
+		// Target image * MAX_FRAMES_IN_FLIGHT + frame is used by that swapchain image in that frame index
+		std::vector<RecordTarget> m_recordTargets;
+		uint32_t m_curTarget = 0;
+
+		RecordCacheStats m_recordCacheStats;
+
+		// Set when something the kept command buffers might use is destroyed, they're all recorded again
+		bool m_isRecordCacheStale = false;
+
+		EncoderStats m_encoderStats;
+
+		Timer m_frameTimer;
+		Timer m_fenceWaitTimer;
+		FrameStats m_frameStats;
+
+		// Slot i records the i-th range of the sorted draw packets
+		std::vector<RecordSlot> m_recordSlots;
+
+		// The secondary command buffers of this frame's render pass in the order they're executed
+		std::vector<VkCommandBuffer> m_executedCmdBuffers;
+
+		std::unique_ptr<RingBuffer> p_dynamicVertexBuffer;
+		std::unique_ptr<ThreadPool> p_workerPool;
+
+		std::vector<BufferUpload> m_uploads;
+
+		// The 16 bit indices are at the start of the buffer, the 32 bit ones are only
+		// created once the capacity is over MAX_UINT16_QUAD_COUNT
+		VkBuffer m_quadIndexBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory m_quadIndexMemory = VK_NULL_HANDLE;
+		VkDeviceSize m_quadIndexUint32Offset = 0;
+		uint32_t m_quadIndexCapacity = 0;
+
+		// Buffers destroyed during a frame, they are freed the next time that frame index begins
+		// and its fence has been waited on
+		std::array<std::vector<std::pair<VkBuffer, VkDeviceMemory>>, MAX_FRAMES_IN_FLIGHT> m_destroyedBuffers;
+		std::array<std::vector<VkCommandBuffer>, MAX_FRAMES_IN_FLIGHT> m_freedCmdBuffers;
 
 		std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_availableSemaphores;
 		std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_finishedSemaphores;
 		std::array<VkFence, MAX_FRAMES_IN_FLIGHT> m_renderFences;
 
-		std::vector<RenderCmd*> m_renderCmds;
-		std::vector<RenderCmd*> m_updateVertexCmds;
+		// Indexed by the IDs AddUpdateVertexFnc returns, removed functions are empty
+		std::vector<UpdateVertexFnc> m_updateVertexFncs;
+		std::vector<uint32_t> m_freeUpdateVertexFncIDs;
+
+		// This frame's packets, cleared before the update vertex functions add the next frame's.
+		// The vectors keep their capacity so steady frames don't allocate
+		std::vector<DrawPacket> m_drawPackets;
+
+		// Indices into m_drawPackets in the order they are recorded
+		std::vector<uint32_t> m_packetOrder;
+		std::vector<uint64_t> m_packetSortKeys;
+		RadixSorter m_packetSorter;
 
 		std::function<void(WindowClosedEvent&)> m_windowCloseEvent;
+		std::function<void(SwapchainRecreateEvent&)> m_swapchainRecreateEvent;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vulkan/vulkan.h>
+
+#ifndef MAX_FRAMES_IN_FLIGHT
+#define MAX_FRAMES_IN_FLIGHT 2
+#endif
+
+namespace ZVK
+{
+	struct RingAllocation
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		void* pData = nullptr; // Mapped pointer to the start of the allocation
+	};
+
+	// A host visible buffer that stays mapped and is split into one region per frame in flight.
+	// Each frame allocates linearly from its own region so we never write into memory
+	// a previous frame might still be reading from
+	class RingBuffer
+	{
+	public:
+		RingBuffer(VkDeviceSize regionSize, VkBufferUsageFlags usage);
+		~RingBuffer();
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer(RingBuffer&&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+		RingBuffer& operator=(RingBuffer&&) = delete;
+
+		// Must be called once a frame after the frame's fence has been waited on
+		void BeginFrame(uint32_t frameIndex);
+
+		// Grows the buffer if the region is full, allocations made before growing stay valid
+		RingAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		inline VkBuffer GetBuffer() const { return m_buffer; }
+		inline VkDeviceSize GetRegionSize() const { return m_regionSize; }
+		inline VkDeviceSize GetUsedSize() const { return m_head; }
+
+	private:
+		void createBuffer(VkDeviceSize regionSize);
+		void grow(VkDeviceSize minRegionSize);
+
+	private:
+		struct RetiredBuffer
+		{
+			VkBuffer Buffer;
+			VkDeviceMemory Memory;
+			uint32_t FramesLeft;
+		};
+
+		VkBuffer m_buffer = VK_NULL_HANDLE;
+		VkDeviceMemory m_memory = VK_NULL_HANDLE;
+		void* p_mapped = nullptr;
+
+		VkBufferUsageFlags m_usage;
+
+		VkDeviceSize m_regionSize;
+		VkDeviceSize m_head = 0;
+		uint32_t m_frameIndex = 0;
+
+		// Buffers we grew out of, they are destroyed once the frames using them are done
+		std::vector<RetiredBuffer> m_retiredBuffers;
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace ZVK
+{
+	enum class BlendMode
+	{
+		CUTOUT      = 0, // Relies on the depth test, fully transparent texels are discarded
+		TRANSLUCENT = 1  // Drawn back to front after the cutout draws of its layer
+	};
+
+	/* Bits of a draw's sort key, lower keys are drawn first
+	* layer:        63 - 56
+	* translucent:  55
+	*
+	* Cutout draws are grouped by state and rely on the depth test. Every batch has its own state
+	* so there's nothing left for depth to order and it isn't part of the key:
+	* pipeline:     54 - 48
+	* state:        47 - 32 (batch, texture, ...)
+	* unused:       31 - 0
+	*
+	* Translucent draws have to be back to front so depth comes before the state:
+	* depth:        54 - 23 (inverted)
+	* pipeline:     22 - 16
+	* state:        15 - 0
+	*/
+
+	// Maps a float to a uint32_t that sorts in the same order
+	inline uint32_t DepthToSortBits(float depth)
+	{
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+
+		return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+	}
+
+	// Larger depths are further away with the camera's projection, depth is only used by translucent draws
+	inline uint64_t MakeSortKey(uint8_t layer, BlendMode blendMode, uint32_t pipelineID,
+		uint32_t stateID, float depth)
+	{
+		uint64_t key = (uint64_t)layer << 56;
+
+		if (blendMode == BlendMode::CUTOUT)
+		{
+			key |= (uint64_t)(pipelineID & 0x7F) << 48;
+			key |= (uint64_t)(stateID & 0xFFFF) << 32;
+		}
+		else
+		{
+			uint64_t depthBits = DepthToSortBits(depth);
+
+			key |= 1ull << 55;
+			key |= (~depthBits & 0xFFFFFFFFull) << 23;
+			key |= (uint64_t)(pipelineID & 0x7F) << 16;
+			key |= (uint64_t)(stateID & 0xFFFF);
+		}
+
+		return key;
+	}
+
+	// LSD radix sort of 64 bit keys, 8 bits a pass. The values are sorted along with their keys
+	// and equal keys keep their order. Keys that were already sorted, usually the case when
+	// the values are kept in last frame's order, cost one pass over them. Passes where every key
+	// has the same byte are skipped so keys that only differ in a few bits stay cheap
+	class RadixSorter
+	{
+	public:
+		// Returns false if the keys were already sorted
+		bool Sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values);
+
+		inline uint32_t GetSortedPassCount() const { return m_sortedPassCount; }
+
+	private:
+		std::vector<uint64_t> m_keyScratch;
+		std::vector<uint32_t> m_valueScratch;
+
+		uint32_t m_sortedPassCount = 0; // Passes the last sort needed
+	};
+}
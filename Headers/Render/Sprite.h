@@ -75,7 +75,7 @@ namespace ZVK
 		void SetSubWidth(uint32_t width);
 		void SetSubHeight(uint32_t height);
 
-		inline void SetTexture(std::shared_ptr<Texture2D> texture) { p_texture = texture; }
+		inline void SetTexture(std::shared_ptr<Texture2D> texture) { p_texture = texture; ++m_version; }
 
 		inline bool operator==(const Sprite& rhs) { return this == &rhs; }
 
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "Texture2D.h"
+
+#define ROW_MAJOR
+#include "../Math/ZMath.h"
+
+// The low bits of a handle are the sprite's index in the pool, the rest are its generation
+#define SPRITE_HANDLE_INDEX_BITS 20
+#define SPRITE_HANDLE_INDEX_MASK ((1u << SPRITE_HANDLE_INDEX_BITS) - 1)
+#define SPRITE_HANDLE_GENERATION_MASK ((1u << (32 - SPRITE_HANDLE_INDEX_BITS)) - 1)
+
+// The most sprites a pool can hold at once
+#define MAX_SPRITE_POOL_SIZE SPRITE_HANDLE_INDEX_MASK
+
+#define INVALID_SPRITE_HANDLE UINT32_MAX
+
+// Sprites without a texture, they're drawn with the renderer's error texture
+#define INVALID_TEXTURE_SLOT UINT32_MAX
+
+namespace ZVK
+{
+	// Refers to one sprite in a SpritePool. The generation changes when a sprite is destroyed
+	// so handles to it stop working even after its index is reused
+	typedef uint32_t SpriteHandle;
+
+	// Sprites stored as columns instead of objects, each property is contiguous so code that
+	// updates every sprite and the renderer that streams them only touch the memory they need.
+	// Sprites are packed, destroying one moves the last sprite into its place so its index
+	// changes but its handle doesn't. Only rotation around the z axis is supported
+	class SpritePool
+	{
+	public:
+		SpritePool() = default;
+
+		SpritePool(const SpritePool&) = delete;
+		SpritePool& operator=(const SpritePool&) = delete;
+
+		SpriteHandle Create(Vec2 pos, Vec2 dimensions, const std::shared_ptr<Texture2D>& texture = nullptr,
+			Vec4 colour = { 1.f, 1.f, 1.f, 1.f }, float z = 0.f);
+
+		void Destroy(SpriteHandle handle);
+		void Clear();
+
+		void Reserve(uint32_t count);
+
+		bool IsAlive(SpriteHandle handle) const;
+
+		inline uint32_t GetCount() const { return (uint32_t)m_handles.size(); }
+
+		// The sprite's index into the columns, only valid until a sprite is destroyed
+		inline uint32_t GetIndex(SpriteHandle handle) const
+		{ return m_indices[handle & SPRITE_HANDLE_INDEX_MASK]; }
+
+		inline Vec2 GetPos(SpriteHandle handle) const
+		{ uint32_t i = GetIndex(handle); return { m_posX[i], m_posY[i] }; }
+		inline float GetZ(SpriteHandle handle) const { return m_z[GetIndex(handle)]; }
+		inline Vec2 GetDimensions(SpriteHandle handle) const
+		{ uint32_t i = GetIndex(handle); return { m_width[i], m_height[i] }; }
+		inline float GetRotation(SpriteHandle handle) const { return m_rotation[GetIndex(handle)]; }
+		inline Vec2 GetScale(SpriteHandle handle) const
+		{ uint32_t i = GetIndex(handle); return { m_scaleX[i], m_scaleY[i] }; }
+		inline Vec4 GetColour(SpriteHandle handle) const { return m_colours[GetIndex(handle)]; }
+		inline Vec4 GetUVInfo(SpriteHandle handle) const { return m_uvInfos[GetIndex(handle)]; }
+		inline std::shared_ptr<Texture2D> GetTexture(SpriteHandle handle) const
+		{ return m_textures[GetIndex(handle)]; }
+
+		// The handles must be alive
+		inline void SetPos(SpriteHandle handle, Vec2 pos)
+		{ uint32_t i = GetIndex(handle); m_posX[i] = pos.x; m_posY[i] = pos.y; }
+		inline void SetZ(SpriteHandle handle, float z) { m_z[GetIndex(handle)] = z; }
+		inline void SetDimensions(SpriteHandle handle, Vec2 dimensions)
+		{ uint32_t i = GetIndex(handle); m_width[i] = dimensions.x; m_height[i] = dimensions.y; }
+		inline void SetRotation(SpriteHandle handle, float rotation)
+		{ m_rotation[GetIndex(handle)] = rotation; }
+		inline void SetScale(SpriteHandle handle, Vec2 scale)
+		{ uint32_t i = GetIndex(handle); m_scaleX[i] = scale.x; m_scaleY[i] = scale.y; }
+		inline void SetColour(SpriteHandle handle, Vec4 colour) { m_colours[GetIndex(handle)] = colour; }
+
+		// (right u, bottom v, left u, top v) like Sprite::GetUVInfo
+		inline void SetUVInfo(SpriteHandle handle, Vec4 uvInfo) { m_uvInfos[GetIndex(handle)] = uvInfo; }
+
+		// Uses the part of the texture at subPos, the texture has to be set first
+		void SetSubRect(SpriteHandle handle, Vec2ui subPos, Vec2ui subDimensions);
+
+		// Registers the texture with the texture registry
+		void SetTexture(SpriteHandle handle, const std::shared_ptr<Texture2D>& texture);
+
+		// Bulk setters, pHandles and the values are count long
+		void SetPositions(const SpriteHandle* pHandles, const Vec2* pPositions, uint32_t count);
+		void SetRotations(const SpriteHandle* pHandles, const float* pRotations, uint32_t count);
+		void SetScales(const SpriteHandle* pHandles, const Vec2* pScales, uint32_t count);
+		void SetColours(const SpriteHandle* pHandles, const Vec4* pColours, uint32_t count);
+
+		// Moves every sprite
+		void Translate(Vec2 offset);
+
+		// The columns are GetCount() long and indexed by GetIndex, writing to them directly
+		// is the fastest way to update most of the pool. Pointers are invalidated by Create
+		inline float* GetPosXData() { return m_posX.data(); }
+		inline float* GetPosYData() { return m_posY.data(); }
+		inline float* GetRotationData() { return m_rotation.data(); }
+		inline Vec4* GetColourData() { return m_colours.data(); }
+
+		inline const float* GetPosXData() const { return m_posX.data(); }
+		inline const float* GetPosYData() const { return m_posY.data(); }
+		inline const float* GetZData() const { return m_z.data(); }
+		inline const float* GetWidthData() const { return m_width.data(); }
+		inline const float* GetHeightData() const { return m_height.data(); }
+		inline const float* GetRotationData() const { return m_rotation.data(); }
+		inline const float* GetScaleXData() const { return m_scaleX.data(); }
+		inline const float* GetScaleYData() const { return m_scaleY.data(); }
+		inline const Vec4* GetColourData() const { return m_colours.data(); }
+		inline const Vec4* GetUVInfoData() const { return m_uvInfos.data(); }
+
+		// INVALID_TEXTURE_SLOT for sprites without a texture
+		inline const uint32_t* GetTextureSlotData() const { return m_textureSlots.data(); }
+
+	private:
+		// Indexed by the handle's index, the sprite's index into the columns
+		std::vector<uint32_t> m_indices;
+		std::vector<uint32_t> m_generations;
+		std::vector<uint32_t> m_freeHandleIndices;
+
+		// The columns, indexed by the sprite's index
+		std::vector<SpriteHandle> m_handles;
+
+		std::vector<float> m_posX;
+		std::vector<float> m_posY;
+		std::vector<float> m_z;
+		std::vector<float> m_width;
+		std::vector<float> m_height;
+		std::vector<float> m_rotation;
+		std::vector<float> m_scaleX;
+		std::vector<float> m_scaleY;
+		std::vector<Vec4> m_colours;
+		std::vector<Vec4> m_uvInfos;
+		std::vector<uint32_t> m_textureSlots;
+
+		// Only read when a texture is set, keeps the textures and their registry slots alive
+		std::vector<std::shared_ptr<Texture2D>> m_textures;
+	};
+}
@@ -30,6 +30,10 @@ namespace ZVK
 
 		void Create();
 
+		// Renders into one offscreen image of the given size instead of a surface's images.
+		// The image can be copied from once a frame's render pass ends
+		void CreateOffscreen(VkExtent2D extent);
+
 		void CreateSwapchain();
 		void CreateImageViews();
 		void CreateFrameBuffers();
@@ -63,8 +67,12 @@ namespace ZVK
 		inline void SwapchainRecreatedFinished() { m_isSwapchainRecreated = false; }
 
 		inline const bool IsFrameBufferResized() const { return m_isFrameBufferResized; }
+
+		inline const bool IsOffscreen() const { return m_isOffscreen; }
 	private:
 
+		void createOffscreenImage();
+
 		SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device);
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
@@ -74,7 +82,7 @@ namespace ZVK
 
 	private:
 		
-		VkSwapchainKHR m_swapchain;
+		VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
 
 		VkFormat m_swapchainImageFormat;
 		VkExtent2D m_swapchainExtent;
@@ -94,8 +102,11 @@ namespace ZVK
 		VkDeviceMemory m_depthImageMemory;
 		VkImageView m_depthImageView;
 
+		VkDeviceMemory m_offscreenImageMemory = VK_NULL_HANDLE;
+
 		bool m_isSwapchainRecreated = false;
 		bool m_isFrameBufferResized = false;
+		bool m_isOffscreen = false;
 
 		std::function<void(FrameBufferResizedEvent&)> m_frameBufferResizeEvent;
 		
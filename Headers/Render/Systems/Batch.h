@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#define INVALID_BATCH_ID UINT32_MAX
+#define INVALID_BATCH_SLOT UINT32_MAX
+
+namespace ZVK
+{
+	typedef uint32_t BatchID;
+
+	// Refers to one object in a batch, it stays valid until the object is removed
+	struct BatchHandle
+	{
+		BatchID Batch = INVALID_BATCH_ID;
+		uint32_t Slot = INVALID_BATCH_SLOT;
+
+		inline bool IsValid() const { return Batch != INVALID_BATCH_ID && Slot != INVALID_BATCH_SLOT; }
+	};
+
+	// Objects tested against the camera's visible rect and how many of them were entirely outside of it
+	struct CullStats
+	{
+		uint32_t TestedCount = 0;
+		uint32_t CulledCount = 0;
+
+		inline uint32_t GetVisibleCount() const { return TestedCount - CulledCount; }
+	};
+
+	// Quads (shapes, sprites or line pieces) drawn in immediate mode and the draws they took
+	struct ImmediateStats
+	{
+		uint32_t QuadCount = 0;
+		uint32_t DrawCount = 0;
+	};
+
+	// Hands out slots in a batch, freed slots are reused before the batch grows
+	class SlotAllocator
+	{
+	public:
+		uint32_t Allocate()
+		{
+			if (m_freeSlots.empty())
+				return m_slotCount++;
+
+			uint32_t slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+
+			return slot;
+		}
+
+		inline void Free(uint32_t slot) { m_freeSlots.push_back(slot); }
+
+		inline void Clear() { m_freeSlots.clear(); m_slotCount = 0; }
+
+		// Highest slot handed out + 1, freed slots below it are still counted
+		inline uint32_t GetSlotCount() const { return m_slotCount; }
+		inline uint32_t GetUsedCount() const { return m_slotCount - (uint32_t)m_freeSlots.size(); }
+
+	private:
+		std::vector<uint32_t> m_freeSlots;
+		uint32_t m_slotCount = 0;
+	};
+}
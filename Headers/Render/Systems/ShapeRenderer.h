@@ -8,9 +8,15 @@
 #include "../Pipelines/ShapePipeline.h"
 
 #include "../../Shapes/IShapes.h"
+#include "../../Shapes/Line.h"
 
 #include "../Camera.h"
+#include "../QuadTransform.h"
+#include "../ImmediateDrawList.h"
 
+#include "Batch.h"
+
+#include <algorithm>
 #include <array>
 
 #include <unordered_map>
@@ -20,12 +26,6 @@ namespace ZVK
 	class ShapeRenderer
 	{
 	private:
-		class Cmd
-		{
-		public:
-			virtual void Execute() = 0;
-		};
-
 		struct ListInfo
 		{
 		public:
@@ -38,11 +38,9 @@ namespace ZVK
 			bool IsListAdded;
 		};
 
-		struct ShapeData;
 		struct RenderData;
-		class UpdateVerticesCmd; // For updating vertices
-		friend class ShapeRendererCmd;
-		friend class UploadUpdatedShapeVerticesCmd; // For uploading updated vertices
+		struct ShapeBatch;
+		struct BatchDraw;
 
 	public:
 		ShapeRenderer(Renderer& renderer, ShapePipeline* pPipeline);
@@ -57,12 +55,87 @@ namespace ZVK
 		~ShapeRenderer();
 
 		// mvp = model * view * projection
+		// Each list gets its own batch, changing the size of the list rebuilds only that batch.
+		// List batches are cutout batches like CreateBatch's so they're drawn by pipeline and batch,
+		// not in the order Draw is called in. Lists that blend with what's under them have to be
+		// made translucent, see GetListBatch
 		void Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Mat4& mvp,
 			const bool canUpdateVertexBuffer = true);
 
+		// Culls the list with the camera's visible rect
 		void Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Camera& cam,
 			const bool canUpdateVertexBuffer = true);
 
+		// The list's batch, it's created and filled like Draw would if the list wasn't drawn yet.
+		// Lets the batch's layer and blend mode be set, they're kept when the list changes size
+		BatchID GetListBatch(std::vector<std::shared_ptr<IShape>>& shapes, const bool canUpdateVertexBuffer = true);
+
+		// A batch keeps its shapes on the GPU, adding, removing or updating a shape only
+		// uploads that shape's instance. Batches that can update their vertex buffer
+		// also rebuild every shape whose version changed when they are drawn
+		BatchID CreateBatch(const bool canUpdateVertexBuffer = true);
+		void DestroyBatch(BatchID batch);
+
+		// Removes every shape but keeps the batch's buffers
+		void ClearBatch(BatchID batch);
+
+		BatchHandle AddShape(BatchID batch, const std::shared_ptr<IShape>& shape);
+		void RemoveShape(BatchHandle handle);
+
+		// Rebuilds the shape's instance, only needed when the batch can't update its vertex buffer
+		void UpdateShape(BatchHandle handle);
+
+		// Draws the batch this frame with the mvp, viewport and scissor rect, and updates the shapes that changed.
+		// Every call is drawn, so a batch can be drawn more than once a frame with different cameras
+		void DrawBatch(BatchID batch, const Mat4& mvp);
+
+		// Shapes entirely outside of visibleRect (see Camera::GetVisibleRect) aren't drawn,
+		// a changed shape's instance isn't rebuilt until it's visible again
+		void DrawBatch(BatchID batch, const Mat4& mvp, const Vec4& visibleRect);
+
+		// Culls with the camera's visible rect
+		void DrawBatch(BatchID batch, const Camera& cam);
+
+		// Totals of last frame's culled DrawBatch and Draw calls
+		inline const CullStats& GetCullStats() const { return m_cullStats; }
+
+		uint32_t GetBatchSize(BatchID batch) const;
+
+		// Immediate mode, everything below only lasts for the frame it's drawn in so it should be drawn between
+		// Renderer::Begin and End. The instances are written straight into the dynamic vertex buffer, batched
+		// when the frame's draw packets are added and nothing is kept afterwards
+
+		// pos is the bottom left corner, the quad rotates around its center
+		void DrawQuad(const Vec3& pos, const Vec2& size, const Vec4& colour, const Mat4& mvp, float rotation = 0.f);
+
+		// Thickness and fade work like Circle's
+		void DrawCircle(const Vec3& center, float radius, const Vec4& colour, const Mat4& mvp,
+			float thickness = 1.f, float fade = 0.005f);
+
+		void DrawLine(const Vec3& start, const Vec3& end, float thickness, const Vec4& colour, const Mat4& mvp,
+			LineCap cap = LineCap::BUTT);
+
+		// Every point is at z. A closed polyline joins its last point back to the first one and has no caps.
+		// Later pieces are nudged towards the camera so they cover the anti aliased edges of the earlier ones,
+		// translucent colours come out darker where the pieces overlap
+		void DrawPolyline(const Vec2* pPoints, uint32_t pointCount, float z, float thickness, const Vec4& colour,
+			const Mat4& mvp, LineJoin join = LineJoin::MITER, LineCap cap = LineCap::BUTT, bool isClosed = false);
+
+		// rect = x, y, width, height like Camera::GetVisibleRect, handy for bounding boxes
+		void DrawRectOutline(const Vec4& rect, float z, float thickness, const Vec4& colour, const Mat4& mvp);
+
+		// Immediate draws are cutout draws of this layer, see SetBatchLayer
+		void SetImmediateLayer(uint8_t layer);
+
+		// Last frame's immediate quads, lines and circles
+		inline const ImmediateStats& GetImmediateStats() const { return m_immediateStats; }
+
+		// Batches are drawn by layer, lowest first. Translucent batches are drawn after the cutout
+		// batches of their layer, back to front, and their shapes are sorted back to front every frame
+		void SetBatchLayer(BatchID batch, uint8_t layer);
+		void SetBatchBlendMode(BatchID batch, BlendMode blendMode);
+
+		// Draw calls use the viewport and scissor rect that are set when they're made
 		inline void SetViewport(Vec4 viewportInfo) { m_viewportInfo = viewportInfo; }
 		void SetViewport(float x, float y, float width, float height)
 		{
@@ -90,26 +163,46 @@ namespace ZVK
 	private:
 		void init();
 
-		void allocateDescriptorInfo();
-		void updateDescriptorWrites();
-		void createDescriptorPool();
+		// Adds this frame's draw packets to the renderer, called once everything is uploaded
+		void queueDraws();
+		void queueBatch(const BatchDraw& batchDraw);
+		void queueImmediate();
+
+		// The view projection with the current viewport and scissor rect
+		DrawView makeView(const Mat4& viewProjection) const;
+
+		// Viewport, scissor, pipeline, view projection and the instanced quad draw,
+		// shared by batches and immediate draws
+		void setDrawState(DrawPacket& packet, const DrawView& view) const;
+
+		// Returns the list's batch, a list with a new size is added to its batch again
+		BatchID loadList(std::vector<std::shared_ptr<IShape>>& shapes, const bool canUpdateVertexBuffer);
 
-		// Used when we go over max quad count
-		void drawRecursive(std::vector<std::shared_ptr<IShape>>& shapes, bool canUpdateVertexBuffer);
+		// pVisibleRect is null when the batch isn't culled
+		void drawBatch(BatchID batchID, const Mat4& mvp, const Vec4* pVisibleRect);
 
-		void draw(uint32_t indexCount, uint32_t renderDataIndex, uint32_t shapeDataIndex);
+		// Drops the batch's draws of this frame, its slots are about to change
+		void removeBatchDraws(BatchID batchID);
 
-		void populateVertices(std::vector<std::shared_ptr<IShape>>& shapes, uint32_t renderDataIndex,
-			uint32_t shapeDataIndex);
+		void populateInstance(ShapeBatch& batch, uint32_t slot);
 
-		void createBuffer(uint32_t renderDataIndex);
+		// Writes the instances and versions of the slots.
+		// Only reads the shapes so it's safe to call from worker threads with different slots
+		void buildInstances(ShapeBatch& batch, const uint32_t* pSlots, uint32_t count) const;
 
-		void updateUBO(const Mat4& cam);
-		void updateBuffer(uint32_t renderDataIndex);
+		// Recreates the instance buffer with at least twice the capacity
+		void growRenderData(RenderData& rData, uint32_t instanceCount);
 
-		void updateVertices(std::vector<std::shared_ptr<IShape>>& shapes, uint32_t renderDataIndex);
+		// Uploads the dirty slots of every batch, close slots are merged into one copy.
+		// Also sorts the translucent batches, updates the batches' sort keys and adds the frame's packets
+		void uploadBatches();
 
-		void createUniformBuffer();
+		// Sorts RenderData::DrawOrder back to front, starting from last frame's order
+		void sortQuads(ShapeBatch& batch);
+
+		// Copies the instances in DrawOrder to the sorted buffer, only uploads them when the order or an instance changed
+		void uploadSortedInstances(RenderData& rData);
+		void updateSortKey(BatchID batchID);
 
 		void swapchainRecreateEvent(SwapchainRecreateEvent& e);
 
@@ -117,127 +210,109 @@ namespace ZVK
 		Renderer& m_renderer;
 		ShapePipeline* p_pipeline;
 
-		VkBuffer m_uniformBuffer;
+		std::vector<ShapeBatch> m_batches;
+		std::vector<BatchID> m_freeBatchIDs;
+
+		// This frame's DrawBatch calls in the order they were made, cleared once their packets are added
+		std::vector<BatchDraw> m_batchDraws;
+		std::vector<uint32_t> m_visibleSlots; // The culled draws' slots, see BatchDraw
+
+		uint32_t m_uploadFncID; // See Renderer::AddUpdateVertexFnc
 
-		VkDeviceMemory m_uniformMemory;
+		// This frame's immediate instances, cleared once their packets are added
+		ImmediateDrawList m_immediateShapes;
+		ImmediateStats m_immediateStats; // Last frame's
 
-		std::vector<RenderData> m_renderInfos;
+		uint8_t m_immediateLayer = 0;
+		uint64_t m_immediateSortKey = 0;
 
-		std::vector<ShapeRendererCmd*> m_shapeRendererCmds;
-		std::vector<UploadUpdatedShapeVerticesCmd*> m_uploadUpdatedVerticesCmds; // Uploading updated vertices
-		std::vector<std::shared_ptr<UpdateVerticesCmd>> m_updateVerticesCmds; // Change values in the vertices
+		// Slots DrawBatch rebuilds, kept around so it doesn't allocate every frame
+		std::vector<uint32_t> m_changedSlots;
+
+		RadixSorter m_depthSorter;
+		std::vector<uint64_t> m_depthKeys;
+
+		CullStats m_cullStats; // Last frame's
+		CullStats m_frameCullStats;
 		
+		// ListInfo::Index is the list's batch
 		std::unordered_map<std::vector<std::shared_ptr<IShape>>*, ListInfo> m_loadedLists;
-		uint32_t m_listCount = 0;
-		int32_t changedListIndex = -1;
 
-		bool m_uboCreated = false;
-		bool m_descriptorInfoCreated = false;
 		bool m_canDeletePipeline = false;
 		bool m_swapchainRecreated = false;
 
-		VkDescriptorPool m_descriptorPool;
-		
-		VkDescriptorSet m_descriptorSet;
-
 		std::function<void(SwapchainRecreateEvent&)> m_swapchainRecreateEvent;
 
 		Vec4 m_viewportInfo;
 		Vec2i m_scissorOffset = { 0,0 };
 		VkExtent2D m_scissorExtent;
 
-		const Vec3 m_tR{  0.5f,  0.5f, 0.f };
-		const Vec3 m_tL{ -0.5 ,  0.5f, 0.f };
-		const Vec3 m_bL{ -0.5f, -0.5f, 0.f };
-		const Vec3 m_bR{  0.5f, -0.5f, 0.f };
-
 	private:
-		struct ShapeData
+		// The instances of a batch, one per slot. The buffer is recreated with twice the capacity when it's outgrown
+		struct RenderData
 		{
 		public:
-			std::vector<ShapeVertex> Vertices;
-			std::vector<uint32_t> Indices;
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VkDeviceMemory BufferMemory = VK_NULL_HANDLE;
 
-			size_t StartVertex = 0;
-			size_t StartIndex = 0;
+			uint32_t InstanceCapacity = 0; // Instances the buffer can hold
 
-			bool canUpdateVertices = false;
+			// Indexed by slot, freed slots are zeroed so they don't draw anything
+			std::vector<ShapeInstance> Instances;
 
-			size_t SizeOfVerticesInBytes()
-			{ return sizeof(ShapeVertex) * Vertices.size(); }
-			
-			size_t SizeOfIndicesInBytes()
-			{ return sizeof(uint32_t) * Indices.size(); }
+			uint32_t InstanceCount = 0; // Highest slot used + 1
 
-			size_t SizeInBytes()
-			{ return SizeOfVerticesInBytes() + SizeOfIndicesInBytes(); }
-		};
+			// Slots that changed since the last upload, can hold duplicates
+			std::vector<uint32_t> DirtySlots;
 
-		struct RenderData
-		{
-		public:
-			VkBuffer Buffer;
-			VkDeviceMemory BufferMemory;
-			
-			std::vector<ShapeData> ShapeInfos;
-			std::vector<std::shared_ptr<IShape>> Shapes;
+			bool IsBufferRecreated = false; // Every slot has to be uploaded to the new buffer
 
-			uint32_t ShapeCount = 0;
-			uint32_t TotalVerticeSize = 0;
+			// Translucent batches only, the slots back to front
+			std::vector<uint32_t> DrawOrder;
 
-			bool IsBufferCreated = false;
+			// Translucent batches only, the instances in DrawOrder as they were last uploaded to the sorted buffer.
+			// Drawing from it instead of streaming the sorted instances keeps the batch's packet the same every frame
+			VkBuffer SortedBuffer = VK_NULL_HANDLE;
+			VkDeviceMemory SortedBufferMemory = VK_NULL_HANDLE;
+			uint32_t SortedCapacity = 0;
+			std::vector<ShapeInstance> SortedInstances;
+
+			inline void MarkDirty(uint32_t slot) { DirtySlots.push_back(slot); }
 		};
-		
-		// For updating vertices
-		class UpdateVerticesCmd : public Cmd
+
+		struct ShapeBatch
 		{
 		public:
-			UpdateVerticesCmd(ShapeRenderer& parent, std::vector<std::shared_ptr<IShape>>& shapes,
-				uint32_t renderDataIndex)
-				: m_parent(parent), m_shapes(shapes), m_renderDataIndex(renderDataIndex)
-			{}
+			std::vector<std::shared_ptr<IShape>> Shapes; // Indexed by slot, null for freed slots
+			std::vector<uint32_t> Versions; // The shape's version when its instance was last built
+			RenderData RenderInfo;
+			uint64_t SortKey = 0; // From updateSortKey, given to the batch's packet
 
-			void Execute() override { m_parent.updateVertices(m_shapes, m_renderDataIndex); }
+			QuadBounds Bounds; // Indexed by slot, freed slots are empty
+			std::vector<uint32_t> BoundsVersions; // The shape's version when its bounds were last computed
+			std::vector<uint8_t> Visible; // Indexed by slot, scratch for culling
 
-		private:
-			ShapeRenderer& m_parent;
+			SlotAllocator Slots;
 
-			std::vector<std::shared_ptr<IShape>>& m_shapes;
-			uint32_t m_renderDataIndex;
-		};
-	};
+			uint8_t Layer = 0;
+			BlendMode Blend = BlendMode::CUTOUT;
 
-	class ShapeRendererCmd : public RenderCmd
-	{
-	public:
-		ShapeRendererCmd(ShapeRenderer* pShapeRenderer, uint32_t indexCount, 
-			uint32_t renderDataIndex, uint32_t shapeDataIndex) :
-			p_shapeRenderer(pShapeRenderer), m_indexCount(indexCount), 
-			m_renderDataIndex(renderDataIndex), m_shapeDataIndex(shapeDataIndex)
-		{ }
-
-		void Execute() override { p_shapeRenderer->draw(m_indexCount, 
-			m_renderDataIndex, m_shapeDataIndex); }
-		
-	private:
-		ShapeRenderer* p_shapeRenderer;
-		uint32_t m_indexCount;
-		uint32_t m_renderDataIndex;
-		uint32_t m_shapeDataIndex;
-	};
-
-	// For uploading new vertices
-	class UploadUpdatedShapeVerticesCmd : public RenderCmd
-	{
-	public:
-		UploadUpdatedShapeVerticesCmd(ShapeRenderer* pShapeRenderer, uint32_t renderDataIndex) 
-			: p_shapeRenderer(pShapeRenderer), m_renderDataIndex(renderDataIndex)
-		{ }
-
-		void Execute() override { p_shapeRenderer->updateBuffer(m_renderDataIndex); }
+			bool CanUpdateVertices = false;
+			bool IsAlive = false;
+		};
 
-	private:
-		ShapeRenderer* p_shapeRenderer;
-		uint32_t m_renderDataIndex;
+		// One DrawBatch call
+		struct BatchDraw
+		{
+		public:
+			BatchID Batch;
+			DrawView View;
+
+			// The slots that passed culling are m_visibleSlots[FirstVisibleSlot, FirstVisibleSlot + VisibleSlotCount),
+			// back to front for translucent batches
+			uint32_t FirstVisibleSlot = 0;
+			uint32_t VisibleSlotCount = 0;
+			bool IsCulled = false;
+		};
 	};
-}
+}
\ No newline at end of file
@@ -4,11 +4,17 @@
 
 #include "../Renderer.h"
 #include "../Sprite.h"
+#include "../SpritePool.h"
 
 #include "../Pipelines/SpritePipeline.h"
 
 #include "../Camera.h"
+#include "../QuadTransform.h"
+#include "../ImmediateDrawList.h"
 
+#include "Batch.h"
+
+#include <algorithm>
 #include <array>
 #include <tuple>
 
@@ -17,12 +23,6 @@ namespace ZVK
 	class SpriteRenderer
 	{
 	private:
-		class Cmd
-		{
-		public:
-			virtual void Execute() = 0;
-		};
-
 		struct ListInfo
 		{
 		public:
@@ -35,12 +35,12 @@ namespace ZVK
 			bool IsListAdded;
 		};
 
-		struct SpriteData;
 		struct RenderData;
-		struct TextureData;
-		class UpdateVerticesCmd; // For updating vertices
-		friend class SpriteRendererCmd;
-		friend class UploadUpdatedSpriteVerticesCmd; // For uploading updated vertices
+		struct SpriteBatch;
+		struct BakedDraw;
+		struct BatchDraw;
+		struct InstanceData;
+		struct PoolDraw;
 
 	public:
 		SpriteRenderer(Renderer& renderer, SpritePipeline* pPipeline, const std::string& errorTexturePath);
@@ -56,12 +56,98 @@ namespace ZVK
 		~SpriteRenderer();
 
 		// mvp = model * view * projection
+		// Each list gets its own batch, changing the size of the list rebuilds only that batch.
+		// List batches are cutout batches like CreateBatch's so they're drawn by pipeline and batch,
+		// not in the order Draw is called in. Lists that blend with what's under them have to be
+		// made translucent, see GetListBatch
 		void Draw(std::vector<std::shared_ptr<Sprite>>& sprites, const Mat4& mvp,
 			const bool canUpdateVertexBuffer = true);
 
+		// Culls the list with the camera's visible rect
 		void Draw(std::vector<std::shared_ptr<Sprite>>& sprites, const Camera& cam,
 			const bool canUpdateVertexBuffer = true);
 
+		// The list's batch, it's created and filled like Draw would if the list wasn't drawn yet.
+		// Lets the batch's layer and blend mode be set, they're kept when the list changes size
+		BatchID GetListBatch(std::vector<std::shared_ptr<Sprite>>& sprites, const bool canUpdateVertexBuffer = true);
+
+		// A batch keeps its sprites on the GPU, adding, removing or updating a sprite only
+		// uploads that sprite's vertices. Batches that can update their vertex buffer
+		// also rebuild every sprite whose version changed when they are drawn
+		BatchID CreateBatch(const bool canUpdateVertexBuffer = true);
+		void DestroyBatch(BatchID batch);
+
+		// Removes every sprite but keeps the batch's buffers
+		void ClearBatch(BatchID batch);
+
+		BatchHandle AddSprite(BatchID batch, const std::shared_ptr<Sprite>& sprite);
+		void RemoveSprite(BatchHandle handle);
+
+		// Rebuilds the sprite's vertices, only needed when the batch can't update its vertex buffer
+		void UpdateSprite(BatchHandle handle);
+
+		// Turns the batch into a static layer. Its vertices are uploaded once into a buffer that only fits
+		// its sprites, then the batch lets go of its sprites and vertices and is drawn with a recorded
+		// command buffer. A baked batch can't be changed, clearing it turns it back into a normal batch.
+		// The view projection is read from a uniform buffer so moving the camera doesn't record it again.
+		// Lists drawn with canUpdateVertexBuffer = false are baked once they're added
+		void BakeBatch(BatchID batch);
+
+		// Draws the batch this frame with the mvp, viewport and scissor rect, and updates the sprites that changed.
+		// Every call is drawn, so a batch can be drawn more than once a frame with different cameras
+		void DrawBatch(BatchID batch, const Mat4& mvp);
+
+		// Sprites entirely outside of visibleRect (see Camera::GetVisibleRect) aren't drawn,
+		// a changed sprite's vertices aren't rebuilt until it's visible again
+		void DrawBatch(BatchID batch, const Mat4& mvp, const Vec4& visibleRect);
+
+		// Culls with the camera's visible rect
+		void DrawBatch(BatchID batch, const Camera& cam);
+
+		// Totals of last frame's culled DrawBatch and Draw calls
+		inline const CullStats& GetCullStats() const { return m_cullStats; }
+
+		uint32_t GetBatchSize(BatchID batch) const;
+
+		// Batches are drawn by layer, lowest first. Translucent batches are drawn after the cutout
+		// batches of their layer, back to front, and their sprites are sorted back to front every frame
+		void SetBatchLayer(BatchID batch, uint8_t layer);
+		void SetBatchBlendMode(BatchID batch, BlendMode blendMode);
+
+		// Sends one SpriteInstance per sprite instead of 4 vertices and 6 indices,
+		// the quad is built in the vertex shader. Only rotation around the z axis is used.
+		// Like DrawBatch every call is drawn with its own camera and viewport
+		void DrawInstanced(std::vector<std::shared_ptr<Sprite>>& sprites, const Mat4& pv,
+			const bool canUpdateInstanceBuffer = true);
+
+		void DrawInstanced(std::vector<std::shared_ptr<Sprite>>& sprites, const Camera& cam,
+			const bool canUpdateInstanceBuffer = true);
+
+		// The pipeline has to be created with SpriteVertexLayout::INSTANCED
+		void SetInstancedPipeline(SpritePipeline* pPipeline);
+
+		// The pipeline has to be created with SpriteVertexLayout::BAKED
+		void SetBakedPipeline(SpritePipeline* pPipeline);
+
+		// Streams the pool's columns straight into this frame's vertices, nothing is kept between frames
+		// so a pool that changes every frame costs the same as one that doesn't. Pools are drawn
+		// like cutout batches and must stay at the same address for as long as they're drawn.
+		// The pool's vertices are streamed once a frame however many times it's drawn
+		void DrawPool(const SpritePool& pool, const Mat4& pv, uint8_t layer = 0);
+		void DrawPool(const SpritePool& pool, const Camera& cam, uint8_t layer = 0);
+
+		// Immediate mode, the sprite is only drawn this frame so it should be drawn between Renderer::Begin and End.
+		// Its quad is written straight into the dynamic vertex buffer and batched with the frame's other
+		// immediate sprites when the frame's draw packets are added, the sprite doesn't have to outlive the call
+		void DrawSprite(const Sprite& sprite, const Mat4& pv);
+
+		// Immediate sprites are cutout draws of this layer, see SetBatchLayer
+		void SetImmediateLayer(uint8_t layer);
+
+		// Last frame's immediate sprites
+		inline const ImmediateStats& GetImmediateStats() const { return m_immediateStats; }
+
+		// Draw calls use the viewport and scissor rect that are set when they're made
 		inline void SetViewport(Vec4 viewportInfo) { m_viewportInfo = viewportInfo; }
 		void SetViewport(float x, float y, float width, float height)
 		{
@@ -89,56 +175,159 @@ namespace ZVK
 	private:
 		void init(const std::string& errorTexturePat);
 
-		void drawRecursive(std::vector<std::shared_ptr<Sprite>>& sprites, 
-			bool canUpdateVertexBuffer);
+		// Adds this frame's draw packets to the renderer, called once everything is uploaded
+		void queueDraws();
+		void queueBatch(const BatchDraw& batchDraw);
+		void queueInstanced(uint32_t instanceDataIndex);
+		void queuePool(uint32_t poolDrawIndex);
+		void queueImmediate();
+
+		// Records the draw again if anything it bakes in changed. Called from uploadBatches
+		// since the command buffer comes from the core's command pool, which only the main thread records into
+		void updateBakedDraw(SpriteBatch& batch, const BatchDraw& batchDraw);
+		void recordBakedDraw(SpriteBatch& batch, BakedDraw& bakedDraw);
+
+		// Creates the baked pipeline and the buffer the baked draws' view projections are written to
+		void createBakedViews();
+
+		uint32_t allocateBakedView(uint32_t frame);
+
+		// The set of the frame's view slot, allocated and written the first time the slot is recorded with
+		VkDescriptorSet getBakedViewSet(uint32_t frame, uint32_t slot);
+
+		inline VkDeviceSize bakedViewOffset(uint32_t frame, uint32_t slot) const
+		{ return m_bakedViewStride * ((VkDeviceSize)MAX_BAKED_SPRITE_DRAWS * frame + slot); }
 
-		void draw(uint32_t indexCount, uint32_t renderDataIndex, uint32_t spriteDataIndex);
+		// The view projection with the current viewport and scissor rect
+		DrawView makeView(const Mat4& viewProjection) const;
+
+		// Viewport, scissor, pipeline, descriptor sets and view projection of a draw with the pipeline
+		void setBatchState(DrawPacket& packet, const IPipeline* pPipeline, const DrawView& view) const;
+
+		// Adds the packet once for every MAX_QUADS_PER_DRAW quads with the shared quad indices,
+		// it only needs its state and vertex buffer
+		void queueQuadChunks(DrawPacket packet, uint32_t quadCount);
+
+		// Returns the list's batch, a list with a new size is added to its batch again
+		BatchID loadList(std::vector<std::shared_ptr<Sprite>>& sprites, const bool canUpdateVertexBuffer);
+
+		// pVisibleRect is null when the batch isn't culled
+		void drawBatch(BatchID batchID, const Mat4& mvp, const Vec4* pVisibleRect);
+
+		// Drops the batch's draws of this frame, its slots are about to change
+		void removeBatchDraws(BatchID batchID);
 
 		void createTextureData(std::vector<std::shared_ptr<Sprite>>& sprites);
+		int registerTexture(const std::shared_ptr<Sprite>& sprite);
+
+		void populateVertices(SpriteBatch& batch, uint32_t slot);
 
-		void populateVertices(std::vector<std::shared_ptr<Sprite>>& sprites,
-			uint32_t renderDataIndex, uint32_t shapeDataIndex);
+		// Writes the vertices and versions of the slots, the sprites' textures must already be registered.
+		// Only reads the sprites so it's safe to call from worker threads with different slots
+		void buildQuads(SpriteBatch& batch, const uint32_t* pSlots, uint32_t count);
+
+		void populateInstances(std::vector<std::shared_ptr<Sprite>>& sprites,
+			uint32_t instanceDataIndex);
+
+		// Packs one sprite's quad from the quad-th corners of the batch
+		static void writeQuad(SpriteVertex* pQuad, const QuadCornerBatch& corners, uint32_t quad, float z,
+			const Vec4& colour, const Vec4& uvInfo, uint16_t texIndex);
+
+		// Writes the vertices of the pool's sprites in [first, first + count) to pVertices.
+		// Only reads the pool so it's safe to call from worker threads with different ranges
+		void buildPoolQuads(const SpritePool& pool, uint32_t first, uint32_t count, SpriteVertex* pVertices) const;
+
+		// Writes the vertices of the pools drawn this frame to the dynamic vertex buffer
+		void streamPools();
+
+		int findTextureSlot(const std::shared_ptr<Sprite>& sprite);
 
 		void allocateDescriptorInfo();
 		
-		void createBuffer(uint32_t renderDataIndex);
-		void createUniformBuffer();
+		// Recreates the vertex buffer with at least twice the capacity
+		void growRenderData(RenderData& rData, uint32_t quadCount);
+		void createInstanceBuffer(uint32_t instanceDataIndex);
 		
 		void updateDescriptorWrites();
-		void updateBuffer(uint32_t renderDataIndex);
-		void updateUBO(const Mat4& mvp);
 
-		void updateVertices(std::vector<std::shared_ptr<Sprite>>& sprites, 
-			uint32_t renderDataIndex);
+		// Uploads the dirty slots of every batch, close slots are merged into one copy.
+		// Also sorts the translucent batches, updates the batches' sort keys and adds the frame's packets
+		void uploadBatches();
+
+		// Moves the live quads of a baked batch into a buffer of their own, back to front
+		// for translucent batches, and frees the batch's CPU copies
+		void uploadBakedBatch(BatchID batchID);
+
+		// Sorts RenderData::DrawOrder back to front, starting from last frame's order
+		void sortQuads(SpriteBatch& batch);
+		void updateSortKey(BatchID batchID);
 
 		void swapchainRecreateEvent(SwapchainRecreateEvent& e);
 
 	private:
 		Renderer& m_renderer;
 		SpritePipeline* p_pipeline;
+		SpritePipeline* p_instancedPipeline = nullptr;
+		SpritePipeline* p_bakedPipeline = nullptr;
+
+		// The error texture's slot in the texture registry
+		uint32_t m_errorTextureSlot = 0;
+
+		std::vector<SpriteBatch> m_batches;
+		std::vector<BatchID> m_freeBatchIDs;
 
-		VkBuffer m_uniformBuffer;
-		VkDeviceMemory m_uniformMemory;
+		// This frame's DrawBatch calls in the order they were made, cleared once their packets are added
+		std::vector<BatchDraw> m_batchDraws;
+		std::vector<uint32_t> m_visibleSlots; // The culled draws' slots, see BatchDraw
 
-		std::vector<RenderData> m_renderInfos;
-		std::unique_ptr<TextureData> m_textureData;
+		uint32_t m_uploadFncID; // See Renderer::AddUpdateVertexFnc
 
-		std::vector<SpriteRendererCmd*> m_spriteRendererCmds;
-		std::vector<UploadUpdatedSpriteVerticesCmd*> m_uploadUpdatedVerticesCmds; // Uploading updated vertices
-		std::vector<std::shared_ptr<UpdateVerticesCmd>> m_updateVerticesCmds; // Change values in the vertices
+		// Slots DrawBatch rebuilds, kept around so it doesn't allocate every frame
+		std::vector<uint32_t> m_changedSlots;
 
+		RadixSorter m_depthSorter;
+		std::vector<uint64_t> m_depthKeys;
+
+		CullStats m_cullStats; // Last frame's
+		CullStats m_frameCullStats;
+
+		// ListInfo::Index is the list's batch
 		std::unordered_map<std::vector<std::shared_ptr<Sprite>>*, ListInfo> m_loadedLists;
-		uint32_t m_listCount = 0;
-		int32_t changedListIndex = -1;
+
+		std::vector<InstanceData> m_instanceInfos;
+		std::unordered_map<std::vector<std::shared_ptr<Sprite>>*, ListInfo> m_loadedInstancedLists;
+
+		// Each pool that was ever drawn keeps its draw, the map's values index m_poolDraws
+		std::vector<PoolDraw> m_poolDraws;
+		std::unordered_map<const SpritePool*, uint32_t> m_loadedPools;
+
+		// This frame's immediate quads, cleared once their packets are added
+		ImmediateDrawList m_immediateSprites;
+		ImmediateStats m_immediateStats; // Last frame's
+		uint8_t m_immediateLayer = 0;
+		uint64_t m_immediateSortKey = 0;
 
 		VkSampler m_sampler;
 		VkDescriptorImageInfo m_samplerImageInfo;
 
 		VkDescriptorSet m_descriptorSet;
 
+		// The baked draws' view projections, one region of MAX_BAKED_SPRITE_DRAWS slots per frame in flight.
+		// Mapped for the lifetime of the buffer, a slot is written every frame its draw is drawn
+		VkBuffer m_bakedViewBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory m_bakedViewMemory = VK_NULL_HANDLE;
+		void* p_bakedViews = nullptr;
+		VkDeviceSize m_bakedViewStride = 0; // A Mat4 rounded up to the device's uniform buffer offset alignment
+
+		// Indexed by frame, a slot's set points at the slot's view projection in that frame's region
+		std::array<SlotAllocator, MAX_FRAMES_IN_FLIGHT> m_bakedViewSlots;
+		std::array<std::vector<VkDescriptorSet>, MAX_FRAMES_IN_FLIGHT> m_bakedViewSets;
+
 		uint32_t m_mipLevels;
 
 		bool m_canDeletePipeline = true;
+		bool m_canDeleteInstancedPipeline = false;
+		bool m_canDeleteBakedPipeline = false;
 
 		std::shared_ptr<Texture2D> p_errorTexture;
 
@@ -149,108 +338,129 @@ namespace ZVK
 		VkExtent2D m_scissorExtent;
 
 	private:
-		struct SpriteData
+		// The vertices of a batch, the buffer is recreated with twice the capacity when it's outgrown
+		struct RenderData
 		{
+		public:
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VkDeviceMemory BufferMemory = VK_NULL_HANDLE;
+
+			uint32_t QuadCapacity = 0; // Quads the buffer can hold
+
+			// 4 per slot, freed slots are zeroed so they don't draw anything
 			std::vector<SpriteVertex> Vertices;
-			std::vector<uint32_t> Indices;
 
-			size_t StartVertex = 0;
-			size_t StartIndex = 0;
+			uint32_t QuadCount = 0; // Highest slot used + 1
 
-			bool CanUpdateVertices = false;
+			// Slots that changed since the last upload, can hold duplicates
+			std::vector<uint32_t> DirtySlots;
 
-			size_t SizeOfVerticesInBytes()
-			{
-				return sizeof(SpriteVertex) * Vertices.size();
-			}
+			bool IsBufferRecreated = false; // Every slot has to be uploaded to the new buffer
 
-			size_t SizeOfIndicesInBytes()
-			{
-				return sizeof(uint32_t) * Indices.size();
-			}
+			// Translucent batches only, the slots back to front
+			std::vector<uint32_t> DrawOrder;
 
-			size_t SizeInBytes()
-			{
-				return SizeOfVerticesInBytes() + SizeOfIndicesInBytes();
-			}
+			inline void MarkDirty(uint32_t slot) { DirtySlots.push_back(slot); }
 		};
 
-		struct RenderData
+		// A baked batch's draw. Each frame in flight has its own since a command buffer can't be
+		// recorded again while it's pending, and each draw of the batch in a frame has its own since
+		// they can use different views. It's only recorded again when something it uses changed
+		struct BakedDraw
 		{
 		public:
-			VkBuffer Buffer;
-			VkDeviceMemory BufferMemory;
+			VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
 
-			std::vector<SpriteData> SpriteInfos;
-			std::vector<std::shared_ptr<Sprite>> Sprites;
+			// What the commands were recorded with
+			VkPipeline Pipeline = VK_NULL_HANDLE;
+			VkDescriptorSet TextureSet = VK_NULL_HANDLE;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+			VkBuffer VertexBuffer = VK_NULL_HANDLE;
+			VkBuffer IndexBuffer = VK_NULL_HANDLE;
 
-			uint32_t SpriteCount = 0;
-			uint32_t TotalVerticeSize = 0;
+			VkViewport Viewport{};
+			VkRect2D Scissor{};
 
-			bool IsBufferCreated = false;
+			// The view projection isn't recorded, it's written to this slot of the frame's views every frame
+			uint32_t ViewSlot = INVALID_BATCH_SLOT;
 		};
 
-		struct TextureData
+		struct SpriteBatch
 		{
 		public:
+			std::vector<std::shared_ptr<Sprite>> Sprites; // Indexed by slot, null for freed slots
+			std::vector<uint32_t> Versions; // The sprite's version when its vertices were last built
+			RenderData RenderInfo;
+			uint64_t SortKey = 0; // From updateSortKey, given to the batch's packets
+
+			QuadBounds Bounds; // Indexed by slot, freed slots are empty
+			std::vector<uint32_t> BoundsVersions; // The sprite's version when its bounds were last computed
+			std::vector<uint8_t> Visible; // Indexed by slot, scratch for culling
+
+			SlotAllocator Slots;
 
-			std::vector<VkDescriptorImageInfo> DescriptorImageInfos;
-			std::vector<std::pair<uint32_t, uint32_t>> BindingInfos;
+			uint8_t Layer = 0;
+			BlendMode Blend = BlendMode::CUTOUT;
 
-			uint32_t TextureCount = 0;
+			// Baked batches only, indexed by frame then by the batch's draws that frame
+			std::array<std::vector<BakedDraw>, MAX_FRAMES_IN_FLIGHT> BakedDraws;
+			uint32_t FrameDrawCount = 0; // DrawBatch calls this frame
+			std::vector<std::shared_ptr<Texture2D>> BakedTextures; // Keeps the textures' slots in the registry
+
+			bool CanUpdateVertices = false;
+			bool IsAlive = false;
+			bool IsBaked = false;
+			bool IsBakeUploaded = false;
 		};
 
-		// For updating vertices
-		class UpdateVerticesCmd : public Cmd
+		// A pool's vertices for the current frame
+		struct PoolDraw
 		{
 		public:
-			UpdateVerticesCmd(SpriteRenderer& parent, std::vector<std::shared_ptr<Sprite>>& sprites,
-				uint32_t renderDataIndex)
-				: m_parent(parent), m_sprites(sprites), m_renderDataIndex(renderDataIndex)
-			{}
-
-			void Execute() override { m_parent.updateVertices(m_sprites, m_renderDataIndex);  }
+			const SpritePool* pPool = nullptr; // Only used in the frames it's drawn in
+			uint64_t SortKey = 0;
 
-		private:
-			SpriteRenderer& m_parent;
+			RingAllocation Vertices;
+			uint32_t QuadCount = 0;
 
-			std::vector<std::shared_ptr<Sprite>>& m_sprites;
-			uint32_t m_renderDataIndex;
+			std::vector<DrawView> Views; // This frame's DrawPool calls
 		};
-	};
 
-	class SpriteRendererCmd : public RenderCmd
-	{
-	public:
-		SpriteRendererCmd(SpriteRenderer* pSpriteRenderer, uint32_t indexCount,
-			uint32_t renderDataIndex, uint32_t spriteDataIndex) :
-			p_spriteRenderer(pSpriteRenderer), m_indexCount(indexCount),
-			m_renderDataIndex(renderDataIndex), m_spriteDataIndex(spriteDataIndex)
-		{ }
-
-		void Execute() override {
-			p_spriteRenderer->draw(m_indexCount, m_renderDataIndex, m_spriteDataIndex);
-		}
+		struct InstanceData
+		{
+		public:
+			VkBuffer Buffer;
+			VkDeviceMemory BufferMemory;
 
-	private:
-		SpriteRenderer* p_spriteRenderer;
-		uint32_t m_indexCount;
-		uint32_t m_renderDataIndex;
-		uint32_t m_spriteDataIndex;
-	};
+			std::vector<SpriteInstance> Instances;
 
-	// For uploading new vertices
-	class UploadUpdatedSpriteVerticesCmd : public RenderCmd
-	{
-	public:
-		UploadUpdatedSpriteVerticesCmd(SpriteRenderer* pSpriteRenderer, uint32_t renderDataIndex) 
-			: p_spriteRenderer(pSpriteRenderer), m_renderDataIndex(renderDataIndex)
-		{ }
+			uint32_t InstanceCapacity = 0; // Amount of instances the buffer can hold
 
-		void Execute() override { p_spriteRenderer->updateBuffer(m_renderDataIndex); }
+			std::vector<DrawView> Views; // This frame's DrawInstanced calls
 
-	private:
-		SpriteRenderer* p_spriteRenderer;
-		uint32_t m_renderDataIndex;
+			bool CanUpdateInstances = false;
+			bool IsBufferCreated = false;
+
+			size_t SizeInBytes() const
+			{
+				return sizeof(SpriteInstance) * Instances.size();
+			}
+		};
+
+		// One DrawBatch call
+		struct BatchDraw
+		{
+		public:
+			BatchID Batch;
+			DrawView View;
+
+			// The slots that passed culling are m_visibleSlots[FirstVisibleSlot, FirstVisibleSlot + VisibleSlotCount),
+			// back to front for translucent batches. Baked batches are never culled
+			uint32_t FirstVisibleSlot = 0;
+			uint32_t VisibleSlotCount = 0;
+			bool IsCulled = false;
+
+			uint32_t BakedDrawIndex = 0; // Into the frame's BakedDraws, the batch's draws so far this frame
+		};
 	};
-}
+}
\ No newline at end of file
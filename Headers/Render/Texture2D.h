@@ -49,6 +49,9 @@ namespace ZVK
 		inline void SetID(uint32_t id) { m_id = id; }
 	private:
 
+		// Reuses the ID of a destroyed texture so tables indexed by ID stay small
+		static uint32_t nextID();
+
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
 	private:
@@ -61,7 +64,7 @@ namespace ZVK
 		uint32_t m_mipLevels;
 
 		uint32_t m_id;
-		//static std::queue<uint32_t> s_freedIDs;
+		static std::queue<uint32_t> s_freedIDs;
 		static uint32_t s_idCounter;
 	};
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vulkan/vulkan.h>
+
+#define TEXTURE_REGISTRY_SET 1
+#define TEXTURE_REGISTRY_BINDING 0
+#define MIN_TEXTURE_REGISTRY_CAPACITY 64
+#define MAX_TEXTURE_REGISTRY_CAPACITY 16384
+
+namespace ZVK
+{
+	class Texture2D;
+
+	// Every texture the renderers draw with lives in one bindless array that's shared by the whole process.
+	// A texture keeps its slot until it's destroyed so registering one only writes that slot's descriptor,
+	// the set is update after bind so the write doesn't have to wait on frames that are still in flight
+	class TextureRegistry
+	{
+	public:
+		TextureRegistry();
+		~TextureRegistry();
+
+		TextureRegistry(const TextureRegistry&) = delete;
+		TextureRegistry(TextureRegistry&&) = delete;
+		TextureRegistry& operator=(const TextureRegistry&) = delete;
+		TextureRegistry& operator=(TextureRegistry&&) = delete;
+
+		// Returns the texture's slot, the first call for a texture writes its descriptor
+		uint32_t Register(const Texture2D& texture);
+
+		// Called by the texture's destructor, the slot is reused once the frames in flight are done with it
+		void Release(uint32_t textureID);
+
+		// Must be called once a frame after the frame's fence has been waited on
+		void BeginFrame();
+
+		// -1 if the texture isn't registered
+		inline int32_t FindSlot(uint32_t textureID) const
+		{ return textureID < (uint32_t)m_slotsByID.size() ? m_slotsByID[textureID] : -1; }
+
+		inline VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_descriptorSetLayout; }
+		inline const VkDescriptorSetLayout* GetDescriptorSetLayoutPtr() const { return &m_descriptorSetLayout; }
+
+		// Bound at TEXTURE_REGISTRY_SET by the sprite pipelines, changes when the registry grows
+		inline VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
+
+		inline uint32_t GetCapacity() const { return m_capacity; }
+		inline uint32_t GetMaxCapacity() const { return m_maxCapacity; }
+		inline uint32_t GetTextureCount() const { return m_textureCount; }
+
+	private:
+		void createDescriptorSetLayout();
+
+		// Moves the live slots into a new set with at least twice the capacity
+		void grow(uint32_t minCapacity);
+
+		// Writes the descriptors of the slots in [first, first + count)
+		void writeSlots(uint32_t first, uint32_t count);
+
+		uint32_t allocateSlot();
+
+	private:
+		struct RetiredPool
+		{
+			VkDescriptorPool Pool;
+			uint32_t FramesLeft;
+		};
+
+		struct ReleasedSlot
+		{
+			uint32_t Slot;
+			uint32_t FramesLeft;
+		};
+
+		VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+		uint32_t m_capacity = 0;
+		uint32_t m_maxCapacity = 0;
+
+		// Slots handed out so far, released slots below it are still counted
+		uint32_t m_slotCount = 0;
+		uint32_t m_textureCount = 0;
+
+		// Indexed by slot, the image view is null for slots nothing is using
+		std::vector<VkDescriptorImageInfo> m_imageInfos;
+
+		// Indexed by Texture2D::GetID(), -1 for textures that don't have a slot
+		std::vector<int32_t> m_slotsByID;
+
+		std::vector<uint32_t> m_freeSlots;
+
+		// Frames in flight might still sample a released slot, or still have the old set bound
+		std::vector<ReleasedSlot> m_releasedSlots;
+		std::vector<RetiredPool> m_retiredPools;
+	};
+}
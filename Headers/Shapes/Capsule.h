@@ -0,0 +1,29 @@
+#pragma once
+
+#include "IShapes.h"
+
+namespace ZVK
+{
+	// Rounded at both ends of the longer side
+	class Capsule : public IShape
+	{
+	public:
+		Capsule(Vec3 pos, Vec3 dimensions, Vec4 colour = Vec4::One())
+			: IShape(pos, dimensions, colour)
+		{}
+
+		~Capsule() override {}
+
+		ShapeType GetShapeType() const override { return ShapeType::CAPSULE; }
+
+		Vec4 GetShapeParams() const override { return Vec4(m_outlineThickness, 0.f, 0.f, 0.f); }
+
+		// 0 fills the capsule
+		void SetOutlineThickness(float thickness) { m_outlineThickness = thickness; ++m_version; }
+
+		inline float GetOutlineThickness() const { return m_outlineThickness; }
+
+	private:
+		float m_outlineThickness = 0.f;
+	};
+}
@@ -15,7 +15,7 @@ namespace ZVK
 
 		ShapeType GetShapeType() const override { return ShapeType::CIRCLE; }
 
-		void SetThickness(float thickness) { m_circleThickness = thickness; }
-		void SetFade(float fade) { m_circleFade = fade; }
+		void SetThickness(float thickness) { m_circleThickness = thickness; ++m_version; }
+		void SetFade(float fade) { m_circleFade = fade; ++m_version; }
 	};
 }
\ No newline at end of file
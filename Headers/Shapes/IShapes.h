@@ -4,7 +4,11 @@
 
 namespace ZVK
 {
-	enum class ShapeType { RECTANGLE = 0, CIRCLE = 1 };
+	// Every type is drawn by the same shader so a batch can mix them
+	enum class ShapeType
+	{
+		RECTANGLE = 0, CIRCLE = 1, ROUNDED_RECTANGLE = 2, RING = 3, CAPSULE = 4, LINE = 5, TRIANGLE = 6
+	};
 
 	class IShape : public IDrawableObject
 	{
@@ -18,6 +22,10 @@ namespace ZVK
 
 		virtual ShapeType GetShapeType() const = 0;
 
+		// Passed to the shape shader with the shape, what each value means depends on the shape type.
+		// Lengths are in scaled units, so they grow with the shape's scale
+		virtual Vec4 GetShapeParams() const { return Vec4(m_circleThickness, m_circleFade, 0.f, 0.f); }
+
 		// Used for circles, it's in the shape class so it can easily be passed to the shape shader
 		const inline float GetCircleThickness() const { return m_circleThickness; }
 
@@ -28,4 +36,4 @@ namespace ZVK
 		float m_circleThickness;
 		float m_circleFade;
 	};
-}
\ No newline at end of file
+}
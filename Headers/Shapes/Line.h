@@ -0,0 +1,73 @@
+#pragma once
+
+#include <math.h>
+
+#include "IShapes.h"
+
+namespace ZVK
+{
+	// Matches the caps in Shape.frag
+	enum class LineCap { ROUND = 0, BUTT = 1, SQUARE = 2 };
+
+	// How ShapeRenderer::DrawPolyline connects its segments
+	enum class LineJoin { ROUND = 0, BEVEL = 1, MITER = 2 };
+
+	// A segment with rounded ends by default, its quad is rotated so the shape's x axis runs from start to end
+	class Line : public IShape
+	{
+	public:
+		Line(Vec3 start, Vec3 end, float thickness, Vec4 colour = Vec4::One())
+			: IShape(start, Vec3::Zero(), colour), m_start(start), m_end(end), m_thickness(thickness)
+		{
+			updateTransform();
+		}
+
+		~Line() override {}
+
+		ShapeType GetShapeType() const override { return ShapeType::LINE; }
+
+		Vec4 GetShapeParams() const override { return Vec4(m_dashLength, m_gapLength, (float)m_cap, 0.f); }
+
+		void SetPoints(Vec3 start, Vec3 end) { m_start = start; m_end = end; updateTransform(); }
+		void SetThickness(float thickness) { m_thickness = thickness; updateTransform(); }
+
+		// A dash or gap length of 0 draws a solid line
+		void SetDash(float dashLength, float gapLength)
+		{ m_dashLength = dashLength; m_gapLength = gapLength; ++m_version; }
+
+		void SetCap(LineCap cap) { m_cap = cap; ++m_version; }
+
+		inline const Vec3& GetStart() const { return m_start; }
+		inline const Vec3& GetEnd() const { return m_end; }
+		inline float GetThickness() const { return m_thickness; }
+		inline LineCap GetCap() const { return m_cap; }
+
+	private:
+		void updateTransform()
+		{
+			float dx = m_end.x - m_start.x;
+			float dy = m_end.y - m_start.y;
+
+			// Round and square caps stick out half the thickness past the points
+			float width = sqrtf(dx * dx + dy * dy) + m_thickness;
+
+			m_dimensions = Vec3(width, m_thickness, 0.f);
+			m_pos = Vec3((m_start.x + m_end.x - width) / 2.f, (m_start.y + m_end.y - m_thickness) / 2.f, m_start.z);
+
+			// Rotating by z turns the x axis by -z
+			m_rotation = Vec3(0.f, 0.f, -atan2f(dy, dx));
+
+			++m_version;
+		}
+
+	private:
+		Vec3 m_start;
+		Vec3 m_end;
+		float m_thickness;
+
+		float m_dashLength = 0.f;
+		float m_gapLength = 0.f;
+
+		LineCap m_cap = LineCap::ROUND;
+	};
+}
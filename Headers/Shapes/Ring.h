@@ -0,0 +1,35 @@
+#pragma once
+
+#include "IShapes.h"
+
+namespace ZVK
+{
+	// The outer edge touches the shorter side of the shape, an arc is drawn when the sweep is below 2 pi
+	class Ring : public IShape
+	{
+	public:
+		Ring(Vec3 pos, Vec3 dimensions, float thickness, Vec4 colour = Vec4::One())
+			: IShape(pos, dimensions, colour), m_thickness(thickness)
+		{}
+
+		~Ring() override {}
+
+		ShapeType GetShapeType() const override { return ShapeType::RING; }
+
+		Vec4 GetShapeParams() const override { return Vec4(m_thickness, m_startAngle, m_sweep, 0.f); }
+
+		void SetThickness(float thickness) { m_thickness = thickness; ++m_version; }
+
+		// In radians, from the shape's x axis towards its y axis. The ends of an arc are rounded
+		void SetArc(float startAngle, float sweep) { m_startAngle = startAngle; m_sweep = sweep; ++m_version; }
+
+		inline float GetThickness() const { return m_thickness; }
+		inline float GetStartAngle() const { return m_startAngle; }
+		inline float GetSweep() const { return m_sweep; }
+
+	private:
+		float m_thickness;
+		float m_startAngle = 0.f;
+		float m_sweep = 6.28318530718f;
+	};
+}
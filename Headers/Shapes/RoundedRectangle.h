@@ -0,0 +1,33 @@
+#pragma once
+
+#include "IShapes.h"
+
+namespace ZVK
+{
+	class RoundedRectangle : public IShape
+	{
+	public:
+		RoundedRectangle(Vec3 pos, Vec3 dimensions, float cornerRadius, Vec4 colour = Vec4::One())
+			: IShape(pos, dimensions, colour), m_cornerRadius(cornerRadius)
+		{}
+
+		~RoundedRectangle() override {}
+
+		ShapeType GetShapeType() const override { return ShapeType::ROUNDED_RECTANGLE; }
+
+		Vec4 GetShapeParams() const override { return Vec4(m_cornerRadius, m_outlineThickness, 0.f, 0.f); }
+
+		// Clamped to half of the shorter side
+		void SetCornerRadius(float radius) { m_cornerRadius = radius; ++m_version; }
+
+		// 0 fills the rectangle
+		void SetOutlineThickness(float thickness) { m_outlineThickness = thickness; ++m_version; }
+
+		inline float GetCornerRadius() const { return m_cornerRadius; }
+		inline float GetOutlineThickness() const { return m_outlineThickness; }
+
+	private:
+		float m_cornerRadius;
+		float m_outlineThickness = 0.f;
+	};
+}
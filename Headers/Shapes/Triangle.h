@@ -0,0 +1,34 @@
+#pragma once
+
+#include "IShapes.h"
+
+namespace ZVK
+{
+	// The base is the bottom of the shape and the apex is on its top edge
+	class Triangle : public IShape
+	{
+	public:
+		Triangle(Vec3 pos, Vec3 dimensions, Vec4 colour = Vec4::One())
+			: IShape(pos, dimensions, colour)
+		{}
+
+		~Triangle() override {}
+
+		ShapeType GetShapeType() const override { return ShapeType::TRIANGLE; }
+
+		Vec4 GetShapeParams() const override { return Vec4(m_apex, m_outlineThickness, 0.f, 0.f); }
+
+		// -1 puts the apex above the left corner, 0 in the middle and 1 above the right corner
+		void SetApex(float apex) { m_apex = apex; ++m_version; }
+
+		// 0 fills the triangle
+		void SetOutlineThickness(float thickness) { m_outlineThickness = thickness; ++m_version; }
+
+		inline float GetApex() const { return m_apex; }
+		inline float GetOutlineThickness() const { return m_outlineThickness; }
+
+	private:
+		float m_apex = 0.f;
+		float m_outlineThickness = 0.f;
+	};
+}
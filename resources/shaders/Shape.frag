@@ -4,27 +4,176 @@ layout (location = 0) out vec4 outColour;
 
 layout (location = 0) in vec4 fragColour;
 layout (location = 1) in vec2 localPos;
-layout (location = 2) in float circleThickness;
-layout (location = 3) in float circleFade;
-layout (location = 4) in float shapeType;
+layout (location = 2) flat in vec2 halfSize;
+layout (location = 3) flat in uint shapeType;
+layout (location = 4) flat in vec4 params;
 
-// enum class ShapeType { RECTANGLE = 0, CIRCLE = 1 };
+// Matches enum class ShapeType in IShapes.h
+#define SHAPE_RECTANGLE         0u
+#define SHAPE_CIRCLE            1u
+#define SHAPE_ROUNDED_RECTANGLE 2u
+#define SHAPE_RING              3u
+#define SHAPE_CAPSULE           4u
+#define SHAPE_LINE              5u
+#define SHAPE_TRIANGLE          6u
+
+#define TWO_PI 6.28318530718
+
+// The distance functions return negative distances inside the shape
+
+float roundedBoxDistance(vec2 p, vec2 halfExtents, float radius)
+{
+	radius = min(radius, min(halfExtents.x, halfExtents.y));
+
+	vec2 q = abs(p) - halfExtents + radius;
+	return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+// Matches enum class LineCap in Line.h
+#define CAP_ROUND  0.0
+#define CAP_BUTT   1.0
+#define CAP_SQUARE 2.0
+
+// Segment along the x axis from startX to endX
+float segmentDistance(vec2 p, float startX, float endX, float radius, float cap)
+{
+	if (cap == CAP_ROUND)
+		return length(p - vec2(clamp(p.x, startX, endX), 0.0)) - radius;
+
+	// Square caps stick out as far as round ones would
+	float capLength = cap == CAP_SQUARE ? radius : 0.0;
+
+	vec2 halfExtents = vec2((endX - startX) * 0.5 + capLength, radius);
+	return roundedBoxDistance(p - vec2((startX + endX) * 0.5, 0.0), halfExtents, 0.0);
+}
+
+float capsuleDistance(vec2 p, vec2 halfExtents)
+{
+	// Always along the longer side
+	if (halfExtents.y > halfExtents.x)
+	{
+		p = p.yx;
+		halfExtents = halfExtents.yx;
+	}
+
+	float halfLength = halfExtents.x - halfExtents.y;
+	return segmentDistance(p, -halfLength, halfLength, halfExtents.y, CAP_ROUND);
+}
+
+// params: x = dash length, y = gap length, z = cap. The quad leaves room for round caps at both ends
+float lineDistance(vec2 p, vec2 halfExtents)
+{
+	float radius = halfExtents.y;
+	float halfLength = max(halfExtents.x - radius, 0.0);
+
+	float dash = params.x;
+	float period = params.x + params.y;
+	float cap = params.z;
+
+	if (dash <= 0.0 || params.y <= 0.0)
+		return segmentDistance(p, -halfLength, halfLength, radius, cap);
+
+	// The dash this fragment is in and the next one, the closest of the two wins
+	float dashStart = -halfLength + floor(max(p.x + halfLength, 0.0) / period) * period;
+
+	float d = segmentDistance(p, dashStart, min(dashStart + dash, halfLength), radius, cap);
+
+	if (dashStart + period <= halfLength)
+		d = min(d, segmentDistance(p, dashStart + period, min(dashStart + period + dash, halfLength), radius, cap));
+
+	return d;
+}
+
+// params: x = thickness, y = start angle, z = sweep
+float ringDistance(vec2 p, vec2 halfExtents)
+{
+	float thickness = min(params.x, min(halfExtents.x, halfExtents.y));
+	float radius = min(halfExtents.x, halfExtents.y) - thickness * 0.5;
+
+	float sweep = params.z;
+
+	if (sweep < TWO_PI)
+	{
+		float angle = mod(atan(p.y, p.x) - params.y, TWO_PI);
+
+		// Outside of the arc the closest point is on one of its rounded ends
+		if (angle > sweep)
+		{
+			vec2 startPoint = radius * vec2(cos(params.y), sin(params.y));
+			vec2 endPoint = radius * vec2(cos(params.y + sweep), sin(params.y + sweep));
+
+			return min(length(p - startPoint), length(p - endPoint)) - thickness * 0.5;
+		}
+	}
+
+	return abs(length(p) - radius) - thickness * 0.5;
+}
+
+// params: x = where the apex is along the top edge, -1 is the left corner and 1 the right one
+float triangleDistance(vec2 p, vec2 halfExtents)
+{
+	vec2 p0 = vec2(-halfExtents.x, -halfExtents.y);
+	vec2 p1 = vec2( halfExtents.x, -halfExtents.y);
+	vec2 p2 = vec2(clamp(params.x, -1.0, 1.0) * halfExtents.x, halfExtents.y);
+
+	vec2 e0 = p1 - p0, e1 = p2 - p1, e2 = p0 - p2;
+	vec2 v0 = p - p0, v1 = p - p1, v2 = p - p2;
+
+	vec2 pq0 = v0 - e0 * clamp(dot(v0, e0) / dot(e0, e0), 0.0, 1.0);
+	vec2 pq1 = v1 - e1 * clamp(dot(v1, e1) / dot(e1, e1), 0.0, 1.0);
+	vec2 pq2 = v2 - e2 * clamp(dot(v2, e2) / dot(e2, e2), 0.0, 1.0);
+
+	float s = sign(e0.x * e2.y - e0.y * e2.x);
+
+	vec2 d = min(min(vec2(dot(pq0, pq0), s * (v0.x * e0.y - v0.y * e0.x)),
+		vec2(dot(pq1, pq1), s * (v1.x * e1.y - v1.y * e1.x))),
+		vec2(dot(pq2, pq2), s * (v2.x * e2.y - v2.y * e2.x)));
+
+	return -sqrt(d.x) * sign(d.y);
+}
+
+// A thickness above 0 only keeps a band of the shape that wide along its edge
+float outline(float d, float thickness)
+{
+	return thickness > 0.0 ? abs(d + thickness * 0.5) - thickness * 0.5 : d;
+}
 
 void main()
 {	
 	vec4 colour = fragColour;
 
-	if(shapeType == 1.0)
+	float coverage = 1.0;
+
+	if (shapeType == SHAPE_CIRCLE)
+	{
+		// Thickness and fade are fractions of the radius
+		float distance = 1.0 - length(localPos / halfSize);
+		coverage = smoothstep(0.0, params.y, distance);
+		coverage *= smoothstep(params.x + params.y, params.x, distance);
+	}
+	else if (shapeType != SHAPE_RECTANGLE)
 	{
-		float distance = 1.0 - length(localPos);
-		float circle = smoothstep(0.0, circleFade, distance);
-		circle *= smoothstep(circleThickness + circleFade, circleThickness, distance);
+		float d;
 
-		if(circle == 0.0)
-			discard;
+		if (shapeType == SHAPE_ROUNDED_RECTANGLE)
+			d = outline(roundedBoxDistance(localPos, halfSize, params.x), params.y);
+		else if (shapeType == SHAPE_RING)
+			d = ringDistance(localPos, halfSize);
+		else if (shapeType == SHAPE_CAPSULE)
+			d = outline(capsuleDistance(localPos, halfSize), params.x);
+		else if (shapeType == SHAPE_LINE)
+			d = lineDistance(localPos, halfSize);
+		else
+			d = outline(triangleDistance(localPos, halfSize), params.y);
 
-		colour.a *= circle;
+		// About a pixel of anti aliasing whatever the scale
+		coverage = clamp(0.5 - d / max(fwidth(d), 1e-5), 0.0, 1.0);
 	}
 
+	if (coverage == 0.0)
+		discard;
+
+	colour.a *= coverage;
+
 	outColour = colour;
 }
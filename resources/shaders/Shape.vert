@@ -1,30 +1,47 @@
 #version 450
 
-layout (set = 0, binding = 0) uniform UniformBufferObject 
+layout (push_constant) uniform PushConstants
 {
 	mat4 pv;
-} ubo;
+} pc;
 
-layout (location = 0) in vec3 inPos;
-layout (location = 1) in vec4 inColour;
-layout (location = 2) in vec2 inLocalPos;
-layout (location = 3) in float inCircleThickness;
-layout (location = 4) in float inCircleFade;
-layout (location = 5) in float inShapeType;
+// Per instance, see ShapeInstance
+layout (location = 0) in vec2 inCenter;
+layout (location = 1) in vec2 inAxisX;
+layout (location = 2) in vec2 inAxisY;
+layout (location = 3) in float inDepth;
+layout (location = 4) in uint inShapeType;
+layout (location = 5) in vec4 inColour;
+layout (location = 6) in vec4 inParams;
 
 layout (location = 0) out vec4 fragColour;
 layout (location = 1) out vec2 localPos;
-layout (location = 2) out float circleThickness;
-layout (location = 3) out float circleFade;
-layout (location = 4) out float shapeType;
+layout (location = 2) flat out vec2 halfSize;
+layout (location = 3) flat out uint shapeType;
+layout (location = 4) flat out vec4 params;
+
+// Same order as the sprite quads (TR, TL, BL, BL, BR, TR)
+const vec2 corners[6] = vec2[](
+	vec2( 1.0,  1.0),
+	vec2(-1.0,  1.0),
+	vec2(-1.0, -1.0),
+	vec2(-1.0, -1.0),
+	vec2( 1.0, -1.0),
+	vec2( 1.0,  1.0)
+);
 
 void main() 
 {
-	gl_Position = ubo.pv * vec4(inPos, 1.0);
+	vec2 corner = corners[gl_VertexIndex];
+
+	vec2 worldPos = inCenter + inAxisX * corner.x + inAxisY * corner.y;
+	gl_Position = pc.pv * vec4(worldPos, inDepth, 1.0);
+
+	// The shape functions work in scaled units around the center of the shape
+	halfSize = vec2(length(inAxisX), length(inAxisY));
+	localPos = corner * halfSize;
 
 	fragColour = inColour;
-	localPos = inLocalPos;
 	shapeType = inShapeType;
-	circleThickness = inCircleThickness;
-	circleFade = inCircleFade;
-}
\ No newline at end of file
+	params = inParams;
+}
@@ -4,7 +4,7 @@
 
 //layout(set = 0, binding = 1) uniform sampler samp[];
 layout(set = 0, binding = 1) uniform sampler samp;
-layout(set = 0, binding = 2) uniform texture2D textures[];
+layout(set = 1, binding = 0) uniform texture2D textures[];
 	
 layout(location = 0) out vec4 outColour;
 
@@ -1,14 +1,16 @@
 #version 450
 
-layout (set = 0, binding = 0) uniform UniformBufferObject 
+layout (push_constant) uniform PushConstants
 {
 	mat4 pv;
-} ubo;
+} pc;
 
-layout (location = 0) in vec3 inPos;
+// The packed formats are unpacked by the vertex input, see SpriteVertex
+layout (location = 0) in vec2 inPos;
 layout (location = 1) in vec4 inColour;
 layout (location = 2) in vec2 inTexCoord;
-layout (location = 3) in int inTexIndex;
+layout (location = 3) in uint inTexIndex;
+layout (location = 4) in float inDepth;
 
 layout (location = 0) out vec4 fragColour;
 layout (location = 1) out vec2 fragUV; 
@@ -16,9 +18,9 @@ layout (location = 2) out int texIndex;
 
 void main() 
 {
-	gl_Position = ubo.pv * vec4(inPos, 1.0);
+	gl_Position = pc.pv * vec4(inPos, inDepth, 1.0);
 
 	fragColour = inColour;
 	fragUV = inTexCoord;
-	texIndex = inTexIndex;
+	texIndex = int(inTexIndex);
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 450
+
+// Baked draws are recorded once, the view projection is written to this buffer every frame instead
+layout (set = 0, binding = 0) uniform BakedView
+{
+	mat4 pv;
+} view;
+
+// The packed formats are unpacked by the vertex input, see SpriteVertex
+layout (location = 0) in vec2 inPos;
+layout (location = 1) in vec4 inColour;
+layout (location = 2) in vec2 inTexCoord;
+layout (location = 3) in uint inTexIndex;
+layout (location = 4) in float inDepth;
+
+layout (location = 0) out vec4 fragColour;
+layout (location = 1) out vec2 fragUV; 
+layout (location = 2) out int texIndex;
+
+void main() 
+{
+	gl_Position = view.pv * vec4(inPos, inDepth, 1.0);
+
+	fragColour = inColour;
+	fragUV = inTexCoord;
+	texIndex = int(inTexIndex);
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#version 450
+
+layout (push_constant) uniform PushConstants
+{
+	mat4 pv;
+} pc;
+
+// Per instance, the packed formats are unpacked by the vertex input, see SpriteInstance
+layout (location = 0) in vec2 inCenter;
+layout (location = 1) in vec2 inSize; // Already scaled
+layout (location = 2) in float inDepth;
+layout (location = 3) in float inRotation;
+layout (location = 4) in vec4 inUVInfo;
+layout (location = 5) in vec4 inColour;
+layout (location = 6) in uint inTexIndex;
+
+layout (location = 0) out vec4 fragColour;
+layout (location = 1) out vec2 fragUV;
+layout (location = 2) out int texIndex;
+
+// Unit quad around the center, same order as the per vertex path (TR, TL, BL, BL, BR, TR)
+const vec2 corners[6] = vec2[](
+	vec2( 0.5,  0.5),
+	vec2(-0.5,  0.5),
+	vec2(-0.5, -0.5),
+	vec2(-0.5, -0.5),
+	vec2( 0.5, -0.5),
+	vec2( 0.5,  0.5)
+);
+
+void main()
+{
+	vec2 corner = corners[gl_VertexIndex];
+
+	// Rotate around the center of the sprite
+	vec2 local = corner * inSize;
+
+	float c = cos(inRotation);
+	float s = sin(inRotation);
+
+	vec2 rotated = vec2(c * local.x + s * local.y, -s * local.x + c * local.y);
+
+	gl_Position = pc.pv * vec4(inCenter + rotated, inDepth, 1.0);
+
+	// uvInfo: x = right u, y = bottom v, z = left u, w = top v
+	fragUV = vec2(corner.x > 0.0 ? inUVInfo.x : inUVInfo.z,
+		corner.y > 0.0 ? inUVInfo.w : inUVInfo.y);
+
+	fragColour = inColour;
+	texIndex = int(inTexIndex);
+}
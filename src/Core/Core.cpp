@@ -41,6 +41,9 @@ namespace ZVK
 
 	Core::~Core()
 	{
+		delete p_textureRegistry;
+		p_textureRegistry = nullptr;
+
 		vkDestroyCommandPool(p_device->GetDevice(), m_cmdPool, nullptr);
 
 		p_swapchain->Cleanup();
@@ -50,7 +53,10 @@ namespace ZVK
 		if(m_enableValidationLayers)
 			DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
 
-		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		// Headless cores never create a surface or initialize GLFW
+		if (!m_isHeadless)
+			vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+
 		vkDestroyInstance(m_instance, nullptr);
 
 		delete p_swapchain;
@@ -59,7 +65,8 @@ namespace ZVK
 		p_swapchain = nullptr;
 		p_device = nullptr;
 
-		glfwTerminate();
+		if (!m_isHeadless)
+			glfwTerminate();
 	}
 
 	Core& Core::CreateCore()
@@ -97,6 +104,21 @@ namespace ZVK
 		p_device->Init(this);
 		p_swapchain->Create();
 		createCommandPool();
+
+		p_textureRegistry = new TextureRegistry();
+	}
+
+	void Core::InitHeadless(const std::string& title, uint32_t width, uint32_t height)
+	{
+		m_isHeadless = true;
+
+		createInstance(title.c_str());
+
+		p_device->Init(this);
+		p_swapchain->CreateOffscreen({ width, height });
+		createCommandPool();
+
+		p_textureRegistry = new TextureRegistry();
 	}
 
 	void Core::createInstance(const char* appName)
@@ -361,12 +383,18 @@ namespace ZVK
 
 	std::vector<const char*> Core::getRequiredExtensions()
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
+		std::vector<const char*> extensions;
 
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		// Headless there's no surface so none of GLFW's extensions are needed
+		if (!m_isHeadless)
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (m_enableValidationLayers)
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -19,6 +19,9 @@ namespace ZVK
 	{
 		p_core = pCore;
 
+		if (p_core->IsHeadless())
+			m_deviceExtensions.clear();
+
 		pickDevice();
 		createLogicalDevice();
 	}
@@ -75,11 +78,24 @@ namespace ZVK
 		indexingFeatures.pNext = nullptr;
 		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
 		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
 		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
 
+		// Only enabled when it's supported, software drivers like lavapipe and SwiftShader don't have it
+		// and creating the device fails when a feature that isn't supported is enabled
+		VkPhysicalDeviceBlendOperationAdvancedFeaturesEXT supportedBlendFeatures{};
+		supportedBlendFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BLEND_OPERATION_ADVANCED_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures{};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &supportedBlendFeatures;
+
+		vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceBlendOperationAdvancedFeaturesEXT blendFeatures{};
 		blendFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BLEND_OPERATION_ADVANCED_FEATURES_EXT;
-		blendFeatures.advancedBlendCoherentOperations = VK_TRUE;
+		blendFeatures.advancedBlendCoherentOperations = supportedBlendFeatures.advancedBlendCoherentOperations;
 		blendFeatures.pNext = &indexingFeatures;
 
 		VkDeviceCreateInfo deviceCreateInfo{};
@@ -156,7 +172,9 @@ namespace ZVK
 		if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 			score += 1000;
 
-		if (extensionsSupported)
+		if (p_core->IsHeadless())
+			swapChainAdequate = true;
+		else if (extensionsSupported)
 		{
 			SwapchainSupportDetails swapchainSupport = querySwapChainSupport(device);
 			swapChainAdequate = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
@@ -175,6 +193,13 @@ namespace ZVK
 			return 0;
 		}
 
+		// The texture registry's set is created with these, creating the device fails without either
+		if (!indexingFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+			!indexingFeatures.descriptorBindingVariableDescriptorCount)
+		{
+			return 0;
+		}
+
 		return score;
 	}
 
@@ -193,8 +218,11 @@ namespace ZVK
 		{
 			if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
 			{
-				VkBool32 presentSupport = false;
-				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, p_core->GetSurface(), &presentSupport);
+				// Headless the present queue is never used, it's the graphics one
+				VkBool32 presentSupport = p_core->IsHeadless();
+
+				if (!presentSupport)
+					vkGetPhysicalDeviceSurfaceSupportKHR(device, i, p_core->GetSurface(), &presentSupport);
 
 				indices.graphicsFamily = i;
 				if (presentSupport)
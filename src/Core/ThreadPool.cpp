@@ -0,0 +1,98 @@
+#include "../../Headers/Core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace ZVK
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		m_threads.reserve(threadCount);
+
+		for (uint32_t i = 0; i < threadCount; ++i)
+			m_threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+		}
+
+		m_jobAvailable.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, uint32_t minRangeSize,
+		const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		if (count == 0) return;
+
+		minRangeSize = std::max(minRangeSize, 1u);
+
+		uint32_t rangeCount = std::min(GetThreadCount() + 1, (count + minRangeSize - 1) / minRangeSize);
+
+		if (rangeCount <= 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		uint32_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// The first range is left for the calling thread
+			for (uint32_t begin = rangeSize; begin < count; begin += rangeSize)
+			{
+				uint32_t end = std::min(begin + rangeSize, count);
+
+				m_jobs.push_back([&func, begin, end]() { func(begin, end); });
+				++m_pendingJobs;
+			}
+		}
+
+		m_jobAvailable.notify_all();
+
+		func(0, rangeSize);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobsDone.wait(lock, [this]() { return m_pendingJobs == 0; });
+	}
+
+	uint32_t ThreadPool::GetDefaultThreadCount()
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobAvailable.wait(lock, [this]() { return m_isStopping || !m_jobs.empty(); });
+
+				if (m_isStopping && m_jobs.empty())
+					return;
+
+				job = std::move(m_jobs.back());
+				m_jobs.pop_back();
+			}
+
+			job();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (--m_pendingJobs == 0)
+				m_jobsDone.notify_all();
+		}
+	}
+}
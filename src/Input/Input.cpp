@@ -9,8 +9,11 @@ namespace ZVK
 		m_window = Core::GetCore().GetGLFWWindnow();
 	}
 
+	// Headless there's no window, nothing is ever pressed and the mouse stays at 0, 0
 	bool Input::IsKeyPressed(KeyCode keycode)
 	{
+		if (!m_window) return false;
+
 		auto state = glfwGetKey(m_window, (int)keycode);
 
 		return state == GLFW_PRESS || state == GLFW_REPEAT;
@@ -18,6 +21,8 @@ namespace ZVK
 
 	bool Input::IsKeyReleased(KeyCode keycode)
 	{
+		if (!m_window) return true;
+
 		auto state = glfwGetKey(m_window, (int)keycode);
 
 		return state == GLFW_RELEASE;
@@ -25,6 +30,8 @@ namespace ZVK
 
 	bool Input::IsMouseButtonPressed(MouseCode mouseCode)
 	{
+		if (!m_window) return false;
+
 		auto state = glfwGetMouseButton(m_window, (int)mouseCode);
 
 		return state == GLFW_PRESS;
@@ -32,6 +39,8 @@ namespace ZVK
 
 	bool Input::IsMouseButtonReleased(MouseCode mouseCode)
 	{
+		if (!m_window) return true;
+
 		auto state = glfwGetMouseButton(m_window, (int)mouseCode);
 
 		return state == GLFW_RELEASE;
@@ -39,6 +48,8 @@ namespace ZVK
 
 	Vec2 Input::GetMousePos() const
 	{
+		if (!m_window) return { 0.f, 0.f };
+
 		double xPos, yPos;
 
 		glfwGetCursorPos(m_window, &xPos, &yPos);
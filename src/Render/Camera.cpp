@@ -1,6 +1,8 @@
 #include "../../Headers/Render/Camera.h"
 
 #include <iostream>
+#include <algorithm>
+#include <cfloat>
 
 #include "../../Headers/Core/Window.h"
 
@@ -88,6 +90,29 @@ namespace ZVK
 		return { x, y };
 	}
 
+	Vec4 Camera::GetVisibleRect() const
+	{
+		const Vec4 ndcCorners[4] =
+		{
+			{ -1.f, -1.f, 0.f, 1.f }, { 1.f, -1.f, 0.f, 1.f },
+			{ -1.f,  1.f, 0.f, 1.f }, { 1.f,  1.f, 0.f, 1.f }
+		};
+
+		Vec4 rect(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		for (const Vec4& ndcCorner : ndcCorners)
+		{
+			Vec4 worldPos = m_pvInverse * ndcCorner;
+
+			rect.x = std::min(rect.x, worldPos.x / worldPos.w);
+			rect.y = std::min(rect.y, worldPos.y / worldPos.w);
+			rect.z = std::max(rect.z, worldPos.x / worldPos.w);
+			rect.w = std::max(rect.w, worldPos.y / worldPos.w);
+		}
+
+		return rect;
+	}
+
 	void Camera::SetProjection(float left, float right, float bottom, float top)
 	{
 		m_proj = Mat4::OrthoLH(left, right, bottom, top, -1.f, 1.f);
@@ -0,0 +1,174 @@
+#include "../../Headers/Render/CommandEncoder.h"
+
+#include <string.h>
+
+namespace ZVK
+{
+	void CommandEncoder::Reset(VkCommandBuffer cmdBuffer)
+	{
+		m_cmdBuffer = cmdBuffer;
+
+		m_isViewportSet = false;
+		m_isScissorSet = false;
+
+		m_pipeline = VK_NULL_HANDLE;
+
+		m_layout = VK_NULL_HANDLE;
+		m_descriptorSets.fill(VK_NULL_HANDLE);
+
+		m_pushConstantLayout = VK_NULL_HANDLE;
+
+		m_vertexBuffer = VK_NULL_HANDLE;
+		m_vertexOffset = 0;
+
+		m_indexBuffer = VK_NULL_HANDLE;
+		m_indexOffset = 0;
+	}
+
+	void CommandEncoder::SetViewport(const VkViewport& viewport)
+	{
+		if (m_isViewportSet && memcmp(&m_viewport, &viewport, sizeof(VkViewport)) == 0)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdSetViewport(m_cmdBuffer, 0, 1, &viewport);
+
+		m_viewport = viewport;
+		m_isViewportSet = true;
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::SetScissor(const VkRect2D& scissor)
+	{
+		if (m_isScissorSet && memcmp(&m_scissor, &scissor, sizeof(VkRect2D)) == 0)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdSetScissor(m_cmdBuffer, 0, 1, &scissor);
+
+		m_scissor = scissor;
+		m_isScissorSet = true;
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::BindPipeline(VkPipeline pipeline)
+	{
+		if (m_pipeline == pipeline)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdBindPipeline(m_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		m_pipeline = pipeline;
+
+		// A pipeline with an incompatible layout disturbs the push constants
+		m_pushConstantLayout = VK_NULL_HANDLE;
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::BindDescriptorSets(VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+		const VkDescriptorSet* pSets)
+	{
+		uint32_t changedFirst = 0;
+		uint32_t changedEnd = setCount;
+
+		// Sets bound with another layout might have been disturbed so they're all bound again
+		if (layout != m_layout)
+		{
+			m_descriptorSets.fill(VK_NULL_HANDLE);
+			m_layout = layout;
+		}
+		else
+		{
+			auto isBound = [&](uint32_t i)
+			{
+				return firstSet + i < MAX_ENCODER_DESCRIPTOR_SETS && m_descriptorSets[firstSet + i] == pSets[i];
+			};
+
+			while (changedFirst < setCount && isBound(changedFirst))
+				++changedFirst;
+
+			while (changedEnd > changedFirst && isBound(changedEnd - 1))
+				--changedEnd;
+		}
+
+		if (changedFirst == changedEnd)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdBindDescriptorSets(m_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+			firstSet + changedFirst, changedEnd - changedFirst, pSets + changedFirst, 0, nullptr);
+
+		for (uint32_t i = changedFirst; i < changedEnd; ++i)
+			if (firstSet + i < MAX_ENCODER_DESCRIPTOR_SETS)
+				m_descriptorSets[firstSet + i] = pSets[i];
+
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset,
+		uint32_t size, const void* pData)
+	{
+		if (m_pushConstantLayout == layout && m_pushConstantStages == stages &&
+			m_pushConstantOffset == offset && m_pushConstantSize == size &&
+			memcmp(m_pushConstants.data(), pData, size) == 0)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdPushConstants(m_cmdBuffer, layout, stages, offset, size, pData);
+
+		if (size <= MAX_ENCODER_PUSH_CONSTANT_SIZE)
+		{
+			m_pushConstantLayout = layout;
+			m_pushConstantStages = stages;
+			m_pushConstantOffset = offset;
+			m_pushConstantSize = size;
+			memcpy(m_pushConstants.data(), pData, size);
+		}
+		else
+			m_pushConstantLayout = VK_NULL_HANDLE;
+
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset)
+	{
+		if (m_vertexBuffer == buffer && m_vertexOffset == offset)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdBindVertexBuffers(m_cmdBuffer, 0, 1, &buffer, &offset);
+
+		m_vertexBuffer = buffer;
+		m_vertexOffset = offset;
+		++m_stats.IssuedCount;
+	}
+
+	void CommandEncoder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+	{
+		if (m_indexBuffer == buffer && m_indexOffset == offset && m_indexType == indexType)
+		{
+			++m_stats.SkippedCount;
+			return;
+		}
+
+		vkCmdBindIndexBuffer(m_cmdBuffer, buffer, offset, indexType);
+
+		m_indexBuffer = buffer;
+		m_indexOffset = offset;
+		m_indexType = indexType;
+		++m_stats.IssuedCount;
+	}
+}
@@ -0,0 +1,48 @@
+#include "../../Headers/Render/ImmediateDrawList.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace ZVK
+{
+	void* ImmediateDrawList::Begin(RingBuffer& ring, uint32_t maxCount, const DrawView& view)
+	{
+		if (m_chunkUsed + maxCount > m_chunkCapacity)
+		{
+			uint32_t capacity = std::max(maxCount, m_chunkElementCount);
+
+			m_chunk = ring.Allocate(m_elementSize * capacity);
+			m_chunkUsed = 0;
+			m_chunkCapacity = capacity;
+		}
+
+		VkDeviceSize offset = m_chunk.Offset + m_elementSize * m_chunkUsed;
+
+		// Carries on the last draw when it ends where these elements start
+		bool canAppend = !m_draws.empty() && m_draws.back().Buffer == m_chunk.Buffer &&
+			m_draws.back().Offset + m_elementSize * m_draws.back().Count == offset &&
+			memcmp(&m_draws.back().View, &view, sizeof(DrawView)) == 0;
+
+		if (!canAppend)
+			m_draws.push_back({ m_chunk.Buffer, offset, 0, view });
+
+		return (char*)m_chunk.pData + m_elementSize * m_chunkUsed;
+	}
+
+	void ImmediateDrawList::End(uint32_t count)
+	{
+		m_chunkUsed += count;
+		m_elementCount += count;
+		m_draws.back().Count += count;
+	}
+
+	void ImmediateDrawList::Clear()
+	{
+		m_draws.clear();
+		m_elementCount = 0;
+
+		m_chunk = RingAllocation();
+		m_chunkUsed = 0;
+		m_chunkCapacity = 0;
+	}
+}
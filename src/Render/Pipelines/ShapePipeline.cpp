@@ -66,8 +66,8 @@ namespace ZVK
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		auto bindingDescription = ShapeVertex::GetBindingDescription();
-		auto attributeDescriptions = ShapeVertex::GetAttributeDescriptions();
+		auto bindingDescription = ShapeInstance::GetBindingDescription();
+		auto attributeDescriptions = ShapeInstance::GetAttributeDescriptions();
 
 		vertexInputInfo.vertexBindingDescriptionCount = 1;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -118,8 +118,16 @@ namespace ZVK
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+		// Shapes don't use any descriptors, the view projection is pushed with each draw
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(ShapePushConstants);
+
+		pipelineLayoutInfo.setLayoutCount = 0;
+		pipelineLayoutInfo.pSetLayouts = nullptr;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
 		if (vkCreatePipelineLayout(pDevice->GetDevice(), &pipelineLayoutInfo,
 			nullptr, &m_pipelineLayout) != VK_SUCCESS)
@@ -153,53 +161,12 @@ namespace ZVK
 
 	void ShapePipeline::createDescriptorSetLayout()
 	{
-		VkDescriptorBindingFlagsEXT bindFlags[] =
-		{
-			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
-		};
-
-		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT extendedInfo{};
-		extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
-		extendedInfo.bindingCount = 1;
-		extendedInfo.pBindingFlags = bindFlags;
-		extendedInfo.pNext = nullptr;
-
-		VkDescriptorSetLayoutBinding uboLayoutBinding{};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.pImmutableSamplers = nullptr;
-
-		std::array<VkDescriptorSetLayoutBinding, 1> bindings =
-		{ uboLayoutBinding };
-
-		VkDescriptorSetLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-		layoutInfo.pBindings = bindings.data();
-		layoutInfo.pNext = &extendedInfo;
-
-		if (vkCreateDescriptorSetLayout(Core::GetCore().GetDevice()->GetDevice(), &layoutInfo,
-			nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
-			throw std::runtime_error("Failed to create descriptor set layout!");
+		// Nothing to create, destroying a null layout and pool does nothing
+		m_descriptorSetLayout = VK_NULL_HANDLE;
 	}
 
 	void ShapePipeline::createDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 1> poolSizes{};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = 1;
-
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = 1;
-		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-
-		if (vkCreateDescriptorPool(Core::GetCore().GetDevice()->GetDevice(), &poolInfo,
-			nullptr, &m_descriptorPool) != VK_SUCCESS)
-			throw std::runtime_error("Failed to create descriptor pool!");
+		m_descriptorPool = VK_NULL_HANDLE;
 	}
-}
+}
\ No newline at end of file
@@ -5,8 +5,8 @@
 namespace ZVK
 {
 	SpritePipeline::SpritePipeline(const std::string& vertPath, const std::string& fragPath,
-		PipelineConfigInfo* configInfo)
-		: IPipeline(vertPath, fragPath, configInfo)
+		PipelineConfigInfo* configInfo, SpriteVertexLayout vertexLayout)
+		: IPipeline(vertPath, fragPath, configInfo), m_vertexLayout(vertexLayout)
 	{
 		createDescriptorSetLayout();
 		createGraphicsPipeline();
@@ -65,8 +65,23 @@ namespace ZVK
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		auto bindingDescription = SpriteVertex::GetBindingDescription();
-		auto attributeDescriptions = SpriteVertex::GetAttributeDescriptions();
+		VkVertexInputBindingDescription bindingDescription{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
+		if (m_vertexLayout == SpriteVertexLayout::INSTANCED)
+		{
+			auto instanceAttributes = SpriteInstance::GetAttributeDescriptions();
+
+			bindingDescription = SpriteInstance::GetBindingDescription();
+			attributeDescriptions.assign(instanceAttributes.begin(), instanceAttributes.end());
+		}
+		else
+		{
+			auto vertexAttributes = SpriteVertex::GetAttributeDescriptions();
+
+			bindingDescription = SpriteVertex::GetBindingDescription();
+			attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+		}
 
 		vertexInputInfo.vertexBindingDescriptionCount = 1;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -117,8 +132,25 @@ namespace ZVK
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1; 
-		pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+		// The textures come from the registry's set so every sprite pipeline shares them
+		std::array<VkDescriptorSetLayout, 2> setLayouts =
+		{ m_descriptorSetLayout, Core::GetCore().GetTextureRegistry()->GetDescriptorSetLayout() };
+
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+
+		// The view projection is pushed with each draw so draws in the same frame can use different cameras
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(SpritePushConstants);
+
+		// Baked draws read it from their view's uniform buffer
+		if (m_vertexLayout != SpriteVertexLayout::BAKED)
+		{
+			pipelineLayoutInfo.pushConstantRangeCount = 1;
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		}
 
 		if (vkCreatePipelineLayout(pDevice->GetDevice(), &pipelineLayoutInfo,
 			nullptr, &m_pipelineLayout) != VK_SUCCESS)
@@ -154,26 +186,21 @@ namespace ZVK
 	{
 		VkDescriptorBindingFlagsEXT bindFlags[] =
 		{
-			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
 			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
 			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
 		};
 
-		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT extendedInfo{};
-		extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
-		extendedInfo.bindingCount = 3;
-		extendedInfo.pBindingFlags = bindFlags;
-		extendedInfo.pNext = nullptr;
+		// Binding 0 is the view projection's uniform buffer, only baked draws use it.
+		// The other layouts push the view projection instead
+		VkDescriptorSetLayoutBinding viewLayoutBinding{};
 
-		VkDescriptorSetLayoutBinding uboLayoutBinding{};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.pImmutableSamplers = nullptr;
+		viewLayoutBinding.binding = 0;
+		viewLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		viewLayoutBinding.descriptorCount = 1;
+		viewLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		viewLayoutBinding.pImmutableSamplers = nullptr;
 
 		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-		VkDescriptorSetLayoutBinding sampledImageLayoutBinding{};
 
 		samplerLayoutBinding.binding = 1;
 		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
@@ -181,14 +208,18 @@ namespace ZVK
 		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 		samplerLayoutBinding.pImmutableSamplers = nullptr;
 
-		sampledImageLayoutBinding.binding = 2;
-		sampledImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		sampledImageLayoutBinding.descriptorCount = Core::GetCore().GetMaxTextureSlots();
-		sampledImageLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		sampledImageLayoutBinding.pImmutableSamplers = nullptr;
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+		if (m_vertexLayout == SpriteVertexLayout::BAKED)
+			bindings.push_back(viewLayoutBinding);
 
-		std::array<VkDescriptorSetLayoutBinding, 3> bindings =
-		{ uboLayoutBinding, samplerLayoutBinding, sampledImageLayoutBinding };
+		bindings.push_back(samplerLayoutBinding);
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT extendedInfo{};
+		extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		extendedInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		extendedInfo.pBindingFlags = bindFlags;
+		extendedInfo.pNext = nullptr;
 
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -203,19 +234,26 @@ namespace ZVK
 
 	void SpritePipeline::createDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 3> poolSizes{};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		std::vector<VkDescriptorPoolSize> poolSizes(1);
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLER;
 		poolSizes[0].descriptorCount = 1;
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
-		poolSizes[1].descriptorCount = 1;
-		poolSizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		poolSizes[2].descriptorCount = Core::GetCore().GetMaxTextureSlots();
+
+		uint32_t maxSets = 25;
+
+		// Every baked draw has its own set so it can point at its own view
+		if (m_vertexLayout == SpriteVertexLayout::BAKED)
+		{
+			maxSets = MAX_BAKED_SPRITE_DRAWS * MAX_FRAMES_IN_FLIGHT;
+
+			poolSizes[0].descriptorCount = maxSets;
+			poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets });
+		}
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = 25;
+		poolInfo.maxSets = maxSets;
 		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 		if (vkCreateDescriptorPool(Core::GetCore().GetDevice()->GetDevice(), &poolInfo,
@@ -0,0 +1,348 @@
+#include "../../Headers/Render/QuadTransform.h"
+
+#include <cfloat>
+
+#if defined(__AVX__)
+#define QUAD_TRANSFORM_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUAD_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace ZVK
+{
+	// Fills in the A to F terms described by QuadCornerBatch
+	static void getQuadTransform(const IDrawableObject& object, float& a, float& b, float& c,
+		float& d, float& e, float& f)
+	{
+		float scaleX = object.GetScaleX();
+		float scaleY = object.GetScaleY();
+
+		// These match scale * (rotateX * rotateY * rotateZ) applied to a corner with z and w = 1
+		if (object.GetRotationX() == 0.f && object.GetRotationY() == 0.f)
+		{
+			if (object.GetRotationZ() == 0.f)
+			{
+				a = scaleX; b = 0.f;
+				c = 0.f;    d = scaleY;
+			}
+			else
+			{
+				float sinZ = sinf(object.GetRotationZ());
+				float cosZ = cosf(object.GetRotationZ());
+
+				a = scaleX * cosZ;  b = scaleY * sinZ;
+				c = -scaleX * sinZ; d = scaleY * cosZ;
+			}
+
+			e = 0.f;
+			f = 0.f;
+		}
+		else
+		{
+			// Rotating around x or y is rare enough to keep using the matrices
+			Mat4 transform = Mat4::Scale(scaleX, scaleY, object.GetScaleZ()) *
+				(Mat4::RotateX(object.GetRotationX()) * Mat4::RotateY(object.GetRotationY()) *
+					Mat4::RotateZ(object.GetRotationZ()));
+
+			a = transform.m_cells[0][0]; b = transform.m_cells[1][0];
+			c = transform.m_cells[0][1]; d = transform.m_cells[1][1];
+			e = transform.m_cells[2][0] + transform.m_cells[3][0];
+			f = transform.m_cells[2][1] + transform.m_cells[3][1];
+		}
+	}
+
+	void AddQuad(QuadCornerBatch& batch, const IDrawableObject& object)
+	{
+		uint32_t i = batch.Count++;
+
+		float halfW = object.GetWidth() / 2.f;
+		float halfH = object.GetHeight() / 2.f;
+
+		batch.CentreX[i] = object.GetX() + halfW;
+		batch.CentreY[i] = object.GetY() + halfH;
+		batch.HalfWidth[i] = halfW;
+		batch.HalfHeight[i] = halfH;
+
+		getQuadTransform(object, batch.A[i], batch.B[i], batch.C[i], batch.D[i], batch.E[i], batch.F[i]);
+	}
+
+	void AddQuad(QuadCornerBatch& batch, float x, float y, float width, float height,
+		float rotationZ, float scaleX, float scaleY)
+	{
+		uint32_t i = batch.Count++;
+
+		float halfW = width / 2.f;
+		float halfH = height / 2.f;
+
+		batch.CentreX[i] = x + halfW;
+		batch.CentreY[i] = y + halfH;
+		batch.HalfWidth[i] = halfW;
+		batch.HalfHeight[i] = halfH;
+
+		if (rotationZ == 0.f)
+		{
+			batch.A[i] = scaleX; batch.B[i] = 0.f;
+			batch.C[i] = 0.f;    batch.D[i] = scaleY;
+		}
+		else
+		{
+			float sinZ = sinf(rotationZ);
+			float cosZ = cosf(rotationZ);
+
+			batch.A[i] = scaleX * cosZ;  batch.B[i] = scaleY * sinZ;
+			batch.C[i] = -scaleX * sinZ; batch.D[i] = scaleY * cosZ;
+		}
+
+		batch.E[i] = 0.f;
+		batch.F[i] = 0.f;
+	}
+
+	void QuadBounds::Resize(size_t count)
+	{
+		MinX.resize(count, FLT_MAX);
+		MinY.resize(count, FLT_MAX);
+		MaxX.resize(count, -FLT_MAX);
+		MaxY.resize(count, -FLT_MAX);
+	}
+
+	void QuadBounds::Clear()
+	{
+		MinX.clear(); MinY.clear();
+		MaxX.clear(); MaxY.clear();
+	}
+
+	void QuadBounds::Set(uint32_t index, const IDrawableObject& object)
+	{
+		float a, b, c, d, e, f;
+		getQuadTransform(object, a, b, c, d, e, f);
+
+		float halfW = object.GetWidth() / 2.f;
+		float halfH = object.GetHeight() / 2.f;
+
+		float originX = object.GetX() + halfW + e;
+		float originY = object.GetY() + halfH + f;
+
+		// The corners are origin +- (a * halfW) +- (b * halfH) so these are the furthest they reach
+		float extentX = fabsf(a * halfW) + fabsf(b * halfH);
+		float extentY = fabsf(c * halfW) + fabsf(d * halfH);
+
+		MinX[index] = originX - extentX; MaxX[index] = originX + extentX;
+		MinY[index] = originY - extentY; MaxY[index] = originY + extentY;
+	}
+
+	void QuadBounds::SetEmpty(uint32_t index)
+	{
+		MinX[index] = FLT_MAX;  MinY[index] = FLT_MAX;
+		MaxX[index] = -FLT_MAX; MaxY[index] = -FLT_MAX;
+	}
+
+	uint32_t CullQuadBoundsScalar(const QuadBounds& bounds, uint32_t first, uint32_t count,
+		const Vec4& visibleRect, uint8_t* pVisible)
+	{
+		uint32_t visibleCount = 0;
+
+		for (uint32_t i = first; i < count; ++i)
+		{
+			bool isVisible = bounds.MaxX[i] >= visibleRect.x && bounds.MinX[i] <= visibleRect.z &&
+				bounds.MaxY[i] >= visibleRect.y && bounds.MinY[i] <= visibleRect.w;
+
+			pVisible[i] = isVisible ? 1 : 0;
+			visibleCount += pVisible[i];
+		}
+
+		return visibleCount;
+	}
+
+	void TransformQuadCornersScalar(QuadCornerBatch& batch)
+	{
+		for (uint32_t i = 0; i < batch.Count; ++i)
+		{
+			float originX = batch.CentreX[i] + batch.E[i];
+			float originY = batch.CentreY[i] + batch.F[i];
+
+			float ax = batch.A[i] * batch.HalfWidth[i];
+			float bx = batch.B[i] * batch.HalfHeight[i];
+			float cy = batch.C[i] * batch.HalfWidth[i];
+			float dy = batch.D[i] * batch.HalfHeight[i];
+
+			batch.CornerX[i * 4 + 0] = originX + ax + bx;
+			batch.CornerY[i * 4 + 0] = originY + cy + dy;
+
+			batch.CornerX[i * 4 + 1] = originX - ax + bx;
+			batch.CornerY[i * 4 + 1] = originY - cy + dy;
+
+			batch.CornerX[i * 4 + 2] = originX - ax - bx;
+			batch.CornerY[i * 4 + 2] = originY - cy - dy;
+
+			batch.CornerX[i * 4 + 3] = originX + ax - bx;
+			batch.CornerY[i * 4 + 3] = originY + cy - dy;
+		}
+	}
+
+#if defined(QUAD_TRANSFORM_AVX)
+	// Interleaves the 4 corners of 8 quads so each quad's corners end up next to each other
+	static inline void storeCorners(float* pDst, __m256 tr, __m256 tl, __m256 bl, __m256 br)
+	{
+		__m256 t0 = _mm256_unpacklo_ps(tr, tl);
+		__m256 t1 = _mm256_unpackhi_ps(tr, tl);
+		__m256 t2 = _mm256_unpacklo_ps(bl, br);
+		__m256 t3 = _mm256_unpackhi_ps(bl, br);
+
+		__m256 q0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 q1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 q2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 q3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+		// The low lanes hold quads 0-3 and the high lanes quads 4-7
+		_mm256_store_ps(pDst + 0, _mm256_permute2f128_ps(q0, q1, 0x20));
+		_mm256_store_ps(pDst + 8, _mm256_permute2f128_ps(q2, q3, 0x20));
+		_mm256_store_ps(pDst + 16, _mm256_permute2f128_ps(q0, q1, 0x31));
+		_mm256_store_ps(pDst + 24, _mm256_permute2f128_ps(q2, q3, 0x31));
+	}
+
+	void TransformQuadCorners(QuadCornerBatch& batch)
+	{
+		for (uint32_t i = 0; i < batch.Count; i += 8)
+		{
+			__m256 originX = _mm256_add_ps(_mm256_load_ps(batch.CentreX + i), _mm256_load_ps(batch.E + i));
+			__m256 originY = _mm256_add_ps(_mm256_load_ps(batch.CentreY + i), _mm256_load_ps(batch.F + i));
+
+			__m256 halfW = _mm256_load_ps(batch.HalfWidth + i);
+			__m256 halfH = _mm256_load_ps(batch.HalfHeight + i);
+
+			__m256 ax = _mm256_mul_ps(_mm256_load_ps(batch.A + i), halfW);
+			__m256 bx = _mm256_mul_ps(_mm256_load_ps(batch.B + i), halfH);
+			__m256 cy = _mm256_mul_ps(_mm256_load_ps(batch.C + i), halfW);
+			__m256 dy = _mm256_mul_ps(_mm256_load_ps(batch.D + i), halfH);
+
+			storeCorners(batch.CornerX + i * 4,
+				_mm256_add_ps(_mm256_add_ps(originX, ax), bx), _mm256_add_ps(_mm256_sub_ps(originX, ax), bx),
+				_mm256_sub_ps(_mm256_sub_ps(originX, ax), bx), _mm256_sub_ps(_mm256_add_ps(originX, ax), bx));
+
+			storeCorners(batch.CornerY + i * 4,
+				_mm256_add_ps(_mm256_add_ps(originY, cy), dy), _mm256_add_ps(_mm256_sub_ps(originY, cy), dy),
+				_mm256_sub_ps(_mm256_sub_ps(originY, cy), dy), _mm256_sub_ps(_mm256_add_ps(originY, cy), dy));
+		}
+	}
+#elif defined(QUAD_TRANSFORM_SSE)
+	void TransformQuadCorners(QuadCornerBatch& batch)
+	{
+		for (uint32_t i = 0; i < batch.Count; i += 4)
+		{
+			__m128 originX = _mm_add_ps(_mm_load_ps(batch.CentreX + i), _mm_load_ps(batch.E + i));
+			__m128 originY = _mm_add_ps(_mm_load_ps(batch.CentreY + i), _mm_load_ps(batch.F + i));
+
+			__m128 halfW = _mm_load_ps(batch.HalfWidth + i);
+			__m128 halfH = _mm_load_ps(batch.HalfHeight + i);
+
+			__m128 ax = _mm_mul_ps(_mm_load_ps(batch.A + i), halfW);
+			__m128 bx = _mm_mul_ps(_mm_load_ps(batch.B + i), halfH);
+			__m128 cy = _mm_mul_ps(_mm_load_ps(batch.C + i), halfW);
+			__m128 dy = _mm_mul_ps(_mm_load_ps(batch.D + i), halfH);
+
+			__m128 trX = _mm_add_ps(_mm_add_ps(originX, ax), bx);
+			__m128 tlX = _mm_add_ps(_mm_sub_ps(originX, ax), bx);
+			__m128 blX = _mm_sub_ps(_mm_sub_ps(originX, ax), bx);
+			__m128 brX = _mm_sub_ps(_mm_add_ps(originX, ax), bx);
+
+			__m128 trY = _mm_add_ps(_mm_add_ps(originY, cy), dy);
+			__m128 tlY = _mm_add_ps(_mm_sub_ps(originY, cy), dy);
+			__m128 blY = _mm_sub_ps(_mm_sub_ps(originY, cy), dy);
+			__m128 brY = _mm_sub_ps(_mm_add_ps(originY, cy), dy);
+
+			// Each row becomes one quad's 4 corners
+			_MM_TRANSPOSE4_PS(trX, tlX, blX, brX);
+			_MM_TRANSPOSE4_PS(trY, tlY, blY, brY);
+
+			_mm_store_ps(batch.CornerX + i * 4 + 0, trX);
+			_mm_store_ps(batch.CornerX + i * 4 + 4, tlX);
+			_mm_store_ps(batch.CornerX + i * 4 + 8, blX);
+			_mm_store_ps(batch.CornerX + i * 4 + 12, brX);
+
+			_mm_store_ps(batch.CornerY + i * 4 + 0, trY);
+			_mm_store_ps(batch.CornerY + i * 4 + 4, tlY);
+			_mm_store_ps(batch.CornerY + i * 4 + 8, blY);
+			_mm_store_ps(batch.CornerY + i * 4 + 12, brY);
+		}
+	}
+#else
+	void TransformQuadCorners(QuadCornerBatch& batch)
+	{
+		TransformQuadCornersScalar(batch);
+	}
+#endif
+
+#if defined(QUAD_TRANSFORM_AVX)
+	uint32_t CullQuadBounds(const QuadBounds& bounds, uint32_t count, const Vec4& visibleRect, uint8_t* pVisible)
+	{
+		__m256 rectMinX = _mm256_set1_ps(visibleRect.x);
+		__m256 rectMinY = _mm256_set1_ps(visibleRect.y);
+		__m256 rectMaxX = _mm256_set1_ps(visibleRect.z);
+		__m256 rectMaxY = _mm256_set1_ps(visibleRect.w);
+
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 overlapX = _mm256_and_ps(
+				_mm256_cmp_ps(_mm256_loadu_ps(&bounds.MaxX[i]), rectMinX, _CMP_GE_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(&bounds.MinX[i]), rectMaxX, _CMP_LE_OQ));
+
+			__m256 overlapY = _mm256_and_ps(
+				_mm256_cmp_ps(_mm256_loadu_ps(&bounds.MaxY[i]), rectMinY, _CMP_GE_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(&bounds.MinY[i]), rectMaxY, _CMP_LE_OQ));
+
+			uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY));
+
+			for (uint32_t bit = 0; bit < 8; ++bit)
+			{
+				pVisible[i + bit] = (mask >> bit) & 1;
+				visibleCount += pVisible[i + bit];
+			}
+		}
+
+		return visibleCount + CullQuadBoundsScalar(bounds, i, count, visibleRect, pVisible);
+	}
+#elif defined(QUAD_TRANSFORM_SSE)
+	uint32_t CullQuadBounds(const QuadBounds& bounds, uint32_t count, const Vec4& visibleRect, uint8_t* pVisible)
+	{
+		__m128 rectMinX = _mm_set1_ps(visibleRect.x);
+		__m128 rectMinY = _mm_set1_ps(visibleRect.y);
+		__m128 rectMaxX = _mm_set1_ps(visibleRect.z);
+		__m128 rectMaxY = _mm_set1_ps(visibleRect.w);
+
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 overlapX = _mm_and_ps(
+				_mm_cmpge_ps(_mm_loadu_ps(&bounds.MaxX[i]), rectMinX),
+				_mm_cmple_ps(_mm_loadu_ps(&bounds.MinX[i]), rectMaxX));
+
+			__m128 overlapY = _mm_and_ps(
+				_mm_cmpge_ps(_mm_loadu_ps(&bounds.MaxY[i]), rectMinY),
+				_mm_cmple_ps(_mm_loadu_ps(&bounds.MinY[i]), rectMaxY));
+
+			uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+
+			pVisible[i + 0] = mask & 1;
+			pVisible[i + 1] = (mask >> 1) & 1;
+			pVisible[i + 2] = (mask >> 2) & 1;
+			pVisible[i + 3] = (mask >> 3) & 1;
+
+			visibleCount += pVisible[i + 0] + pVisible[i + 1] + pVisible[i + 2] + pVisible[i + 3];
+		}
+
+		return visibleCount + CullQuadBoundsScalar(bounds, i, count, visibleRect, pVisible);
+	}
+#else
+	uint32_t CullQuadBounds(const QuadBounds& bounds, uint32_t count, const Vec4& visibleRect, uint8_t* pVisible)
+	{
+		return CullQuadBoundsScalar(bounds, 0, count, visibleRect, pVisible);
+	}
+#endif
+}
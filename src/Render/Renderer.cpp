@@ -3,21 +3,35 @@
 #include <iostream>
 #include <stdexcept>
 #include <array>
+#include <algorithm>
 
 #include "../../Headers/Core/Core.h"
 
 namespace ZVK
 {
-	Renderer::Renderer()
-		: m_clearColour(0.05f, 0.05f, 0.05f, 1.f)
+	Renderer::Renderer(VkDeviceSize dynamicVertexBufferSize, uint32_t workerThreadCount)
+		: m_clearColour(0.05f, 0.05f, 0.05f, 1.f),
+		p_workerPool(std::make_unique<ThreadPool>(workerThreadCount))
 	{
-		createCommandBuffers();
 		createSyncObjects();
+		createRecordSlots(p_workerPool->GetThreadCount() + 1);
+		createRecordTargets((uint32_t)Core::GetCore().GetSwapchain()->GetSwapchainFrameBuffers().size());
+
+		p_dynamicVertexBuffer = std::make_unique<RingBuffer>(dynamicVertexBufferSize,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+		createQuadIndexBuffer(DEFAULT_QUAD_INDEX_CAPACITY);
 
 		m_windowCloseEvent = std::bind(&Renderer::windowCloseEvent, std::ref(*this), 
 			std::placeholders::_1);
 
 		ZWindow::GetDispatchers().WindowClosed.Attach(m_windowCloseEvent);
+
+		m_swapchainRecreateEvent = std::bind(&Renderer::swapchainRecreateEvent, std::ref(*this),
+			std::placeholders::_1);
+
+		Core::GetCore().GetSwapchainRecreateDispatcher().Attach(m_swapchainRecreateEvent);
 	}
 
 	Renderer::~Renderer()
@@ -25,6 +39,18 @@ namespace ZVK
 		ZDevice* pDevice = Core::GetCore().GetDevice();
 
 		ZWindow::GetDispatchers().WindowClosed.Detach(m_windowCloseEvent);
+		Core::GetCore().GetSwapchainRecreateDispatcher().Detach(m_swapchainRecreateEvent);
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+			destroyBuffers(i);
+
+		// Destroying a pool frees its command buffers
+		for (RecordSlot& slot : m_recordSlots)
+			for (VkCommandPool cmdPool : slot.CmdPools)
+				vkDestroyCommandPool(pDevice->GetDevice(), cmdPool, nullptr);
+
+		vkDestroyBuffer(pDevice->GetDevice(), m_quadIndexBuffer, nullptr);
+		vkFreeMemory(pDevice->GetDevice(), m_quadIndexMemory, nullptr);
 
 		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 		{
@@ -38,25 +64,48 @@ namespace ZVK
 	{
 		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
 		ZDevice* pDevice = Core::GetCore().GetDevice();
-		
-		VkResult result = vkAcquireNextImageKHR(pDevice->GetDevice(), pSwapchain->GetSwapchain(),
-			UINT64_MAX, m_availableSemaphores[m_curFrame], VK_NULL_HANDLE, &m_imageIndex);
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			pSwapchain->RecreateSwapchain();
-			return;
-		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		m_frameStats.FrameMicroseconds = m_frameTimer.Restart();
+
+		// Only the frame that last used this frame index has to be done,
+		// the other frames in flight keep running on the GPU while this one is recorded
+		m_fenceWaitTimer.Restart();
+		vkWaitForFences(pDevice->GetDevice(), 1, &m_renderFences[m_curFrame], VK_TRUE, UINT64_MAX);
+		m_frameStats.FenceWaitMicroseconds = m_fenceWaitTimer.Restart();
+		
+		// Offscreen there's only the one image and nothing to wait on before rendering into it
+		if (pSwapchain->IsOffscreen())
+			m_imageIndex = 0;
+		else
 		{
-			throw std::runtime_error("Failed to aquire swapchain image!");
+			VkResult result = vkAcquireNextImageKHR(pDevice->GetDevice(), pSwapchain->GetSwapchain(),
+				UINT64_MAX, m_availableSemaphores[m_curFrame], VK_NULL_HANDLE, &m_imageIndex);
+
+			if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				pSwapchain->RecreateSwapchain();
+				return;
+			}
+			else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			{
+				throw std::runtime_error("Failed to aquire swapchain image!");
+			}
 		}
 
+		// Reset only once an image was acquired, otherwise the next Begin would wait on a fence that's never signaled
 		vkResetFences(pDevice->GetDevice(), 1, &m_renderFences[m_curFrame]);
 
-		vkResetCommandBuffer(m_cmdBuffers[m_curFrame], 0);
+		// The fence was waited on so this frame index's ring region, buffers and slots are free to reuse
+		p_dynamicVertexBuffer->BeginFrame(m_curFrame);
+		Core::GetCore().GetTextureRegistry()->BeginFrame();
+		destroyBuffers(m_curFrame);
 
-		beginFlush();
+		// The swapchain might have been recreated with more images
+		uint32_t imageCount = (uint32_t)pSwapchain->GetSwapchainFrameBuffers().size();
+		if (imageCount * MAX_FRAMES_IN_FLIGHT > (uint32_t)m_recordTargets.size())
+			createRecordTargets(imageCount);
+
+		m_curTarget = m_imageIndex * MAX_FRAMES_IN_FLIGHT + m_curFrame;
 	}
 
 	void Renderer::End()
@@ -76,14 +125,29 @@ namespace ZVK
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_cmdBuffers[m_curFrame];
+		submitInfo.pCommandBuffers = &GetCurrentCommandBuffer();
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphore;
 
+		// Nothing was acquired or will be presented offscreen
+		if (pSwapchain->IsOffscreen())
+		{
+			submitInfo.waitSemaphoreCount = 0;
+			submitInfo.signalSemaphoreCount = 0;
+		}
+
 		if (vkQueueSubmit(pDevice->GetGraphicsQueue(), 1,
 			&submitInfo, m_renderFences[m_curFrame]) != VK_SUCCESS)
 			throw std::runtime_error("Failed to submit draw command buffer!");
 
+		m_isFrameSubmitted = true;
+
+		if (pSwapchain->IsOffscreen())
+		{
+			m_curFrame = (m_curFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+			return;
+		}
+
 		VkPresentInfoKHR presentInfo{};
 		VkSwapchainKHR swapchains[] = { pSwapchain->GetSwapchain() };
 
@@ -105,23 +169,83 @@ namespace ZVK
 		else if (result != VK_SUCCESS)
 			throw std::runtime_error("Failed to create present swapchain");
 
-		vkWaitForFences(pDevice->GetDevice(), 1, &m_renderFences[m_curFrame], VK_TRUE, UINT64_MAX);
-
-		for (RenderCmd* renderCmd : m_updateVertexCmds)
-			if (renderCmd != nullptr)
-				renderCmd->Execute();
-
 		m_curFrame = (m_curFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 	}
 
+	void Renderer::ReadPixels(std::vector<uint8_t>& pixels)
+	{
+		Core& core = Core::GetCore();
+		ZSwapchain* pSwapchain = core.GetSwapchain();
+		ZDevice* pDevice = core.GetDevice();
+
+		if (!pSwapchain->IsOffscreen())
+			throw std::runtime_error("Pixels can only be read back in headless mode!");
+
+		if (!m_isFrameSubmitted)
+			throw std::runtime_error("No frame has been rendered to read back!");
+
+		VkExtent2D extent = pSwapchain->GetSwapchainExtent();
+		VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * 4;
+
+		VkBuffer readbackBuffer;
+		VkDeviceMemory readbackMemory;
+
+		core.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			readbackBuffer, readbackMemory);
+
+		// Submitted after the last frame, the render pass makes the copy wait for its resolve
+		VkCommandBuffer cmdBuffer = core.BeginSingleTimeCommands();
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(cmdBuffer, pSwapchain->GetSwapchainImages()[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			readbackBuffer, 1, &region);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = readbackBuffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+			0, nullptr, 1, &barrier, 0, nullptr);
+
+		core.EndSingleTimeCommands(cmdBuffer);
+
+		pixels.resize((size_t)size);
+
+		void* pData;
+		vkMapMemory(pDevice->GetDevice(), readbackMemory, 0, size, 0, &pData);
+		memcpy(pixels.data(), pData, (size_t)size);
+		vkUnmapMemory(pDevice->GetDevice(), readbackMemory);
+
+		vkDestroyBuffer(pDevice->GetDevice(), readbackBuffer, nullptr);
+		vkFreeMemory(pDevice->GetDevice(), readbackMemory, nullptr);
+	}
+
 	void Renderer::beginFlush()
 	{
-		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+		ZDevice* pDevice = Core::GetCore().GetDevice();
 
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color =
-		{ { m_clearColour.x, m_clearColour.y, m_clearColour.z, m_clearColour.w } };
-		clearValues[1].depthStencil = { 1.f, 0 };
+		// The target was last submitted with this frame index so its command buffers are done
+		for (RecordSlot& slot : m_recordSlots)
+			vkResetCommandPool(pDevice->GetDevice(), slot.CmdPools[m_curTarget], 0);
+
+		vkResetCommandBuffer(GetCurrentCommandBuffer(), 0);
 
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -130,6 +254,53 @@ namespace ZVK
 
 		if (vkBeginCommandBuffer(GetCurrentCommandBuffer(), &beginInfo) != VK_SUCCESS)
 			throw std::runtime_error("Failed to begin command buffer!");
+	}
+
+	void Renderer::endFlush()
+	{
+		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+
+		m_drawPackets.clear();
+
+		// Copies can't be recorded inside of a render pass so
+		// the render pass is only started once the systems have uploaded their data and added their packets
+		for (UpdateVertexFnc& updateFnc : m_updateVertexFncs)
+			if (updateFnc)
+				updateFnc();
+
+		sortDrawPackets();
+
+		if (m_isRecordCacheStale)
+		{
+			for (RecordTarget& staleTarget : m_recordTargets)
+				staleTarget.IsCached = false;
+
+			m_isRecordCacheStale = false;
+		}
+
+		RecordTarget& target = m_recordTargets[m_curTarget];
+
+		uint64_t stateHash = 0;
+		bool isCacheable = hashRecordState(stateHash);
+
+		if (isCacheable && target.IsCached && target.StateHash == stateHash)
+		{
+			// Nothing the target recorded has changed so it's submitted again as it is
+			++m_recordCacheStats.HitCount;
+			m_encoderStats = EncoderStats();
+			return;
+		}
+
+		++m_recordCacheStats.RecordCount;
+
+		beginFlush();
+
+		recordUploads();
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color =
+		{ { m_clearColour.x, m_clearColour.y, m_clearColour.z, m_clearColour.w } };
+		clearValues[1].depthStencil = { 1.f, 0 };
 
 		VkRenderPassBeginInfo renderPassBeginInfo{};
 		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -141,34 +312,516 @@ namespace ZVK
 		renderPassBeginInfo.pClearValues = clearValues.data();
 
 		vkCmdBeginRenderPass(GetCurrentCommandBuffer(),
-			&renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-	}
+			&renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	void Renderer::endFlush()
-	{
-		for (RenderCmd* renderCmd : m_renderCmds)
-			if (renderCmd != nullptr)
-				renderCmd->Execute();
+		// The sorted packets are split into contiguous ranges that are recorded at the same time,
+		// executing the ranges' command buffers in order keeps the sorted order
+		uint32_t packetCount = (uint32_t)m_packetOrder.size();
+		uint32_t rangeCount = std::min((uint32_t)m_recordSlots.size(),
+			(packetCount + MIN_RECORDED_DRAW_PACKET_COUNT - 1) / MIN_RECORDED_DRAW_PACKET_COUNT);
+
+		p_workerPool->ParallelFor(rangeCount, 1, [&](uint32_t firstRange, uint32_t endRange)
+			{
+				for (uint32_t range = firstRange; range < endRange; ++range)
+					recordDrawPackets(range, (uint32_t)((uint64_t)packetCount * range / rangeCount),
+						(uint32_t)((uint64_t)packetCount * (range + 1) / rangeCount));
+			});
+
+		m_executedCmdBuffers.clear();
+		m_encoderStats = EncoderStats();
+
+		for (uint32_t range = 0; range < rangeCount; ++range)
+		{
+			const RecordSlot& slot = m_recordSlots[range];
+
+			m_executedCmdBuffers.insert(m_executedCmdBuffers.end(),
+				slot.ExecutedCmdBuffers.begin(), slot.ExecutedCmdBuffers.end());
+
+			m_encoderStats.IssuedCount += slot.Encoder.GetStats().IssuedCount;
+			m_encoderStats.SkippedCount += slot.Encoder.GetStats().SkippedCount;
+		}
+
+		if (!m_executedCmdBuffers.empty())
+			vkCmdExecuteCommands(GetCurrentCommandBuffer(),
+				(uint32_t)m_executedCmdBuffers.size(), m_executedCmdBuffers.data());
 
 		vkCmdEndRenderPass(GetCurrentCommandBuffer());
 
 		if (vkEndCommandBuffer(GetCurrentCommandBuffer()) != VK_SUCCESS)
 			throw std::runtime_error("Failed to end command buffer");
+
+		// A buffer destroyed while recording might be in this target too
+		target.StateHash = stateHash;
+		target.IsCached = isCacheable && !m_isRecordCacheStale;
+	}
+
+	bool Renderer::hashRecordState(uint64_t& stateHash) const
+	{
+		// Uploads are copied from this frame's part of the dynamic vertex buffer
+		if (!m_uploads.empty()) return false;
+
+		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+
+		RecordHash hash;
+		hash.Add(pSwapchain->GetRenderPass());
+		hash.Add(pSwapchain->GetSwapchainFrameBuffers()[m_imageIndex]);
+		hash.Add(pSwapchain->GetSwapchainExtent());
+		hash.Add(m_clearColour);
+		hash.Add(m_quadIndexBuffer);
+		hash.Add(Core::GetCore().GetTextureRegistry()->GetDescriptorSet());
+
+		// A packet's bytes are everything it records
+		for (uint32_t packetIndex : m_packetOrder)
+		{
+			const DrawPacket& packet = m_drawPackets[packetIndex];
+
+			if (packet.IsTransient) return false;
+
+			hash.Add(packet);
+		}
+
+		stateHash = hash.Get();
+		return true;
+	}
+
+	void Renderer::sortDrawPackets()
+	{
+		// The systems add their packets in the same order every frame, so when nothing
+		// changed layer or depth the keys come in already sorted
+		m_packetOrder.resize(m_drawPackets.size());
+		m_packetSortKeys.resize(m_drawPackets.size());
+
+		for (uint32_t i = 0; i < (uint32_t)m_drawPackets.size(); ++i)
+		{
+			m_packetOrder[i] = i;
+			m_packetSortKeys[i] = m_drawPackets[i].SortKey;
+		}
+
+		m_packetSorter.Sort(m_packetSortKeys, m_packetOrder);
+	}
+
+	void Renderer::UploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset,
+		const void* pData, VkDeviceSize size)
+	{
+		if (size == 0) return;
+
+		RingAllocation allocation = p_dynamicVertexBuffer->Allocate(size, 4);
+		memcpy(allocation.pData, pData, size);
+
+		BufferUpload upload;
+		upload.SrcBuffer = allocation.Buffer;
+		upload.DstBuffer = dstBuffer;
+		upload.Region.srcOffset = allocation.Offset;
+		upload.Region.dstOffset = dstOffset;
+		upload.Region.size = size;
+
+		m_uploads.push_back(upload);
+	}
+
+	void Renderer::DestroyBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory)
+	{
+		m_destroyedBuffers[m_curFrame].emplace_back(buffer, bufferMemory);
+		m_isRecordCacheStale = true;
+	}
+
+	void Renderer::RecordDrawPacket(CommandEncoder& encoder, const DrawPacket& packet)
+	{
+		encoder.SetViewport(packet.Viewport);
+		encoder.SetScissor(packet.Scissor);
+
+		encoder.BindPipeline(packet.Pipeline);
+
+		if (packet.DescriptorSetCount > 0)
+			encoder.BindDescriptorSets(packet.PipelineLayout, 0, packet.DescriptorSetCount, packet.DescriptorSets);
+
+		if (packet.PushConstantSize > 0)
+			encoder.PushConstants(packet.PipelineLayout, packet.PushConstantStages, 0, packet.PushConstantSize,
+				packet.PushConstants);
+
+		encoder.BindVertexBuffer(packet.VertexBuffer, packet.VertexOffset);
+
+		if (packet.Type == DrawPacketType::DRAW_INDEXED)
+		{
+			encoder.BindIndexBuffer(packet.IndexBuffer, packet.IndexOffset, packet.IndexType);
+
+			vkCmdDrawIndexed(encoder.GetCommandBuffer(), packet.Count, packet.InstanceCount,
+				packet.FirstIndex, packet.BaseVertex, 0);
+		}
+		else
+			vkCmdDraw(encoder.GetCommandBuffer(), packet.Count, packet.InstanceCount, 0, 0);
+	}
+
+	void Renderer::SetQuadIndexBuffer(DrawPacket& packet, uint32_t quadCount)
+	{
+		if (quadCount > m_quadIndexCapacity)
+		{
+			uint32_t newCapacity = m_quadIndexCapacity * 2;
+			while (newCapacity < quadCount)
+				newCapacity *= 2;
+
+			createQuadIndexBuffer(newCapacity);
+		}
+
+		packet.IndexBuffer = m_quadIndexBuffer;
+
+		if (quadCount <= MAX_UINT16_QUAD_COUNT)
+		{
+			packet.IndexOffset = 0;
+			packet.IndexType = VK_INDEX_TYPE_UINT16;
+		}
+		else
+		{
+			packet.IndexOffset = m_quadIndexUint32Offset;
+			packet.IndexType = VK_INDEX_TYPE_UINT32;
+		}
+	}
+
+	void Renderer::SetQuadIndices(DrawPacket& packet, const uint32_t* pQuadOrder, uint32_t quadCount)
+	{
+		RingAllocation allocation = p_dynamicVertexBuffer->Allocate(sizeof(uint32_t) * 6 * quadCount, 4);
+		uint32_t* pIndices = (uint32_t*)allocation.pData;
+
+		for (uint32_t i = 0; i < quadCount; ++i)
+		{
+			uint32_t vertex = pQuadOrder[i] * 4;
+
+			pIndices[0] = vertex;
+			pIndices[1] = vertex + 1;
+			pIndices[2] = vertex + 2;
+			pIndices[3] = vertex + 2;
+			pIndices[4] = vertex + 3;
+			pIndices[5] = vertex;
+
+			pIndices += 6;
+		}
+
+		packet.IndexBuffer = allocation.Buffer;
+		packet.IndexOffset = allocation.Offset;
+		packet.IndexType = VK_INDEX_TYPE_UINT32;
+		packet.IsTransient = VK_TRUE;
+	}
+
+	VkCommandBuffer Renderer::AllocateSecondaryCommandBuffer()
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = Core::GetCore().GetCmdPool();
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer cmdBuffer;
+
+		if (vkAllocateCommandBuffers(Core::GetCore().GetDevice()->GetDevice(),
+			&allocInfo, &cmdBuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate secondary command buffer!");
+
+		return cmdBuffer;
+	}
+
+	void Renderer::FreeCommandBuffer(VkCommandBuffer cmdBuffer)
+	{
+		m_freedCmdBuffers[m_curFrame].push_back(cmdBuffer);
+		m_isRecordCacheStale = true;
+	}
+
+	void Renderer::BeginSecondaryCommandBuffer(VkCommandBuffer cmdBuffer, bool isReusable)
+	{
+		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = pSwapchain->GetRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = isReusable ?
+			VK_NULL_HANDLE : pSwapchain->GetSwapchainFrameBuffers()[m_imageIndex];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		// A reusable command buffer can be executed by the kept command buffers of more than one
+		// record target, without simultaneous use recording it into a second one invalidates the first
+		beginInfo.flags |= isReusable ? VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT :
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(cmdBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("Failed to begin secondary command buffer!");
+	}
+
+	void Renderer::SetWorkerThreadCount(uint32_t workerThreadCount)
+	{
+		p_workerPool = std::make_unique<ThreadPool>(workerThreadCount);
+		createRecordSlots(workerThreadCount + 1);
+	}
+
+	void Renderer::recordDrawPackets(uint32_t slotIndex, uint32_t firstPacket, uint32_t endPacket)
+	{
+		RecordSlot& slot = m_recordSlots[slotIndex];
+
+		slot.CmdBufferCount = 0;
+		slot.ExecutedCmdBuffers.clear();
+		slot.Encoder.ResetStats();
+
+		beginSlotCmdBuffer(slotIndex);
+
+		for (uint32_t i = firstPacket; i < endPacket; ++i)
+		{
+			const DrawPacket& packet = m_drawPackets[m_packetOrder[i]];
+
+			if (packet.Type != DrawPacketType::EXECUTE)
+			{
+				RecordDrawPacket(slot.Encoder, packet);
+				continue;
+			}
+
+			// The packets recorded so far have to come before it
+			endSlotCmdBuffer(slotIndex);
+
+			slot.ExecutedCmdBuffers.push_back(packet.CmdBuffer);
+
+			beginSlotCmdBuffer(slotIndex);
+		}
+
+		endSlotCmdBuffer(slotIndex);
 	}
 
-	void Renderer::createCommandBuffers()
+	void Renderer::beginSlotCmdBuffer(uint32_t slotIndex)
 	{
-		m_cmdBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		RecordSlot& slot = m_recordSlots[slotIndex];
+		std::vector<VkCommandBuffer>& cmdBuffers = slot.CmdBuffers[m_curTarget];
+
+		if (slot.CmdBufferCount == (uint32_t)cmdBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = slot.CmdPools[m_curTarget];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer cmdBuffer;
+
+			if (vkAllocateCommandBuffers(Core::GetCore().GetDevice()->GetDevice(),
+				&allocInfo, &cmdBuffer) != VK_SUCCESS)
+				throw std::runtime_error("Failed to allocate secondary command buffer!");
+
+			cmdBuffers.push_back(cmdBuffer);
+		}
+
+		VkCommandBuffer cmdBuffer = cmdBuffers[slot.CmdBufferCount++];
+
+		// The target might be submitted again so it can't be one time submit
+		BeginSecondaryCommandBuffer(cmdBuffer, true);
+		slot.Encoder.Reset(cmdBuffer);
+	}
+
+	void Renderer::endSlotCmdBuffer(uint32_t slotIndex)
+	{
+		RecordSlot& slot = m_recordSlots[slotIndex];
+
+		if (vkEndCommandBuffer(slot.Encoder.GetCommandBuffer()) != VK_SUCCESS)
+			throw std::runtime_error("Failed to end secondary command buffer!");
+
+		slot.ExecutedCmdBuffers.push_back(slot.Encoder.GetCommandBuffer());
+	}
+
+	void Renderer::recordUploads()
+	{
+		if (m_uploads.empty()) return;
+
+		VkCommandBuffer cmdBuffer = GetCurrentCommandBuffer();
+
+		// Earlier frames might still be reading from the ranges we're about to overwrite
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+		// Group the copies so each buffer only needs one copy command
+		std::stable_sort(m_uploads.begin(), m_uploads.end(),
+			[](const BufferUpload& lhs, const BufferUpload& rhs)
+			{
+				if (lhs.DstBuffer != rhs.DstBuffer)
+					return lhs.DstBuffer < rhs.DstBuffer;
+
+				return lhs.SrcBuffer < rhs.SrcBuffer;
+			});
+
+		std::vector<VkBufferCopy> regions;
+		regions.reserve(m_uploads.size());
+
+		for (size_t i = 0; i < m_uploads.size(); ++i)
+		{
+			regions.push_back(m_uploads[i].Region);
+
+			bool isLast = i + 1 == m_uploads.size() ||
+				m_uploads[i + 1].DstBuffer != m_uploads[i].DstBuffer ||
+				m_uploads[i + 1].SrcBuffer != m_uploads[i].SrcBuffer;
+
+			if (!isLast) continue;
+
+			vkCmdCopyBuffer(cmdBuffer, m_uploads[i].SrcBuffer, m_uploads[i].DstBuffer,
+				(uint32_t)regions.size(), regions.data());
+
+			regions.clear();
+		}
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		m_uploads.clear();
+	}
+
+	void Renderer::destroyBuffers(uint32_t frameIndex)
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		for (auto& [buffer, bufferMemory] : m_destroyedBuffers[frameIndex])
+		{
+			vkDestroyBuffer(pDevice->GetDevice(), buffer, nullptr);
+			vkFreeMemory(pDevice->GetDevice(), bufferMemory, nullptr);
+		}
+
+		m_destroyedBuffers[frameIndex].clear();
+
+		if (!m_freedCmdBuffers[frameIndex].empty())
+			vkFreeCommandBuffers(pDevice->GetDevice(), Core::GetCore().GetCmdPool(),
+				(uint32_t)m_freedCmdBuffers[frameIndex].size(), m_freedCmdBuffers[frameIndex].data());
+
+		m_freedCmdBuffers[frameIndex].clear();
+	}
+
+	void Renderer::createQuadIndexBuffer(uint32_t quadCapacity)
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		// Packets added earlier this frame might use the old buffer
+		if (m_quadIndexBuffer != VK_NULL_HANDLE)
+			DestroyBuffer(m_quadIndexBuffer, m_quadIndexMemory);
+
+		uint32_t uint16QuadCount = std::min(quadCapacity, (uint32_t)MAX_UINT16_QUAD_COUNT);
+		uint32_t uint32QuadCount = quadCapacity > MAX_UINT16_QUAD_COUNT ? quadCapacity : 0;
+
+		// Keeps the 32 bit indices 4 byte aligned
+		m_quadIndexUint32Offset = (sizeof(uint16_t) * 6 * uint16QuadCount + 3) & ~(VkDeviceSize)3;
+		m_quadIndexCapacity = quadCapacity;
+
+		VkDeviceSize bufferSize = m_quadIndexUint32Offset + sizeof(uint32_t) * 6 * uint32QuadCount;
+
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+
+		Core::GetCore().CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			stagingBuffer, stagingBufferMemory);
+
+		void* data;
+		vkMapMemory(pDevice->GetDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
+
+		uint16_t* pUint16Indices = (uint16_t*)data;
+		uint32_t* pUint32Indices = (uint32_t*)((char*)data + m_quadIndexUint32Offset);
+
+		for (uint32_t quad = 0; quad < uint16QuadCount; ++quad)
+		{
+			uint16_t offset = (uint16_t)(quad * 4);
+
+			pUint16Indices[quad * 6 + 0] = offset;
+			pUint16Indices[quad * 6 + 1] = offset + 1;
+			pUint16Indices[quad * 6 + 2] = offset + 2;
+			pUint16Indices[quad * 6 + 3] = offset + 2;
+			pUint16Indices[quad * 6 + 4] = offset + 3;
+			pUint16Indices[quad * 6 + 5] = offset;
+		}
+
+		for (uint32_t quad = 0; quad < uint32QuadCount; ++quad)
+		{
+			uint32_t offset = quad * 4;
+
+			pUint32Indices[quad * 6 + 0] = offset;
+			pUint32Indices[quad * 6 + 1] = offset + 1;
+			pUint32Indices[quad * 6 + 2] = offset + 2;
+			pUint32Indices[quad * 6 + 3] = offset + 2;
+			pUint32Indices[quad * 6 + 4] = offset + 3;
+			pUint32Indices[quad * 6 + 5] = offset;
+		}
+
+		vkUnmapMemory(pDevice->GetDevice(), stagingBufferMemory);
+
+		// Never written again so it lives in device local memory
+		Core::GetCore().CreateBuffer(bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_quadIndexBuffer, m_quadIndexMemory);
+
+		Core::GetCore().CopyBuffer(stagingBuffer, m_quadIndexBuffer, bufferSize);
+
+		vkDestroyBuffer(pDevice->GetDevice(), stagingBuffer, nullptr);
+		vkFreeMemory(pDevice->GetDevice(), stagingBufferMemory, nullptr);
+	}
+
+	void Renderer::createRecordSlots(uint32_t slotCount)
+	{
+		if (slotCount <= (uint32_t)m_recordSlots.size()) return;
+
+		m_recordSlots.resize(slotCount);
+
+		createRecordPools();
+	}
+
+	void Renderer::createRecordTargets(uint32_t imageCount)
+	{
+		uint32_t firstNewTarget = (uint32_t)m_recordTargets.size();
+		uint32_t targetCount = imageCount * MAX_FRAMES_IN_FLIGHT;
+
+		if (targetCount <= firstNewTarget) return;
+
+		m_recordTargets.resize(targetCount);
+
+		std::vector<VkCommandBuffer> cmdBuffers(targetCount - firstNewTarget);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = Core::GetCore().GetCmdPool();
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)m_cmdBuffers.size();
+		allocInfo.commandBufferCount = (uint32_t)cmdBuffers.size();
 
 		if (vkAllocateCommandBuffers(Core::GetCore().GetDevice()->GetDevice(),
-			&allocInfo, m_cmdBuffers.data()) != VK_SUCCESS)
+			&allocInfo, cmdBuffers.data()) != VK_SUCCESS)
 			throw std::runtime_error("Failed to allocate command buffers!");
+
+		for (uint32_t i = firstNewTarget; i < targetCount; ++i)
+			m_recordTargets[i].CmdBuffer = cmdBuffers[i - firstNewTarget];
+
+		createRecordPools();
+	}
+
+	void Renderer::createRecordPools()
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+		QueueFamilyIndices queueFamilyIndices = pDevice->FindQueueFamilies(pDevice->GetPhysicalDevice());
+
+		// The pools are reset as a whole so their command buffers don't need to be reset one at a time
+		VkCommandPoolCreateInfo cmdPoolInfo{};
+		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolInfo.flags = 0;
+		cmdPoolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+		for (RecordSlot& slot : m_recordSlots)
+		{
+			while (slot.CmdPools.size() < m_recordTargets.size())
+			{
+				VkCommandPool cmdPool;
+
+				if (vkCreateCommandPool(pDevice->GetDevice(), &cmdPoolInfo, nullptr, &cmdPool) != VK_SUCCESS)
+					throw std::runtime_error("Failed to create command pool!");
+
+				slot.CmdPools.push_back(cmdPool);
+			}
+
+			slot.CmdBuffers.resize(m_recordTargets.size());
+		}
 	}
 
 	void Renderer::createSyncObjects()
@@ -200,4 +853,10 @@ namespace ZVK
 	{
 		vkDeviceWaitIdle(Core::GetCore().GetDevice()->GetDevice());
 	}
+
+	void Renderer::swapchainRecreateEvent(SwapchainRecreateEvent& e)
+	{
+		// The pipelines and framebuffers the kept command buffers use are recreated too
+		m_isRecordCacheStale = true;
+	}
 }
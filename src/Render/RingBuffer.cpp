@@ -0,0 +1,103 @@
+#include "../../Headers/Render/RingBuffer.h"
+
+#include <stdexcept>
+
+#include "../../Headers/Core/Core.h"
+
+namespace ZVK
+{
+	RingBuffer::RingBuffer(VkDeviceSize regionSize, VkBufferUsageFlags usage)
+		: m_usage(usage), m_regionSize(regionSize)
+	{
+		createBuffer(regionSize);
+	}
+
+	RingBuffer::~RingBuffer()
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		for (RetiredBuffer& retired : m_retiredBuffers)
+		{
+			vkUnmapMemory(pDevice->GetDevice(), retired.Memory);
+			vkDestroyBuffer(pDevice->GetDevice(), retired.Buffer, nullptr);
+			vkFreeMemory(pDevice->GetDevice(), retired.Memory, nullptr);
+		}
+
+		vkUnmapMemory(pDevice->GetDevice(), m_memory);
+		vkDestroyBuffer(pDevice->GetDevice(), m_buffer, nullptr);
+		vkFreeMemory(pDevice->GetDevice(), m_memory, nullptr);
+	}
+
+	void RingBuffer::BeginFrame(uint32_t frameIndex)
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		m_frameIndex = frameIndex % MAX_FRAMES_IN_FLIGHT;
+		m_head = 0;
+
+		for (size_t i = 0; i < m_retiredBuffers.size();)
+		{
+			RetiredBuffer& retired = m_retiredBuffers[i];
+
+			if (--retired.FramesLeft > 0)
+			{
+				++i;
+				continue;
+			}
+
+			vkUnmapMemory(pDevice->GetDevice(), retired.Memory);
+			vkDestroyBuffer(pDevice->GetDevice(), retired.Buffer, nullptr);
+			vkFreeMemory(pDevice->GetDevice(), retired.Memory, nullptr);
+
+			m_retiredBuffers[i] = m_retiredBuffers.back();
+			m_retiredBuffers.pop_back();
+		}
+	}
+
+	RingAllocation RingBuffer::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		VkDeviceSize offset = (m_head + alignment - 1) & ~(alignment - 1);
+
+		if (offset + size > m_regionSize)
+		{
+			grow(size);
+			offset = 0;
+		}
+
+		m_head = offset + size;
+
+		RingAllocation allocation;
+		allocation.Buffer = m_buffer;
+		allocation.Offset = m_regionSize * m_frameIndex + offset;
+		allocation.pData = (char*)p_mapped + allocation.Offset;
+
+		return allocation;
+	}
+
+	void RingBuffer::createBuffer(VkDeviceSize regionSize)
+	{
+		m_regionSize = regionSize;
+
+		Core::GetCore().CreateBuffer(m_regionSize * MAX_FRAMES_IN_FLIGHT, m_usage,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_buffer, m_memory);
+
+		// Mapped for the lifetime of the buffer
+		if (vkMapMemory(Core::GetCore().GetDevice()->GetDevice(), m_memory, 0,
+			m_regionSize * MAX_FRAMES_IN_FLIGHT, 0, &p_mapped) != VK_SUCCESS)
+			throw std::runtime_error("Failed to map ring buffer memory!");
+	}
+
+	void RingBuffer::grow(VkDeviceSize minRegionSize)
+	{
+		// Commands recorded this frame (and the frames still in flight) may use the old buffer
+		m_retiredBuffers.push_back({ m_buffer, m_memory, MAX_FRAMES_IN_FLIGHT });
+
+		VkDeviceSize newRegionSize = m_regionSize * 2;
+		while (newRegionSize < minRegionSize)
+			newRegionSize *= 2;
+
+		createBuffer(newRegionSize);
+		m_head = 0;
+	}
+}
@@ -0,0 +1,61 @@
+#include "../../Headers/Render/SortKey.h"
+
+#include <utility>
+
+namespace ZVK
+{
+	bool RadixSorter::Sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+	{
+		size_t count = keys.size();
+		m_sortedPassCount = 0;
+
+		size_t firstUnsorted = 1;
+		while (firstUnsorted < count && keys[firstUnsorted - 1] <= keys[firstUnsorted])
+			++firstUnsorted;
+
+		if (firstUnsorted >= count)
+			return false;
+
+		// Every pass's histogram is counted up front so constant bytes can be skipped
+		uint32_t histograms[8][256] = {};
+
+		for (uint64_t key : keys)
+			for (uint32_t pass = 0; pass < 8; ++pass)
+				++histograms[pass][(key >> (pass * 8)) & 0xFF];
+
+		m_keyScratch.resize(count);
+		m_valueScratch.resize(count);
+
+		for (uint32_t pass = 0; pass < 8; ++pass)
+		{
+			uint32_t* pHistogram = histograms[pass];
+			uint32_t shift = pass * 8;
+
+			if (pHistogram[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < 256; ++digit)
+			{
+				uint32_t digitCount = pHistogram[digit];
+				pHistogram[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint32_t dst = pHistogram[(keys[i] >> shift) & 0xFF]++;
+
+				m_keyScratch[dst] = keys[i];
+				m_valueScratch[dst] = values[i];
+			}
+
+			keys.swap(m_keyScratch);
+			values.swap(m_valueScratch);
+
+			++m_sortedPassCount;
+		}
+
+		return true;
+	}
+}
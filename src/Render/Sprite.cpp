@@ -241,5 +241,7 @@ namespace ZVK
 			m_uvInfo.y = (float)(m_subPos.y + m_subDimensions.y) / (float)p_texture->GetHeight();
 			m_uvInfo.w = (float)m_subPos.y / (float)p_texture->GetHeight();
 		}
+
+		++m_version;
 	}
 }
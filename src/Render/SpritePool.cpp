@@ -0,0 +1,217 @@
+#include "../../Headers/Render/SpritePool.h"
+
+#include <stdexcept>
+
+#include "../../Headers/Core/Core.h"
+
+namespace ZVK
+{
+	SpriteHandle SpritePool::Create(Vec2 pos, Vec2 dimensions, const std::shared_ptr<Texture2D>& texture,
+		Vec4 colour, float z)
+	{
+		uint32_t handleIndex;
+
+		if (!m_freeHandleIndices.empty())
+		{
+			handleIndex = m_freeHandleIndices.back();
+			m_freeHandleIndices.pop_back();
+		}
+		else
+		{
+			if (m_indices.size() >= MAX_SPRITE_POOL_SIZE)
+				throw std::runtime_error("Sprite pool is full!");
+
+			handleIndex = (uint32_t)m_indices.size();
+			m_indices.push_back(0);
+			m_generations.push_back(0);
+		}
+
+		SpriteHandle handle = (m_generations[handleIndex] << SPRITE_HANDLE_INDEX_BITS) | handleIndex;
+
+		m_indices[handleIndex] = (uint32_t)m_handles.size();
+		m_handles.push_back(handle);
+
+		m_posX.push_back(pos.x);
+		m_posY.push_back(pos.y);
+		m_z.push_back(z);
+		m_width.push_back(dimensions.x);
+		m_height.push_back(dimensions.y);
+		m_rotation.push_back(0.f);
+		m_scaleX.push_back(1.f);
+		m_scaleY.push_back(1.f);
+		m_colours.push_back(colour);
+		m_uvInfos.push_back({ 1.f, 1.f, 0.f, 0.f });
+		m_textureSlots.push_back(INVALID_TEXTURE_SLOT);
+		m_textures.push_back(nullptr);
+
+		if (texture)
+			SetTexture(handle, texture);
+
+		return handle;
+	}
+
+	void SpritePool::Destroy(SpriteHandle handle)
+	{
+		if (!IsAlive(handle)) return;
+
+		uint32_t handleIndex = handle & SPRITE_HANDLE_INDEX_MASK;
+		uint32_t index = m_indices[handleIndex];
+		uint32_t last = (uint32_t)m_handles.size() - 1;
+
+		// The last sprite fills the hole so the columns stay packed
+		if (index != last)
+		{
+			m_handles[index] = m_handles[last];
+			m_indices[m_handles[index] & SPRITE_HANDLE_INDEX_MASK] = index;
+
+			m_posX[index] = m_posX[last];
+			m_posY[index] = m_posY[last];
+			m_z[index] = m_z[last];
+			m_width[index] = m_width[last];
+			m_height[index] = m_height[last];
+			m_rotation[index] = m_rotation[last];
+			m_scaleX[index] = m_scaleX[last];
+			m_scaleY[index] = m_scaleY[last];
+			m_colours[index] = m_colours[last];
+			m_uvInfos[index] = m_uvInfos[last];
+			m_textureSlots[index] = m_textureSlots[last];
+			m_textures[index] = std::move(m_textures[last]);
+		}
+
+		m_handles.pop_back();
+		m_posX.pop_back();
+		m_posY.pop_back();
+		m_z.pop_back();
+		m_width.pop_back();
+		m_height.pop_back();
+		m_rotation.pop_back();
+		m_scaleX.pop_back();
+		m_scaleY.pop_back();
+		m_colours.pop_back();
+		m_uvInfos.pop_back();
+		m_textureSlots.pop_back();
+		m_textures.pop_back();
+
+		m_generations[handleIndex] = (m_generations[handleIndex] + 1) & SPRITE_HANDLE_GENERATION_MASK;
+		m_freeHandleIndices.push_back(handleIndex);
+	}
+
+	void SpritePool::Clear()
+	{
+		// Every live handle has to stop working
+		for (SpriteHandle handle : m_handles)
+		{
+			uint32_t handleIndex = handle & SPRITE_HANDLE_INDEX_MASK;
+
+			m_generations[handleIndex] = (m_generations[handleIndex] + 1) & SPRITE_HANDLE_GENERATION_MASK;
+			m_freeHandleIndices.push_back(handleIndex);
+		}
+
+		m_handles.clear();
+		m_posX.clear();
+		m_posY.clear();
+		m_z.clear();
+		m_width.clear();
+		m_height.clear();
+		m_rotation.clear();
+		m_scaleX.clear();
+		m_scaleY.clear();
+		m_colours.clear();
+		m_uvInfos.clear();
+		m_textureSlots.clear();
+		m_textures.clear();
+	}
+
+	void SpritePool::Reserve(uint32_t count)
+	{
+		m_handles.reserve(count);
+		m_posX.reserve(count);
+		m_posY.reserve(count);
+		m_z.reserve(count);
+		m_width.reserve(count);
+		m_height.reserve(count);
+		m_rotation.reserve(count);
+		m_scaleX.reserve(count);
+		m_scaleY.reserve(count);
+		m_colours.reserve(count);
+		m_uvInfos.reserve(count);
+		m_textureSlots.reserve(count);
+		m_textures.reserve(count);
+	}
+
+	bool SpritePool::IsAlive(SpriteHandle handle) const
+	{
+		uint32_t handleIndex = handle & SPRITE_HANDLE_INDEX_MASK;
+
+		return handle != INVALID_SPRITE_HANDLE && handleIndex < (uint32_t)m_indices.size() &&
+			m_generations[handleIndex] == handle >> SPRITE_HANDLE_INDEX_BITS;
+	}
+
+	void SpritePool::SetSubRect(SpriteHandle handle, Vec2ui subPos, Vec2ui subDimensions)
+	{
+		uint32_t i = GetIndex(handle);
+		const std::shared_ptr<Texture2D>& texture = m_textures[i];
+
+		if (!texture || subDimensions.x == 0 || subDimensions.y == 0) return;
+
+		float width = (float)texture->GetWidth();
+		float height = (float)texture->GetHeight();
+
+		m_uvInfos[i] = {
+			(float)(subPos.x + subDimensions.x) / width, (float)(subPos.y + subDimensions.y) / height,
+			(float)subPos.x / width, (float)subPos.y / height
+		};
+	}
+
+	void SpritePool::SetTexture(SpriteHandle handle, const std::shared_ptr<Texture2D>& texture)
+	{
+		uint32_t i = GetIndex(handle);
+
+		m_textures[i] = texture;
+		m_textureSlots[i] = texture ?
+			Core::GetCore().GetTextureRegistry()->Register(*texture) : INVALID_TEXTURE_SLOT;
+	}
+
+	void SpritePool::SetPositions(const SpriteHandle* pHandles, const Vec2* pPositions, uint32_t count)
+	{
+		for (uint32_t j = 0; j < count; ++j)
+		{
+			uint32_t i = GetIndex(pHandles[j]);
+
+			m_posX[i] = pPositions[j].x;
+			m_posY[i] = pPositions[j].y;
+		}
+	}
+
+	void SpritePool::SetRotations(const SpriteHandle* pHandles, const float* pRotations, uint32_t count)
+	{
+		for (uint32_t j = 0; j < count; ++j)
+			m_rotation[GetIndex(pHandles[j])] = pRotations[j];
+	}
+
+	void SpritePool::SetScales(const SpriteHandle* pHandles, const Vec2* pScales, uint32_t count)
+	{
+		for (uint32_t j = 0; j < count; ++j)
+		{
+			uint32_t i = GetIndex(pHandles[j]);
+
+			m_scaleX[i] = pScales[j].x;
+			m_scaleY[i] = pScales[j].y;
+		}
+	}
+
+	void SpritePool::SetColours(const SpriteHandle* pHandles, const Vec4* pColours, uint32_t count)
+	{
+		for (uint32_t j = 0; j < count; ++j)
+			m_colours[GetIndex(pHandles[j])] = pColours[j];
+	}
+
+	void SpritePool::Translate(Vec2 offset)
+	{
+		for (float& x : m_posX)
+			x += offset.x;
+
+		for (float& y : m_posY)
+			y += offset.y;
+	}
+}
@@ -34,8 +34,22 @@ namespace ZVK
 		CreateFrameBuffers();
 	}
 
+	void ZSwapchain::CreateOffscreen(VkExtent2D extent)
+	{
+		m_isOffscreen = true;
+		m_swapchainExtent = extent;
+
+		Create();
+	}
+
 	void ZSwapchain::CreateSwapchain()
 	{
+		if (m_isOffscreen)
+		{
+			createOffscreenImage();
+			return;
+		}
+
 		const ZDevice* device = Core::GetCore().GetDevice();
 
 		SwapchainSupportDetails swapchainSupport = querySwapchainSupport(device->GetPhysicalDevice());
@@ -97,6 +111,23 @@ namespace ZVK
 		m_swapchainExtent = extent;
 	}
 
+	void ZSwapchain::createOffscreenImage()
+	{
+		// The format the swapchain prefers so offscreen frames match the ones in a window
+		m_swapchainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+		VkImage image;
+
+		Core::GetCore().CreateImage(
+			m_swapchainExtent.width, m_swapchainExtent.height, 1, VK_SAMPLE_COUNT_1_BIT,
+			m_swapchainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, m_offscreenImageMemory
+		);
+
+		m_swapchainImages = { image };
+	}
+
 	void ZSwapchain::CreateImageViews()
 	{
 		m_swapchainImageViews.resize(m_swapchainImages.size());
@@ -156,7 +187,8 @@ namespace ZVK
 		colourAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colourAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colourAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colourAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colourAttachmentResolve.finalLayout = m_isOffscreen ?
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = Core::GetCore().FindDepthFormat();
@@ -198,6 +230,17 @@ namespace ZVK
 		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
 			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+		// Offscreen the image is copied from after the render pass, the copy has to wait for the resolve
+		VkSubpassDependency readbackDependency{};
+		readbackDependency.srcSubpass = 0;
+		readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		std::array<VkSubpassDependency, 2> dependencies = { dependency, readbackDependency };
+
 		std::array<VkAttachmentDescription, 3> attachments =
 		{ colourAttachment, depthAttachment, colourAttachmentResolve };
 
@@ -207,8 +250,8 @@ namespace ZVK
 		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+		renderPassInfo.dependencyCount = m_isOffscreen ? 2 : 1;
+		renderPassInfo.pDependencies = dependencies.data();
 
 		if (vkCreateRenderPass(Core::GetCore().GetDevice()->GetDevice(), &renderPassInfo,
 			nullptr, &m_renderpass) != VK_SUCCESS)
@@ -250,7 +293,13 @@ namespace ZVK
 		for (size_t i = 0; i < m_swapchainImageViews.size(); ++i)
 			vkDestroyImageView(pDevice->GetDevice(), m_swapchainImageViews[i], nullptr);
 
-		vkDestroySwapchainKHR(pDevice->GetDevice(), m_swapchain, nullptr);
+		if (m_isOffscreen)
+		{
+			vkDestroyImage(pDevice->GetDevice(), m_swapchainImages[0], nullptr);
+			vkFreeMemory(pDevice->GetDevice(), m_offscreenImageMemory, nullptr);
+		}
+		else
+			vkDestroySwapchainKHR(pDevice->GetDevice(), m_swapchain, nullptr);
 
 		vkDestroyImageView(pDevice->GetDevice(), m_colourImageView, nullptr);
 		vkDestroyImage(pDevice->GetDevice(), m_colourImage, nullptr);
@@ -261,7 +310,7 @@ namespace ZVK
 		vkFreeMemory(pDevice->GetDevice(), m_depthImageMemory, nullptr);
 
 		SwapchainCleanupEvent e;
-		if(!Core::GetCore().GetWindow().ShouldClose())
+		if(!m_isOffscreen && !Core::GetCore().GetWindow().ShouldClose())
 			Core::GetCore().GetSwapchainCleanupDispatcher().Notify(e);
 
 		for (size_t i = 0; i < m_swapchainFrameBuffers.size(); ++i)
@@ -2,24 +2,41 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string.h>
+#include <math.h>
 
 #include <cassert>
 
-#define MAX_QUAD_COUNT 880
-#define MAX_VERTEX_COUNT MAX_QUAD_COUNT * 4
-#define MAX_INDEX_COUNT MAX_QUAD_COUNT * 6
+// Instances a batch's buffer can hold when it's first created, it doubles every time it's outgrown
+#define MIN_BATCH_INSTANCE_CAPACITY 256
+
+// Dirty slots at most this many slots apart are uploaded with one copy
+#define DIRTY_SLOT_MERGE_GAP 8
+
+// Changed shapes each worker thread builds at least, fewer than this aren't worth waking a thread for
+#define MIN_PARALLEL_SHAPE_COUNT 2048
+
+// Immediate instances reserved from the dynamic vertex buffer at a time
+#define IMMEDIATE_CHUNK_INSTANCE_COUNT 1024
+
+// Miter joins longer than this many times half the thickness are beveled instead
+#define LINE_MITER_LIMIT 4.f
+
+// Batches use their ID as the state of their sort keys, immediate draws come after all of them
+#define IMMEDIATE_SORT_STATE_ID 0xFFFF
 
 namespace ZVK
 {
 	ShapeRenderer::ShapeRenderer(Renderer& renderer, ShapePipeline* pPipeline)
-		: m_renderer(renderer), p_pipeline(pPipeline)
+		: m_renderer(renderer), p_pipeline(pPipeline),
+		m_immediateShapes(sizeof(ShapeInstance), IMMEDIATE_CHUNK_INSTANCE_COUNT)
 	{
 		init();
 	}
 
 	ShapeRenderer::ShapeRenderer(Renderer& renderer, const std::string& vertPath,
 		const std::string& fragPath)
-		: m_renderer(renderer)
+		: m_renderer(renderer), m_immediateShapes(sizeof(ShapeInstance), IMMEDIATE_CHUNK_INSTANCE_COUNT)
 	{
 		try
 		{
@@ -38,40 +55,23 @@ namespace ZVK
 	{
 		ZDevice* pDevice = Core::GetCore().GetDevice();
 
-		for (auto cmd : m_uploadUpdatedVerticesCmds)
+		m_renderer.RemoveUpdateVertexFnc(m_uploadFncID);
+
+		for (auto& batch : m_batches)
 		{
-			m_renderer.RemoveUpdateVertexCmd(cmd);
-			if (cmd)
+			if (batch.RenderInfo.Buffer != VK_NULL_HANDLE)
 			{
-				delete cmd;
-				cmd = nullptr;
+				vkDestroyBuffer(pDevice->GetDevice(), batch.RenderInfo.Buffer, nullptr);
+				vkFreeMemory(pDevice->GetDevice(), batch.RenderInfo.BufferMemory, nullptr);
 			}
-		}
 
-		for (auto cmd : m_shapeRendererCmds)
-		{
-			m_renderer.RemoveRenderCmd(cmd);
-			if (cmd)
+			if (batch.RenderInfo.SortedBuffer != VK_NULL_HANDLE)
 			{
-				delete cmd;
-				cmd = nullptr;
+				vkDestroyBuffer(pDevice->GetDevice(), batch.RenderInfo.SortedBuffer, nullptr);
+				vkFreeMemory(pDevice->GetDevice(), batch.RenderInfo.SortedBufferMemory, nullptr);
 			}
 		}
 
-		for (auto& renderData : m_renderInfos)
-		{
-			vkDestroyBuffer(pDevice->GetDevice(), renderData.Buffer, nullptr);
-			vkFreeMemory(pDevice->GetDevice(), renderData.BufferMemory, nullptr);
-		}
-
-		if (m_uboCreated)
-		{
-			vkDestroyBuffer(pDevice->GetDevice(), m_uniformBuffer, nullptr);
-			vkFreeMemory(pDevice->GetDevice(), m_uniformMemory, nullptr);
-		}
-
-		vkDestroyDescriptorPool(pDevice->GetDevice(), m_descriptorPool, nullptr);
-
 		if (m_canDeletePipeline)
 		{
 			if (p_pipeline)
@@ -84,9 +84,6 @@ namespace ZVK
 
 	void ShapeRenderer::init()
 	{
-		createUniformBuffer();
-		createDescriptorPool();
-
 		m_swapchainRecreateEvent = std::bind(&ShapeRenderer::swapchainRecreateEvent,
 			std::ref(*this), std::placeholders::_1);
 
@@ -104,666 +101,930 @@ namespace ZVK
 			m_scissorExtent = Core::GetCore().GetSwapchain()->GetSwapchainExtent();
 		}
 
-		allocateDescriptorInfo();
-		updateDescriptorWrites();
+		m_uploadFncID = m_renderer.AddUpdateVertexFnc([this]() { uploadBatches(); });
+
+		SetImmediateLayer(m_immediateLayer);
 	}
 
-	void ShapeRenderer::allocateDescriptorInfo()
+	void ShapeRenderer::Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Mat4& mvp,
+		bool canUpdateVertexBuffer)
 	{
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = m_descriptorPool;
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = p_pipeline->GetDescriptorSetLayoutPtr();
+		if (shapes.empty()) return;
 
-		if (vkAllocateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
-			&allocInfo, &m_descriptorSet) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate descriptor sets!");
+		DrawBatch(loadList(shapes, canUpdateVertexBuffer), mvp);
+	}
 
-		p_pipeline->SetIsDescriptorSetAllocated(true);
+	void ShapeRenderer::Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Camera& cam,
+		bool canUpdateVertexBuffer)
+	{
+		if (shapes.empty()) return;
+
+		DrawBatch(loadList(shapes, canUpdateVertexBuffer), cam);
 	}
 
-	void ShapeRenderer::updateDescriptorWrites()
+	BatchID ShapeRenderer::GetListBatch(std::vector<std::shared_ptr<IShape>>& shapes,
+		const bool canUpdateVertexBuffer)
 	{
-		std::array<VkWriteDescriptorSet, 1> setWrites{};
+		return loadList(shapes, canUpdateVertexBuffer);
+	}
 
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_uniformBuffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(ShapeUniformBufferObject);
+	BatchID ShapeRenderer::loadList(std::vector<std::shared_ptr<IShape>>& shapes,
+		const bool canUpdateVertexBuffer)
+	{
+		auto shapeList = m_loadedLists.find(&shapes);
 
-		setWrites[0] = {};
-		setWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		setWrites[0].dstBinding = 0;
-		setWrites[0].dstArrayElement = 0;
-		setWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		setWrites[0].descriptorCount = 1;
-		setWrites[0].pBufferInfo = &bufferInfo;
-		setWrites[0].dstSet = m_descriptorSet;
+		if (shapeList == m_loadedLists.end())
+		{
+			m_loadedLists[&shapes] = { (uint32_t)shapes.size(), CreateBatch(canUpdateVertexBuffer) };
+			shapeList = m_loadedLists.find(&shapes);
+		}
+		else if (shapeList->second.ListSize != (uint32_t)shapes.size())
+		{
+			// Only this list's batch is rebuilt, its buffers are reused
+			ClearBatch(shapeList->second.Index);
 
-		vkUpdateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
-			static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+			shapeList->second.ListSize = (uint32_t)shapes.size();
+			shapeList->second.IsListAdded = false;
+		}
+
+		ListInfo& listInfo = shapeList->second;
+
+		if (!listInfo.IsListAdded)
+		{
+			for (const std::shared_ptr<IShape>& shape : shapes)
+				AddShape(listInfo.Index, shape);
+
+			listInfo.IsListAdded = true;
+		}
+
+		return listInfo.Index;
 	}
 
-	void ShapeRenderer::createUniformBuffer()
+	BatchID ShapeRenderer::CreateBatch(const bool canUpdateVertexBuffer)
 	{
-		VkDeviceSize bufferSize = sizeof(ShapeUniformBufferObject);
+		BatchID batchID;
+
+		if (!m_freeBatchIDs.empty())
+		{
+			batchID = m_freeBatchIDs.back();
+			m_freeBatchIDs.pop_back();
+		}
+		else
+		{
+			batchID = (BatchID)m_batches.size();
+			m_batches.push_back(ShapeBatch{});
+		}
+
+		ShapeBatch& batch = m_batches[batchID];
 
-		Core::GetCore().CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			m_uniformBuffer, m_uniformMemory);
+		batch.CanUpdateVertices = canUpdateVertexBuffer;
+		batch.IsAlive = true;
 
-		m_uboCreated = true;
+		return batchID;
 	}
 
-	void ShapeRenderer::createDescriptorPool()
+	void ShapeRenderer::DestroyBatch(BatchID batchID)
 	{
-		std::array<VkDescriptorPoolSize, 1> poolSizes{};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = 1;
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = 1;
-		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		ShapeBatch& batch = m_batches[batchID];
 
-		if (vkCreateDescriptorPool(Core::GetCore().GetDevice()->GetDevice(), &poolInfo,
-			nullptr, &m_descriptorPool) != VK_SUCCESS)
-			throw std::runtime_error("Failed to create descriptor pool!");
+		// Frames in flight might still be drawing the batch
+		if (batch.RenderInfo.Buffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(batch.RenderInfo.Buffer, batch.RenderInfo.BufferMemory);
+
+		if (batch.RenderInfo.SortedBuffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(batch.RenderInfo.SortedBuffer, batch.RenderInfo.SortedBufferMemory);
+
+		removeBatchDraws(batchID);
+
+		batch = ShapeBatch{};
+		m_freeBatchIDs.push_back(batchID);
 	}
 
-	void ShapeRenderer::Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Mat4& mvp,
-		bool canUpdateVertexBuffer)
+	void ShapeRenderer::ClearBatch(BatchID batchID)
 	{
-		if (shapes.empty()) return;
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-		auto shapeList = m_loadedLists.find(&shapes);
-		bool isFound = false;
+		ShapeBatch& batch = m_batches[batchID];
 
-		if (shapeList == m_loadedLists.end())
+		batch.Shapes.clear();
+		batch.Versions.clear();
+		batch.Slots.Clear();
+
+		batch.Bounds.Clear();
+		batch.BoundsVersions.clear();
+		batch.Visible.clear();
+
+		batch.RenderInfo.Instances.clear();
+		batch.RenderInfo.InstanceCount = 0;
+		batch.RenderInfo.DirtySlots.clear();
+		batch.RenderInfo.DrawOrder.clear();
+
+		removeBatchDraws(batchID);
+	}
+
+	BatchHandle ShapeRenderer::AddShape(BatchID batchID, const std::shared_ptr<IShape>& shape)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive)
+			throw std::runtime_error("Can't add a shape to a batch that doesn't exist!");
+
+		ShapeBatch& batch = m_batches[batchID];
+
+		uint32_t slot = batch.Slots.Allocate();
+
+		if (slot >= (uint32_t)batch.Shapes.size())
 		{
-			m_loadedLists[&shapes] = { (uint32_t)shapes.size(), m_listCount++ };
-			shapeList = m_loadedLists.find(&shapes);
+			batch.Shapes.resize(slot + 1);
+			batch.Versions.resize(slot + 1);
+
+			batch.Bounds.Resize(slot + 1);
+			batch.BoundsVersions.resize(slot + 1);
+			batch.Visible.resize(slot + 1);
 		}
-		else if (shapeList->second.ListSize != (uint32_t)shapes.size())
-		{
-			// This is inefficient but it works
-			for (ShapeRendererCmd* rCmd : m_shapeRendererCmds)
-			{
-				m_renderer.RemoveRenderCmd(rCmd);
 
-				if (rCmd != nullptr)
-				{
-					delete rCmd;
-					rCmd = nullptr;
-				}
-			}
+		batch.Shapes[slot] = shape;
 
-			for (UploadUpdatedShapeVerticesCmd* updateVCmd : m_uploadUpdatedVerticesCmds)
-			{
-				m_renderer.RemoveUpdateVertexCmd(updateVCmd);
+		RenderData& rData = batch.RenderInfo;
 
-				if (updateVCmd != nullptr)
-				{
-					delete updateVCmd;
-					updateVCmd = nullptr;
-				}
-			}
+		if (slot >= rData.InstanceCount)
+		{
+			rData.InstanceCount = slot + 1;
+			rData.Instances.resize(rData.InstanceCount);
 
-			for (auto& renderData : m_renderInfos)
-			{
-				vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), renderData.Buffer, nullptr);
-				vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), renderData.BufferMemory, nullptr);
-			}
+			if (rData.InstanceCount > rData.InstanceCapacity)
+				growRenderData(rData, rData.InstanceCount);
+		}
 
-			changedListIndex = shapeList->second.Index;
+		populateInstance(batch, slot);
 
-			m_shapeRendererCmds.clear();
-			m_uploadUpdatedVerticesCmds.clear();
-			m_renderInfos.clear();
-			m_updateVerticesCmds.clear();
-			m_listCount = 0;
-			shapeList->second.ListSize = (uint32_t)shapes.size();
+		return { batchID, slot };
+	}
 
-			for (auto& [key, val] : m_loadedLists)
-				val.IsListAdded = false;
+	void ShapeRenderer::RemoveShape(BatchHandle handle)
+	{
+		if (!handle.IsValid() || handle.Batch >= (BatchID)m_batches.size()) return;
 
-			return;
-		}
-		else if (shapeList->second.IsListAdded == true)
-			isFound = true;
+		ShapeBatch& batch = m_batches[handle.Batch];
 
-		if (changedListIndex >= 0 && shapeList->second.Index > changedListIndex)
+		if (!batch.IsAlive || handle.Slot >= (uint32_t)batch.Shapes.size() || !batch.Shapes[handle.Slot])
 			return;
-		else if (shapeList->second.Index == changedListIndex)
-			changedListIndex = -1;
 
-		if (!isFound)
-		{
-			// Add new list to the render data and create a new one if we go over the max quad count
-			if (!m_renderInfos.empty() &&
-				m_renderInfos[m_renderInfos.size() - 1].ShapeCount < MAX_QUAD_COUNT)
-			{
-				uint32_t renderIndex = (uint32_t)m_renderInfos.size() - 1;
+		batch.Shapes[handle.Slot] = nullptr;
+		batch.Slots.Free(handle.Slot);
 
-				RenderData& rData = m_renderInfos[renderIndex];
+		batch.Bounds.SetEmpty(handle.Slot);
 
-				uint32_t shapeIndex = 0;
+		RenderData& rData = batch.RenderInfo;
 
-				if (rData.ShapeCount + (uint32_t)shapes.size() > MAX_QUAD_COUNT)
-				{
-					// Make sure we caculate for a list size greater than MAX_QUAD_COUNT
-					// We also need to account for a list size less than MAX_QUAD_COUNT
+		// A zeroed instance has no area so nothing is drawn until the slot is reused
+		rData.Instances[handle.Slot] = ShapeInstance{};
 
-					std::vector<std::shared_ptr<IShape>> tempShapes;
+		rData.MarkDirty(handle.Slot);
+	}
 
-					uint32_t amountAdded = 0;
-					for (size_t i = 0; rData.ShapeCount + i < MAX_QUAD_COUNT; ++i)
-					{
-						tempShapes.push_back(shapes[i]);
-						++amountAdded;
-					}
+	void ShapeRenderer::UpdateShape(BatchHandle handle)
+	{
+		if (!handle.IsValid() || handle.Batch >= (BatchID)m_batches.size()) return;
 
-					rData.ShapeInfos.push_back(ShapeData{});
-					shapeIndex = (uint32_t)m_renderInfos[renderIndex].ShapeInfos.size() - 1;
+		ShapeBatch& batch = m_batches[handle.Batch];
 
-					rData.ShapeInfos[shapeIndex].canUpdateVertices = canUpdateVertexBuffer;
+		if (!batch.IsAlive || handle.Slot >= (uint32_t)batch.Shapes.size() || !batch.Shapes[handle.Slot])
+			return;
+
+		populateInstance(batch, handle.Slot);
+	}
+
+	void ShapeRenderer::DrawBatch(BatchID batchID, const Mat4& mvp)
+	{
+		drawBatch(batchID, mvp, nullptr);
+	}
 
-					populateVertices(tempShapes, renderIndex, shapeIndex);
+	void ShapeRenderer::DrawBatch(BatchID batchID, const Mat4& mvp, const Vec4& visibleRect)
+	{
+		drawBatch(batchID, mvp, &visibleRect);
+	}
 
-					if (canUpdateVertexBuffer)
-						std::copy(tempShapes.begin(), tempShapes.end(), std::back_inserter(rData.Shapes));
+	void ShapeRenderer::DrawBatch(BatchID batchID, const Camera& cam)
+	{
+		Vec4 visibleRect = cam.GetVisibleRect();
+		drawBatch(batchID, cam.GetPV(), &visibleRect);
+	}
 
-					rData.ShapeCount += (uint32_t)tempShapes.size();
+	void ShapeRenderer::drawBatch(BatchID batchID, const Mat4& mvp, const Vec4* pVisibleRect)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-					std::vector<std::shared_ptr<IShape>> 
-						newShapes(std::next(shapes.begin() + amountAdded - 1), shapes.end());
+		ShapeBatch& batch = m_batches[batchID];
+		RenderData& rData = batch.RenderInfo;
+		uint32_t slotCount = (uint32_t)batch.Shapes.size();
 
-					ShapeRendererCmd* cmd = new ShapeRendererCmd(this, (uint32_t)shapes.size() * 6,
-						renderIndex, shapeIndex);
-					m_shapeRendererCmds.push_back(cmd);
-					m_renderer.AddRenderCmd(cmd);
+		BatchDraw batchDraw;
+		batchDraw.Batch = batchID;
+		batchDraw.View = makeView(mvp);
+		batchDraw.IsCulled = pVisibleRect != nullptr;
 
-					if (amountAdded != shapes.size())
-						drawRecursive(newShapes, canUpdateVertexBuffer);
-				}
-				else
+		if (batchDraw.IsCulled)
+		{
+			// Bounds are cheaper to keep current than instances so they're updated for every change
+			if (batch.CanUpdateVertices)
+			{
+				for (uint32_t slot = 0; slot < slotCount; ++slot)
 				{
-					rData.ShapeInfos.push_back(ShapeData{});
+					const std::shared_ptr<IShape>& shape = batch.Shapes[slot];
 
-					shapeIndex = (uint32_t)m_renderInfos[renderIndex].ShapeInfos.size() - 1;
+					if (!shape || shape->GetVersion() == batch.BoundsVersions[slot]) continue;
 
-					populateVertices(shapes, renderIndex, shapeIndex);
+					batch.Bounds.Set(slot, *shape);
+					batch.BoundsVersions[slot] = shape->GetVersion();
+				}
+			}
 
-					if (canUpdateVertexBuffer)
-						std::copy(shapes.begin(), shapes.end(), std::back_inserter(rData.Shapes));
+			uint32_t visibleCount = CullQuadBounds(batch.Bounds, slotCount, *pVisibleRect, batch.Visible.data());
 
-					rData.ShapeInfos[shapeIndex].canUpdateVertices = canUpdateVertexBuffer;
+			m_frameCullStats.TestedCount += batch.Slots.GetUsedCount();
+			m_frameCullStats.CulledCount += batch.Slots.GetUsedCount() - visibleCount;
+		}
 
-					rData.ShapeCount += (uint32_t)shapes.size();
+		// Only shapes that were changed since their instances were built are rebuilt
+		if (batch.CanUpdateVertices)
+		{
+			m_changedSlots.clear();
 
-					ShapeRendererCmd* cmd = new ShapeRendererCmd(this, (uint32_t)shapes.size() * 6,
-						renderIndex, shapeIndex);
-					m_shapeRendererCmds.push_back(cmd);
-					m_renderer.AddRenderCmd(cmd);
-				}
+			for (uint32_t slot = 0; slot < slotCount; ++slot)
+			{
+				if (!batch.Shapes[slot] || batch.Shapes[slot]->GetVersion() == batch.Versions[slot]) continue;
+
+				// Culled shapes keep their old version so they're rebuilt once they're visible
+				if (batchDraw.IsCulled && !batch.Visible[slot]) continue;
+
+				m_changedSlots.push_back(slot);
 			}
-			else
-				drawRecursive(shapes, canUpdateVertexBuffer);
 
-			shapeList->second.IsListAdded = true;
+			// Each range only writes the instances and versions of its own slots
+			m_renderer.GetWorkerPool()->ParallelFor((uint32_t)m_changedSlots.size(), MIN_PARALLEL_SHAPE_COUNT,
+				[this, &batch](uint32_t begin, uint32_t end)
+				{ buildInstances(batch, &m_changedSlots[begin], end - begin); });
+
+			rData.DirtySlots.insert(rData.DirtySlots.end(), m_changedSlots.begin(), m_changedSlots.end());
 		}
 
-		for (auto updateVCmd : m_updateVerticesCmds)
-			updateVCmd->Execute();
+		if (batchDraw.IsCulled)
+		{
+			batchDraw.FirstVisibleSlot = (uint32_t)m_visibleSlots.size();
+
+			for (uint32_t slot = 0; slot < slotCount; ++slot)
+				if (batch.Visible[slot]) m_visibleSlots.push_back(slot);
 
-		updateUBO(mvp);
+			batchDraw.VisibleSlotCount = (uint32_t)m_visibleSlots.size() - batchDraw.FirstVisibleSlot;
+		}
+
+		m_batchDraws.push_back(batchDraw);
 	}
 
-	void ShapeRenderer::Draw(std::vector<std::shared_ptr<IShape>>& shapes, const Camera& cam,
-		bool canUpdateVertexBuffer)
+	void ShapeRenderer::removeBatchDraws(BatchID batchID)
 	{
-		Draw(shapes, cam.GetPV(), canUpdateVertexBuffer);
+		m_batchDraws.erase(std::remove_if(m_batchDraws.begin(), m_batchDraws.end(),
+			[batchID](const BatchDraw& batchDraw) { return batchDraw.Batch == batchID; }), m_batchDraws.end());
 	}
 
-	void ShapeRenderer::drawRecursive(std::vector<std::shared_ptr<IShape>>& shapes, bool canUpdateVertexBuffer)
+	uint32_t ShapeRenderer::GetBatchSize(BatchID batchID) const
 	{
-		if (shapes.size() == 0) return;
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return 0;
 
-		// Create render data for the shape list 
-		// and create more if we go past the max quad count
-		m_renderInfos.push_back(RenderData{});
-		size_t index = m_renderInfos.size() - 1;
+		return m_batches[batchID].Slots.GetUsedCount();
+	}
 
-		size_t shapeSize = (shapes.size() > MAX_QUAD_COUNT) ? MAX_QUAD_COUNT : shapes.size();
+	void ShapeRenderer::SetBatchLayer(BatchID batchID, uint8_t layer)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-		std::vector<std::shared_ptr<IShape>> tempShapes(shapes.begin(), std::next(shapes.begin() + shapeSize - 1));
+		m_batches[batchID].Layer = layer;
+	}
 
-		m_renderInfos[index].ShapeInfos.push_back(ShapeData{});
-		populateVertices(tempShapes, (uint32_t)index, 0);
+	void ShapeRenderer::SetBatchBlendMode(BatchID batchID, BlendMode blendMode)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-		ShapeRendererCmd* cmd = new ShapeRendererCmd(this, (uint32_t)shapes.size() * 6,
-			(uint32_t)index, 0);
-		m_shapeRendererCmds.push_back(cmd);
-		m_renderer.AddRenderCmd(cmd);
+		m_batches[batchID].Blend = blendMode;
+	}
 
-		m_renderInfos[index].ShapeCount = (uint32_t)shapeSize;
+	void ShapeRenderer::SetImmediateLayer(uint8_t layer)
+	{
+		m_immediateLayer = layer;
 
-		if (canUpdateVertexBuffer)
-		{ 
-			m_renderInfos[index].Shapes.resize(shapeSize);
-			m_renderInfos[index].Shapes.assign(tempShapes.begin(), tempShapes.end());
+		m_immediateSortKey = MakeSortKey(m_immediateLayer, BlendMode::CUTOUT, p_pipeline->GetID(),
+			IMMEDIATE_SORT_STATE_ID, 0.f);
+	}
 
-			m_renderInfos[index].ShapeInfos[0].canUpdateVertices = true;
+	void ShapeRenderer::DrawQuad(const Vec3& pos, const Vec2& size, const Vec4& colour, const Mat4& mvp,
+		float rotation)
+	{
+		ShapeInstance* pInstance = (ShapeInstance*)m_immediateShapes.Begin(
+			*m_renderer.GetDynamicVertexBuffer(), 1, makeView(mvp));
 
-			m_updateVerticesCmds.emplace_back(std::make_unique<UpdateVerticesCmd>(*this,
-				m_renderInfos[index].Shapes, (uint32_t)index));
-		}
+		float halfW = size.x / 2.f;
+		float halfH = size.y / 2.f;
 
-		UploadUpdatedShapeVerticesCmd* uploadUpdatedCmd =
-			new UploadUpdatedShapeVerticesCmd(this, (uint32_t)index);
-		m_uploadUpdatedVerticesCmds.push_back(uploadUpdatedCmd);
-		m_renderer.AddUpdateVertexCmd(uploadUpdatedCmd);
+		// Same rotation as a shape's z rotation, see QuadCornerBatch
+		float sinZ = rotation == 0.f ? 0.f : sinf(rotation);
+		float cosZ = rotation == 0.f ? 1.f : cosf(rotation);
 
-		if (shapes.size() < MAX_QUAD_COUNT)
-			return;
+		pInstance->center = Vec2(pos.x + halfW, pos.y + halfH);
+		pInstance->axisX = Vec2(cosZ * halfW, -sinZ * halfW);
+		pInstance->axisY = Vec2(sinZ * halfH, cosZ * halfH);
+		pInstance->depth = PackDepth(pos.z);
+		pInstance->shapeType = (uint16_t)ShapeType::RECTANGLE;
+		pInstance->colour = PackColour(colour);
+		pInstance->params = Vec4(0.f, 0.f, 0.f, 0.f);
 
-		std::vector<std::shared_ptr<IShape>> newShapes;
-		newShapes.reserve(shapes.size() - MAX_QUAD_COUNT);
-		for (size_t i = MAX_QUAD_COUNT; i < shapes.size(); ++i)
-			newShapes.push_back(shapes[i]);
+		m_immediateShapes.End(1);
+	}
 
-		drawRecursive(newShapes, canUpdateVertexBuffer);
+	void ShapeRenderer::DrawCircle(const Vec3& center, float radius, const Vec4& colour, const Mat4& mvp,
+		float thickness, float fade)
+	{
+		ShapeInstance* pInstance = (ShapeInstance*)m_immediateShapes.Begin(
+			*m_renderer.GetDynamicVertexBuffer(), 1, makeView(mvp));
+
+		pInstance->center = Vec2(center.x, center.y);
+		pInstance->axisX = Vec2(radius, 0.f);
+		pInstance->axisY = Vec2(0.f, radius);
+		pInstance->depth = PackDepth(center.z);
+		pInstance->shapeType = (uint16_t)ShapeType::CIRCLE;
+		pInstance->colour = PackColour(colour);
+		pInstance->params = Vec4(thickness, fade, 0.f, 0.f);
+
+		m_immediateShapes.End(1);
+	}
+
+	// Returns the depth to use and moves the next one a step towards the camera
+	static int16_t takeLineDepth(int16_t& depth)
+	{
+		int16_t current = depth;
+
+		if (depth > -32767)
+			--depth;
+
+		return current;
+	}
+
+	// The quad leaves room for round caps at both ends whatever the cap is, see Shape.frag
+	static void writeSegment(ShapeInstance& instance, const Vec2& start, const Vec2& end, float radius,
+		LineCap cap, int16_t depth, uint32_t colour)
+	{
+		float dx = end.x - start.x;
+		float dy = end.y - start.y;
+		float length = sqrtf(dx * dx + dy * dy);
+
+		// A point still needs a direction for its cap
+		float dirX = length > 0.f ? dx / length : 1.f;
+		float dirY = length > 0.f ? dy / length : 0.f;
+
+		float halfWidth = length / 2.f + radius;
+
+		instance.center = Vec2((start.x + end.x) / 2.f, (start.y + end.y) / 2.f);
+		instance.axisX = Vec2(dirX * halfWidth, dirY * halfWidth);
+		instance.axisY = Vec2(-dirY * radius, dirX * radius);
+		instance.depth = depth;
+		instance.shapeType = (uint16_t)ShapeType::LINE;
+		instance.colour = colour;
+		instance.params = Vec4(0.f, 0.f, (float)cap, 0.f);
 	}
 
-	void ShapeRenderer::draw(uint32_t indexCount, uint32_t renderDataIndex,
-		uint32_t shapeDataIndex)
+	static void writeTriangle(ShapeInstance& instance, Vec2 a, Vec2 b, Vec2 c, int16_t depth, uint32_t colour)
 	{
-		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+		auto lengthSq = [](const Vec2& from, const Vec2& to)
+		{
+			float dx = to.x - from.x;
+			float dy = to.y - from.y;
+			return dx * dx + dy * dy;
+		};
 
-		RenderData& rData = m_renderInfos[renderDataIndex];
-		ShapeData& sData = rData.ShapeInfos[shapeDataIndex];
+		// The longest edge is the base so the apex is always above it, a to b is the base and c the apex
+		if (lengthSq(b, c) > lengthSq(a, b) && lengthSq(b, c) >= lengthSq(c, a))
+		{
+			Vec2 apex = a; a = b; b = c; c = apex;
+		}
+		else if (lengthSq(c, a) > lengthSq(a, b))
+		{
+			Vec2 apex = b; b = a; a = c; c = apex;
+		}
 
-		VkViewport viewport{};
-		viewport.x = m_viewportInfo.x;
-		viewport.y = m_viewportInfo.y;
-		viewport.width = m_viewportInfo.z;
-		viewport.height = m_viewportInfo.w;
-		viewport.minDepth = 0.f;
-		viewport.maxDepth = 1.f;
+		float baseLength = sqrtf(lengthSq(a, b));
 
-		VkRect2D scissor{};
-		scissor.offset = { m_scissorOffset.x, m_scissorOffset.y };
-		scissor.extent = m_scissorExtent;
+		if (baseLength == 0.f)
+		{
+			instance = ShapeInstance{};
+			return;
+		}
 
-		vkCmdSetViewport(m_renderer.GetCurrentCommandBuffer(), 0, 1, &viewport);
-		vkCmdSetScissor(m_renderer.GetCurrentCommandBuffer(), 0, 1, &scissor);
+		float baseX = (b.x - a.x) / baseLength;
+		float baseY = (b.y - a.y) / baseLength;
+		float upX = -baseY;
+		float upY = baseX;
 
-		vkCmdBindPipeline(m_renderer.GetCurrentCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS, p_pipeline->GetPipeline());
+		float midX = (a.x + b.x) / 2.f;
+		float midY = (a.y + b.y) / 2.f;
 
-		vkCmdBindDescriptorSets(m_renderer.GetCurrentCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS, p_pipeline->GetPipelineLayout(),
-			0, 1, &m_descriptorSet, 0, 0);
+		float height = (c.x - a.x) * upX + (c.y - a.y) * upY;
 
-		VkBuffer vertexBuffers[] = { rData.Buffer };
-		VkDeviceSize offsets[] = { sData.StartVertex };
+		if (height < 0.f)
+		{
+			upX = -upX;
+			upY = -upY;
+			height = -height;
+		}
 
-		vkCmdBindVertexBuffers(m_renderer.GetCurrentCommandBuffer(), 0, 1, vertexBuffers, offsets);
+		float halfBase = baseLength / 2.f;
+		float halfHeight = height / 2.f;
 
-		vkCmdBindIndexBuffer(m_renderer.GetCurrentCommandBuffer(),
-			rData.Buffer, sData.StartIndex,
-			VK_INDEX_TYPE_UINT32);
+		instance.center = Vec2(midX + upX * halfHeight, midY + upY * halfHeight);
+		instance.axisX = Vec2(baseX * halfBase, baseY * halfBase);
+		instance.axisY = Vec2(upX * halfHeight, upY * halfHeight);
+		instance.depth = depth;
+		instance.shapeType = (uint16_t)ShapeType::TRIANGLE;
+		instance.colour = colour;
 
-		vkCmdDrawIndexed(m_renderer.GetCurrentCommandBuffer(),
-			(uint32_t)sData.Indices.size(), 1, 0, 0, 0);
+		// Where the apex is along the top edge, -1 to 1
+		instance.params = Vec4(((c.x - midX) * baseX + (c.y - midY) * baseY) / halfBase, 0.f, 0.f, 0.f);
 	}
-	
-	void ShapeRenderer::populateVertices(std::vector<std::shared_ptr<IShape>>& shapes,
-		uint32_t renderDataIndex, uint32_t shapeDataIndex)
+
+	// Fills the gap on the outside of the turn at point, returns how many instances were written (at most 2)
+	static uint32_t writeJoin(ShapeInstance* pInstances, const Vec2& prev, const Vec2& point, const Vec2& next,
+		float radius, LineJoin join, int16_t& depth, uint32_t colour)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
-		ShapeData& sData = rData.ShapeInfos[shapeDataIndex];
+		float dir0X = point.x - prev.x, dir0Y = point.y - prev.y;
+		float dir1X = next.x - point.x, dir1Y = next.y - point.y;
+
+		float length0 = sqrtf(dir0X * dir0X + dir0Y * dir0Y);
+		float length1 = sqrtf(dir1X * dir1X + dir1Y * dir1Y);
+
+		if (length0 == 0.f || length1 == 0.f) return 0;
 
-		rData.TotalVerticeSize = 0;
+		dir0X /= length0; dir0Y /= length0;
+		dir1X /= length1; dir1Y /= length1;
 
-		if (rData.IsBufferCreated)
+		float cross = dir0X * dir1Y - dir0Y * dir1X;
+		float dot = dir0X * dir1X + dir0Y * dir1Y;
+
+		// The segments already meet when the line goes straight on
+		if (fabsf(cross) < 1e-4f && dot > 0.f) return 0;
+
+		if (join == LineJoin::ROUND)
 		{
-			vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), rData.Buffer, nullptr);
-			vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), rData.BufferMemory, nullptr);
+			writeSegment(pInstances[0], point, point, radius, LineCap::ROUND, takeLineDepth(depth), colour);
+			return 1;
 		}
 
-		for (std::shared_ptr<IShape>  shape : shapes)
-		{
-			float width = shape->GetWidth();
-			float height = shape->GetHeight();
-			float depth = shape->GetDepth();
-			float x = shape->GetX();
-			float y = shape->GetY();
-			float z = shape->GetZ();
+		// The outside of a left turn is on the right
+		float side = cross > 0.f ? -1.f : 1.f;
 
-			ShapeType shapeType = shape->GetShapeType();
+		Vec2 outer0(point.x - dir0Y * radius * side, point.y + dir0X * radius * side);
+		Vec2 outer1(point.x - dir1Y * radius * side, point.y + dir1X * radius * side);
 
-			bool isScaled = shape->GetScaleX() != 1.f || shape->GetScaleY() != 1.f || shape->GetScaleZ() != 1.f;
-			bool isRotated = shape->GetRotationX() != 0.f || shape->GetRotationY() != 0.f || shape->GetRotationZ() != 0.f;
+		writeTriangle(pInstances[0], point, outer0, outer1, takeLineDepth(depth), colour);
 
-			Vec3 posBL(x, y, z + depth);
-			Vec3 posBR(x + width, y, z + depth);
-			Vec3 posTR(x + width, y + height, z + depth);
-			Vec3 posTL(x, y + height, z + depth);
+		if (join == LineJoin::BEVEL) return 1;
 
-			if (isScaled || isRotated)
-			{
-				float halfW = width / 2.f;
-				float halfH = height / 2.f;
-
-				// Set positions to be the origin so we rotate around that
-				// We have to subtract by our sprite position because of our mvp
-				Vec2 tempTL((posTL.x - x) - halfW, (posTL.y - y) - halfH);
-				Vec2 tempTR((posTR.x - x) - halfW, (posTR.y - y) - halfH);
-				Vec2 tempBL((posBL.x - x) - halfW, (posBL.y - y) - halfH);
-				Vec2 tempBR((posBR.x - x) - halfW, (posBR.y - y) - halfH);
-
-				// Create our translation matrices
-				Mat4 scaleMat = Mat4::Scale(shape->GetScaleX(), shape->GetScaleY(), shape->GetScaleZ());
-				Mat4 rotateXMat = Mat4::RotateX(shape->GetRotationX());
-				Mat4 rotateYMat = Mat4::RotateY(shape->GetRotationY());
-				Mat4 rotateZMat = Mat4::RotateZ(shape->GetRotationZ());
-
-				Mat4 translateMat = scaleMat * (rotateXMat * rotateYMat * rotateZMat);
-
-				// Rotate the positions
-				tempTR = translateMat * tempTR;
-				tempTL = translateMat * tempTL;
-				tempBL = translateMat * tempBL;
-				tempBR = translateMat * tempBR;
-
-				// Set the positions back to their original position 
-				// (doing it how we did will rotate around the center of the sprite)
-				// We also have to add back our subtracted sprite positions because of the mvp
-				posTR = Vec3((tempTR.x + x) + halfW, (tempTR.y + y) + halfH, posTR.z);
-				posTL = Vec3((tempTL.x + x) + halfW, (tempTL.y + y) + halfH, posTL.z);
-				posBL = Vec3((tempBL.x + x) + halfW, (tempBL.y + y) + halfH, posBL.z);
-				posBR = Vec3((tempBR.x + x) + halfW, (tempBR.y + y) + halfH, posBR.z);
-			}
+		// The tip is where the outer edges meet, it's along the average of the segments' normals
+		float miterX = -dir0Y - dir1Y;
+		float miterY = dir0X + dir1X;
+		float miterNormalLength = sqrtf(miterX * miterX + miterY * miterY);
 
-			ShapeVertex topRight;
-			ShapeVertex topLeft;
-			ShapeVertex bottomLeft;
-			ShapeVertex bottomRight;
+		if (miterNormalLength == 0.f) return 1;
 
-			topRight.pos = posTR;
-			topRight.colour = shape->GetColour();
-			topRight.localPos = Vec2{ m_tR.x, m_tR.y } *2.f;
-			topRight.circleThickness = shape->GetCircleThickness();
-			topRight.circleFade = shape->GetCircleFade();
-			topRight.shapeType = (float)shapeType;
+		miterX /= miterNormalLength;
+		miterY /= miterNormalLength;
 
-			topLeft.pos = posTL;
-			topLeft.colour = shape->GetColour();
-			topLeft.localPos = Vec2{ m_tL.x, m_tL.y } *2.f;
-			topLeft.circleThickness = shape->GetCircleThickness();
-			topLeft.circleFade = shape->GetCircleFade();
-			topLeft.shapeType = (float)shapeType;
+		float cosHalfAngle = miterX * -dir0Y + miterY * dir0X;
 
-			bottomLeft.pos = posBL;
-			bottomLeft.colour = shape->GetColour();
-			bottomLeft.localPos = Vec2{ m_bL.x, m_bL.y } *2.f;
-			bottomLeft.circleThickness = shape->GetCircleThickness();
-			bottomLeft.circleFade = shape->GetCircleFade();
-			bottomLeft.shapeType = (float)shapeType;
+		if (cosHalfAngle <= 0.f || radius / cosHalfAngle > radius * LINE_MITER_LIMIT) return 1;
 
-			bottomRight.pos = posBR;
-			bottomRight.colour = shape->GetColour();
-			bottomRight.localPos = Vec2{ m_bR.x, m_bR.y } *2.f;
-			bottomRight.circleThickness = shape->GetCircleThickness();
-			bottomRight.circleFade = shape->GetCircleFade();
-			bottomRight.shapeType = (float)shapeType;
+		float miterLength = radius / cosHalfAngle * side;
+		Vec2 tip(point.x + miterX * miterLength, point.y + miterY * miterLength);
 
-			sData.Vertices.push_back(topRight);
-			sData.Vertices.push_back(topLeft);
-			sData.Vertices.push_back(bottomLeft);
-			sData.Vertices.push_back(bottomRight);
-		}
+		writeTriangle(pInstances[1], outer0, tip, outer1, takeLineDepth(depth), colour);
+		return 2;
+	}
 
-		uint32_t offset = 0;
-		for (size_t i = 0; i < shapes.size(); ++i)
-		{
-			sData.Indices.push_back(offset);
-			sData.Indices.push_back(1 + offset);
-			sData.Indices.push_back(2 + offset);
-			sData.Indices.push_back(2 + offset);
-			sData.Indices.push_back(3 + offset);
-			sData.Indices.push_back(offset);
+	void ShapeRenderer::DrawLine(const Vec3& start, const Vec3& end, float thickness, const Vec4& colour,
+		const Mat4& mvp, LineCap cap)
+	{
+		if (thickness <= 0.f) return;
 
-			offset += 4;
-		}
+		ShapeInstance* pInstance = (ShapeInstance*)m_immediateShapes.Begin(
+			*m_renderer.GetDynamicVertexBuffer(), 1, makeView(mvp));
+
+		writeSegment(*pInstance, Vec2(start.x, start.y), Vec2(end.x, end.y), thickness / 2.f, cap,
+			PackDepth(start.z), PackColour(colour));
+
+		m_immediateShapes.End(1);
+	}
 
-		// Since all our vertices and indices are in one buffer we need data extract it at the correct places
+	void ShapeRenderer::DrawPolyline(const Vec2* pPoints, uint32_t pointCount, float z, float thickness,
+		const Vec4& colour, const Mat4& mvp, LineJoin join, LineCap cap, bool isClosed)
+	{
+		if (pointCount < 2 || thickness <= 0.f) return;
+
+		uint32_t segmentCount = isClosed ? pointCount : pointCount - 1;
+		uint32_t joinCount = isClosed ? pointCount : pointCount - 2;
+
+		// A miter join takes two triangles and the caps one instance each
+		ShapeInstance* pInstances = (ShapeInstance*)m_immediateShapes.Begin(
+			*m_renderer.GetDynamicVertexBuffer(), segmentCount + joinCount * 2 + 2, makeView(mvp));
+		uint32_t count = 0;
 
-		if (rData.ShapeInfos.size() > 1)
+		float radius = thickness / 2.f;
+		uint32_t packedColour = PackColour(colour);
+		int16_t depth = PackDepth(z);
+
+		for (uint32_t i = 0; i < segmentCount; ++i)
 		{
-			sData.StartVertex =
-				m_renderInfos[renderDataIndex].ShapeInfos[shapeDataIndex - 1].StartVertex +
-				m_renderInfos[renderDataIndex].ShapeInfos[shapeDataIndex - 1].SizeOfVerticesInBytes();
+			Vec2 start = pPoints[i];
+			Vec2 end = pPoints[(i + 1) % pointCount];
+
+			float dx = end.x - start.x;
+			float dy = end.y - start.y;
+			float length = sqrtf(dx * dx + dy * dy);
+
+			if (length == 0.f) continue;
+
+			// Square caps are the end segments carried on by half the thickness
+			if (!isClosed && cap == LineCap::SQUARE)
+			{
+				float extendX = dx / length * radius;
+				float extendY = dy / length * radius;
+
+				if (i == 0) { start.x -= extendX; start.y -= extendY; }
+				if (i == segmentCount - 1) { end.x += extendX; end.y += extendY; }
+			}
+
+			// Joins are drawn separately so the segments end flat
+			writeSegment(pInstances[count++], start, end, radius, LineCap::BUTT, takeLineDepth(depth), packedColour);
+
+			if (isClosed || i + 1 < segmentCount)
+			{
+				count += writeJoin(&pInstances[count], pPoints[i], pPoints[(i + 1) % pointCount],
+					pPoints[(i + 2) % pointCount], radius, join, depth, packedColour);
+			}
 		}
-		else
-			sData.StartIndex = 0;
 
-		uint32_t indexOffset = 0;
-		for (auto& data : rData.ShapeInfos)
+		if (!isClosed && cap == LineCap::ROUND)
 		{
-			ShapeData lastData = rData.ShapeInfos[rData.ShapeInfos.size() - 1];
-
-			data.StartIndex = lastData.StartVertex +
-				(sizeof(ShapeVertex) * lastData.Vertices.size()) + indexOffset;
-			indexOffset += (uint32_t)data.SizeOfIndicesInBytes();
+			writeSegment(pInstances[count++], pPoints[0], pPoints[0], radius, LineCap::ROUND,
+				takeLineDepth(depth), packedColour);
+			writeSegment(pInstances[count++], pPoints[pointCount - 1], pPoints[pointCount - 1], radius,
+				LineCap::ROUND, takeLineDepth(depth), packedColour);
 		}
 
-		createBuffer(renderDataIndex);
+		m_immediateShapes.End(count);
 	}
 
-	void ShapeRenderer::createBuffer(uint32_t renderDataIndex)
+	void ShapeRenderer::DrawRectOutline(const Vec4& rect, float z, float thickness, const Vec4& colour,
+		const Mat4& mvp)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		const Vec2 corners[4] = {
+			Vec2(rect.x, rect.y), Vec2(rect.x + rect.z, rect.y),
+			Vec2(rect.x + rect.z, rect.y + rect.w), Vec2(rect.x, rect.y + rect.w)
+		};
+
+		DrawPolyline(corners, 4, z, thickness, colour, mvp, LineJoin::MITER, LineCap::BUTT, true);
+	}
 
-		if (rData.ShapeInfos.empty()) return;
+	DrawView ShapeRenderer::makeView(const Mat4& viewProjection) const
+	{
+		return MakeDrawView(viewProjection, m_viewportInfo, m_scissorOffset, m_scissorExtent);
+	}
 
-		VkDeviceSize bufferSize = 0;
+	void ShapeRenderer::setDrawState(DrawPacket& packet, const DrawView& view) const
+	{
+		packet.Viewport = view.Viewport;
+		packet.Scissor = view.Scissor;
 
-		rData.TotalVerticeSize = 0;
-		for (auto& data : rData.ShapeInfos)
-		{
-			bufferSize += data.SizeInBytes();
-			rData.TotalVerticeSize += (uint32_t)data.SizeOfVerticesInBytes();
-		}
+		packet.Pipeline = p_pipeline->GetPipeline();
+		packet.PipelineLayout = p_pipeline->GetPipelineLayout();
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		ShapePushConstants pushConstants{};
+		pushConstants.pv = view.ViewProjection;
 
-		Core::GetCore().CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
+		packet.PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
+		packet.PushConstantSize = sizeof(ShapePushConstants);
+		memcpy(packet.PushConstants, &pushConstants, sizeof(ShapePushConstants));
 
-		void* data;
-		vkMapMemory(Core::GetCore().GetDevice()->GetDevice(),
-			stagingBufferMemory, 0, bufferSize, 0, &data);
+		// 6 vertices for the quad, the corners come from gl_VertexIndex
+		packet.Type = DrawPacketType::DRAW;
+		packet.Count = 6;
+	}
 
-		// Create the vertices
-		for (auto& dataInfo : rData.ShapeInfos)
-			memcpy((char*)data + dataInfo.StartVertex, dataInfo.Vertices.data(), dataInfo.SizeOfVerticesInBytes());
+	void ShapeRenderer::queueDraws()
+	{
+		// Every call gets its own packet with its own view
+		for (const BatchDraw& batchDraw : m_batchDraws)
+			queueBatch(batchDraw);
 
-		// Create the indices
-		for (auto& dataInfo : rData.ShapeInfos)
-			memcpy((char*)data + dataInfo.StartIndex, dataInfo.Indices.data(), dataInfo.SizeOfIndicesInBytes());
+		m_batchDraws.clear();
+		m_visibleSlots.clear();
 
-		vkUnmapMemory(Core::GetCore().GetDevice()->GetDevice(), stagingBufferMemory);
+		queueImmediate();
+	}
 
-		Core::GetCore().CreateBuffer(bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			rData.Buffer, rData.BufferMemory);
+	void ShapeRenderer::queueBatch(const BatchDraw& batchDraw)
+	{
+		const ShapeBatch& batch = m_batches[batchDraw.Batch];
+		const RenderData& rData = batch.RenderInfo;
 
-		Core::GetCore().CopyBuffer(stagingBuffer, rData.Buffer, bufferSize);
+		if (rData.InstanceCount == 0 || (batchDraw.IsCulled && batchDraw.VisibleSlotCount == 0)) return;
 
-		vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), stagingBuffer, nullptr);
-		vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), stagingBufferMemory, nullptr);
+		DrawPacket packet{};
+		packet.SortKey = batch.SortKey;
 
-		rData.IsBufferCreated = true;
+		setDrawState(packet, batchDraw.View);
+
+		// When nothing was culled the batch's own buffers are drawn, the packet then stays the same
+		// from frame to frame so the renderer can submit its recorded frames again
+		bool isAllVisible = !batchDraw.IsCulled || batchDraw.VisibleSlotCount == batch.Slots.GetUsedCount();
+
+		if (!isAllVisible)
+		{
+			// Only the visible instances are copied, for translucent batches they're already back to front
+			const uint32_t* pDrawSlots = &m_visibleSlots[batchDraw.FirstVisibleSlot];
+
+			RingAllocation allocation = m_renderer.GetDynamicVertexBuffer()->Allocate(
+				sizeof(ShapeInstance) * batchDraw.VisibleSlotCount);
+
+			ShapeInstance* pInstances = (ShapeInstance*)allocation.pData;
+
+			for (uint32_t i = 0; i < batchDraw.VisibleSlotCount; ++i)
+				pInstances[i] = rData.Instances[pDrawSlots[i]];
+
+			packet.VertexBuffer = allocation.Buffer;
+			packet.VertexOffset = allocation.Offset;
+			packet.InstanceCount = batchDraw.VisibleSlotCount;
+			packet.IsTransient = VK_TRUE;
+		}
+		else if (batch.Blend == BlendMode::TRANSLUCENT)
+		{
+			packet.VertexBuffer = rData.SortedBuffer;
+			packet.InstanceCount = rData.InstanceCount;
+		}
+		else
+		{
+			packet.VertexBuffer = rData.Buffer;
+			packet.InstanceCount = rData.InstanceCount;
+		}
+
+		m_renderer.AddDrawPacket(packet);
 	}
 
-	void ShapeRenderer::updateBuffer(uint32_t renderDataIndex)
+	void ShapeRenderer::queueImmediate()
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		for (const ImmediateDrawList::Draw& immediateDraw : m_immediateShapes.GetDraws())
+		{
+			if (immediateDraw.Count == 0) continue;
 
-		VkDeviceSize bufferSize = rData.TotalVerticeSize;
+			DrawPacket packet{};
+			packet.SortKey = m_immediateSortKey;
+			packet.IsTransient = VK_TRUE;
 
-		void* data;
-		vkMapMemory(Core::GetCore().GetDevice()->GetDevice(),
-			rData.BufferMemory, 0, bufferSize, 0, &data);
+			setDrawState(packet, immediateDraw.View);
 
-		for (auto& dataInfo : rData.ShapeInfos)
-			memcpy((char*)data + dataInfo.StartVertex, dataInfo.Vertices.data(), dataInfo.SizeOfVerticesInBytes());
+			packet.VertexBuffer = immediateDraw.Buffer;
+			packet.VertexOffset = immediateDraw.Offset;
+			packet.InstanceCount = immediateDraw.Count;
+
+			m_renderer.AddDrawPacket(packet);
+		}
 
-		vkUnmapMemory(Core::GetCore().GetDevice()->GetDevice(), rData.BufferMemory);
+		// The packets point into the dynamic vertex buffer, the list starts over next frame
+		m_immediateShapes.Clear();
 	}
+	
+	void ShapeRenderer::populateInstance(ShapeBatch& batch, uint32_t slot)
+	{
+		buildInstances(batch, &slot, 1);
 
+		batch.Bounds.Set(slot, *batch.Shapes[slot]);
+		batch.BoundsVersions[slot] = batch.Shapes[slot]->GetVersion();
 
-	void ShapeRenderer::updateUBO(const Mat4& mvp)
+		batch.RenderInfo.MarkDirty(slot);
+	}
+
+	void ShapeRenderer::buildInstances(ShapeBatch& batch, const uint32_t* pSlots, uint32_t count) const
 	{
-		ZDevice* pDevice = Core::GetCore().GetDevice();
+		QuadCornerBatch corners;
+
+		for (uint32_t first = 0; first < count; first += QUAD_BATCH_SIZE)
+		{
+			uint32_t blockCount = std::min(count - first, (uint32_t)QUAD_BATCH_SIZE);
+
+			corners.Count = 0;
+
+			for (uint32_t i = 0; i < blockCount; ++i)
+				AddQuad(corners, *batch.Shapes[pSlots[first + i]]);
 
-		ShapeUniformBufferObject ubo{};
-		ubo.pv = mvp;
+			// The shader builds the corners, only the transform terms are needed
+			for (uint32_t i = 0; i < blockCount; ++i)
+			{
+				uint32_t slot = pSlots[first + i];
+				const std::shared_ptr<IShape>& shape = batch.Shapes[slot];
+
+				ShapeInstance& instance = batch.RenderInfo.Instances[slot];
+
+				instance.center = Vec2(corners.CentreX[i] + corners.E[i], corners.CentreY[i] + corners.F[i]);
+				instance.axisX = Vec2(corners.A[i], corners.C[i]) * corners.HalfWidth[i];
+				instance.axisY = Vec2(corners.B[i], corners.D[i]) * corners.HalfHeight[i];
+				instance.depth = PackDepth(shape->GetZ() + shape->GetDepth());
+				instance.shapeType = (uint16_t)shape->GetShapeType();
+				instance.colour = PackColour(shape->GetColour());
+				instance.params = shape->GetShapeParams();
 
-		void* data;
-		vkMapMemory(pDevice->GetDevice(), m_uniformMemory, 0, sizeof(ubo), 0, &data);
-		memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(pDevice->GetDevice(), m_uniformMemory);
+				batch.Versions[slot] = shape->GetVersion();
+			}
+		}
 	}
 
-	void ShapeRenderer::updateVertices(std::vector<std::shared_ptr<IShape>>& shapes, uint32_t renderDataIndex)
+	void ShapeRenderer::growRenderData(RenderData& rData, uint32_t instanceCount)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		uint32_t newCapacity = std::max(rData.InstanceCapacity * 2, (uint32_t)MIN_BATCH_INSTANCE_CAPACITY);
+		while (newCapacity < instanceCount)
+			newCapacity *= 2;
+
+		// Frames in flight might still be drawing from the old buffer
+		if (rData.Buffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(rData.Buffer, rData.BufferMemory);
+
+		// Filled by uploadBatches
+		Core::GetCore().CreateBuffer(sizeof(ShapeInstance) * newCapacity,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rData.Buffer, rData.BufferMemory);
+
+		rData.Instances.reserve(newCapacity);
+		rData.InstanceCapacity = newCapacity;
+		rData.IsBufferRecreated = true;
+	}
+
+	void ShapeRenderer::uploadBatches()
+	{
+		m_cullStats = m_frameCullStats;
+		m_frameCullStats = CullStats();
+
+		m_immediateStats = ImmediateStats();
 
-		if (rData.Shapes.size() == 0) return;
+		for (const ImmediateDrawList::Draw& immediateDraw : m_immediateShapes.GetDraws())
+		{
+			m_immediateStats.QuadCount += immediateDraw.Count;
+			m_immediateStats.DrawCount += immediateDraw.Count > 0 ? 1 : 0;
+		}
 
-		size_t i = 0;
-		uint32_t sIndex = 0;
-		for (std::shared_ptr<IShape> shape : rData.Shapes)
+		for (BatchID batchID = 0; batchID < (BatchID)m_batches.size(); ++batchID)
 		{
-			float width = shape->GetWidth();
-			float height = shape->GetHeight();
-			float depth = shape->GetDepth();
-			float x = shape->GetX();
-			float y = shape->GetY();
-			float z = shape->GetZ();
+			ShapeBatch& batch = m_batches[batchID];
 
-			ShapeType shapeType = shape->GetShapeType();
-			
-			bool isScaled = shape->GetScaleX() != 1.f || shape->GetScaleY() != 1.f || shape->GetScaleZ() != 1.f;
-			bool isRotated = shape->GetRotationX() != 0.f || shape->GetRotationY() != 0.f || shape->GetRotationZ() != 0.f;
+			if (!batch.IsAlive) continue;
 
-			Vec3 posBL(x, y, z + depth);
-			Vec3 posBR(x + width, y, z + depth);
-			Vec3 posTR(x + width, y + height, z + depth);
-			Vec3 posTL(x, y + height, z + depth);
+			RenderData& rData = batch.RenderInfo;
 
-			if (isScaled || isRotated)
+			if (batch.Blend == BlendMode::TRANSLUCENT)
 			{
-				float halfW = width / 2.f;
-				float halfH = height / 2.f;
-
-				// Set positions to be the origin so we rotate around that
-				// We have to subtract by our sprite position because of our mvp
-				Vec2 tempTL((posTL.x - x) - halfW, (posTL.y - y) - halfH);
-				Vec2 tempTR((posTR.x - x) - halfW, (posTR.y - y) - halfH);
-				Vec2 tempBL((posBL.x - x) - halfW, (posBL.y - y) - halfH);
-				Vec2 tempBR((posBR.x - x) - halfW, (posBR.y - y) - halfH);
-
-				// Create our translation matrices
-				Mat4 scaleMat = Mat4::Scale(shape->GetScaleX(), shape->GetScaleY(), shape->GetScaleZ());
-				Mat4 rotateXMat = Mat4::RotateX(shape->GetRotationX());
-				Mat4 rotateYMat = Mat4::RotateY(shape->GetRotationY());
-				Mat4 rotateZMat = Mat4::RotateZ(shape->GetRotationZ());
-
-				Mat4 translateMat = scaleMat * (rotateXMat * rotateYMat * rotateZMat);
-
-				// Rotate the positions
-				tempTR = translateMat * tempTR;
-				tempTL = translateMat * tempTL;
-				tempBL = translateMat * tempBL;
-				tempBR = translateMat * tempBR;
-
-				// Set the positions back to their original position 
-				// (doing it how we did will rotate around the center of the sprite)
-				// We also have to add back our subtracted sprite positions because of the mvp
-				posTR = Vec3((tempTR.x + x) + halfW, (tempTR.y + y) + halfH, posTR.z);
-				posTL = Vec3((tempTL.x + x) + halfW, (tempTL.y + y) + halfH, posTL.z);
-				posBL = Vec3((tempBL.x + x) + halfW, (tempBL.y + y) + halfH, posBL.z);
-				posBR = Vec3((tempBR.x + x) + halfW, (tempBR.y + y) + halfH, posBR.z);
+				sortQuads(batch);
+				uploadSortedInstances(rData);
 			}
 
-			ShapeVertex topRight;
-			ShapeVertex topLeft;
-			ShapeVertex bottomLeft;
-			ShapeVertex bottomRight;
-
-			topRight.pos = posTR;
-			topRight.colour = shape->GetColour();
-			topRight.localPos = Vec2{ m_tR.x, m_tR.y } * 2.f;
-			topRight.circleThickness = shape->GetCircleThickness();
-			topRight.circleFade = shape->GetCircleFade();
-			topRight.shapeType = (float)shapeType;
-
-			topLeft.pos = posTL;
-			topLeft.colour = shape->GetColour();
-			topLeft.localPos = Vec2{ m_tL.x, m_tL.y } *2.f;
-			topLeft.circleThickness = shape->GetCircleThickness();
-			topLeft.circleFade = shape->GetCircleFade();
-			topLeft.shapeType = (float)shapeType;
-
-			bottomLeft.pos = posBL;
-			bottomLeft.colour = shape->GetColour();
-			bottomLeft.localPos = Vec2{ m_bL.x, m_bL.y } *2.f;
-			bottomLeft.circleThickness = shape->GetCircleThickness();
-			bottomLeft.circleFade = shape->GetCircleFade();
-			bottomLeft.shapeType = (float)shapeType;
-
-			bottomRight.pos = posBR;
-			bottomRight.colour = shape->GetColour();
-			bottomRight.localPos = Vec2{ m_bR.x, m_bR.y } *2.f;
-			bottomRight.circleThickness = shape->GetCircleThickness();
-			bottomRight.circleFade = shape->GetCircleFade();
-			bottomRight.shapeType = (float)shapeType;
-
-			// Our shapes to updates in one list
-			// So once we finish updating one set of vertices we want to update the next
-			if (i >= rData.ShapeInfos[sIndex].Vertices.size())
+			updateSortKey(batchID);
+
+			// A new buffer starts out empty so every instance is uploaded
+			if (rData.IsBufferRecreated)
 			{
-				++sIndex;
+				m_renderer.UploadToBuffer(rData.Buffer, 0, rData.Instances.data(),
+					sizeof(ShapeInstance) * rData.Instances.size());
 
-				for (int i = sIndex; i < rData.ShapeInfos.size(); ++i)
-				{
-					if (rData.ShapeInfos[sIndex].canUpdateVertices)
-						break;
+				rData.IsBufferRecreated = false;
+				rData.DirtySlots.clear();
+			}
 
-					++sIndex;
+			if (rData.DirtySlots.empty()) continue;
+
+			std::sort(rData.DirtySlots.begin(), rData.DirtySlots.end());
+
+			// Only the slots that were added, removed or updated since the last frame,
+			// slots close to each other are copied together to keep the copy count down
+			uint32_t rangeStart = rData.DirtySlots[0];
+			uint32_t rangeEnd = rangeStart + 1;
+
+			for (size_t i = 1; i <= rData.DirtySlots.size(); ++i)
+			{
+				if (i < rData.DirtySlots.size() && rData.DirtySlots[i] <= rangeEnd + DIRTY_SLOT_MERGE_GAP)
+				{
+					rangeEnd = std::max(rangeEnd, rData.DirtySlots[i] + 1);
+					continue;
 				}
 
-				i = 0;
+				m_renderer.UploadToBuffer(rData.Buffer, sizeof(ShapeInstance) * rangeStart,
+					&rData.Instances[rangeStart], sizeof(ShapeInstance) * (rangeEnd - rangeStart));
+
+				if (i < rData.DirtySlots.size())
+				{
+					rangeStart = rData.DirtySlots[i];
+					rangeEnd = rangeStart + 1;
+				}
 			}
 
-			rData.ShapeInfos[sIndex].Vertices[i] = topRight;
-			rData.ShapeInfos[sIndex].Vertices[i + 1] = topLeft;
-			rData.ShapeInfos[sIndex].Vertices[i + 2] = bottomLeft;
-			rData.ShapeInfos[sIndex].Vertices[i + 3] = bottomRight;
+			rData.DirtySlots.clear();
+		}
+
+		// Keeps the visible slots of translucent draws back to front
+		for (const BatchDraw& batchDraw : m_batchDraws)
+		{
+			ShapeBatch& batch = m_batches[batchDraw.Batch];
+
+			if (!batchDraw.IsCulled || batchDraw.VisibleSlotCount == 0 || batch.Blend != BlendMode::TRANSLUCENT)
+				continue;
+
+			uint32_t* pVisibleSlots = &m_visibleSlots[batchDraw.FirstVisibleSlot];
 
-			i += 4;
+			std::fill(batch.Visible.begin(), batch.Visible.end(), (uint8_t)0);
+
+			for (uint32_t i = 0; i < batchDraw.VisibleSlotCount; ++i)
+				batch.Visible[pVisibleSlots[i]] = 1;
+
+			uint32_t count = 0;
+
+			for (uint32_t slot : batch.RenderInfo.DrawOrder)
+				if (batch.Visible[slot]) pVisibleSlots[count++] = slot;
+		}
+
+		queueDraws();
+	}
+
+	void ShapeRenderer::sortQuads(ShapeBatch& batch)
+	{
+		RenderData& rData = batch.RenderInfo;
+
+		// Shapes usually move a little each frame so last frame's order is close to sorted
+		if (rData.DrawOrder.size() != rData.InstanceCount)
+		{
+			rData.DrawOrder.resize(rData.InstanceCount);
+
+			for (uint32_t i = 0; i < rData.InstanceCount; ++i)
+				rData.DrawOrder[i] = i;
 		}
+
+		m_depthKeys.resize(rData.InstanceCount);
+
+		// Inverted so the furthest shape comes first
+		for (uint32_t i = 0; i < rData.InstanceCount; ++i)
+			m_depthKeys[i] = ~DepthToSortBits(UnpackDepth(rData.Instances[rData.DrawOrder[i]].depth));
+
+		m_depthSorter.Sort(m_depthKeys, rData.DrawOrder);
+	}
+
+	void ShapeRenderer::uploadSortedInstances(RenderData& rData)
+	{
+		bool isChanged = rData.SortedInstances.size() != rData.InstanceCount;
+
+		rData.SortedInstances.resize(rData.InstanceCount);
+
+		for (uint32_t i = 0; i < rData.InstanceCount; ++i)
+		{
+			const ShapeInstance& instance = rData.Instances[rData.DrawOrder[i]];
+
+			if (memcmp(&rData.SortedInstances[i], &instance, sizeof(ShapeInstance)) == 0) continue;
+
+			rData.SortedInstances[i] = instance;
+			isChanged = true;
+		}
+
+		if (!isChanged || rData.InstanceCount == 0) return;
+
+		if (rData.InstanceCount > rData.SortedCapacity)
+		{
+			// Frames in flight might still be drawing from the old buffer
+			if (rData.SortedBuffer != VK_NULL_HANDLE)
+				m_renderer.DestroyBuffer(rData.SortedBuffer, rData.SortedBufferMemory);
+
+			Core::GetCore().CreateBuffer(sizeof(ShapeInstance) * rData.InstanceCapacity,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rData.SortedBuffer, rData.SortedBufferMemory);
+
+			rData.SortedCapacity = rData.InstanceCapacity;
+		}
+
+		m_renderer.UploadToBuffer(rData.SortedBuffer, 0, rData.SortedInstances.data(),
+			sizeof(ShapeInstance) * rData.InstanceCount);
+	}
+
+	void ShapeRenderer::updateSortKey(BatchID batchID)
+	{
+		ShapeBatch& batch = m_batches[batchID];
+		const RenderData& rData = batch.RenderInfo;
+
+		// Cutout batches rely on the depth test so only translucent batches are ordered by depth
+		float depth = 0.f;
+		if (batch.Blend == BlendMode::TRANSLUCENT && !rData.DrawOrder.empty())
+			depth = UnpackDepth(rData.Instances[rData.DrawOrder[0]].depth);
+
+		batch.SortKey = MakeSortKey(batch.Layer, batch.Blend, p_pipeline->GetID(), batchID, depth);
 	}
 
 	void ShapeRenderer::swapchainRecreateEvent(SwapchainRecreateEvent& e)
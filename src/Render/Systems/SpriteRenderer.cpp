@@ -5,23 +5,38 @@
 
 #include <cassert>
 
-#define MAX_QUAD_COUNT 880
-#define MAX_VERTEX_COUNT MAX_QUAD_COUNT * 4
-#define MAX_INDEX_COUNT MAX_QUAD_COUNT * 6
+// Quads a batch's vertex buffer can hold when it's first created, it doubles every time it's outgrown
+#define MIN_BATCH_QUAD_CAPACITY 256
+
+// Batches are drawn in chunks of this many quads so every draw can use 16 bit indices
+#define MAX_QUADS_PER_DRAW MAX_UINT16_QUAD_COUNT
+
+// Dirty slots at most this many slots apart are uploaded with one copy
+#define DIRTY_SLOT_MERGE_GAP 8
+
+// Changed quads each worker thread builds at least, fewer than this aren't worth waking a thread for
+#define MIN_PARALLEL_QUAD_COUNT 2048
+
+// Immediate quads reserved from the dynamic vertex buffer at a time
+#define IMMEDIATE_CHUNK_QUAD_COUNT 1024
+
+// Batches use their ID as the state of their sort keys, immediate draws come after all of them
+#define IMMEDIATE_SORT_STATE_ID 0xFFFF
 
 namespace ZVK
 {
 
 	SpriteRenderer::SpriteRenderer(Renderer& renderer,
 		SpritePipeline* pPipeline, const std::string& errorTexturePath)
-		: m_renderer(renderer), p_pipeline(pPipeline)
+		: m_renderer(renderer), p_pipeline(pPipeline),
+		m_immediateSprites(sizeof(SpriteVertex) * 4, IMMEDIATE_CHUNK_QUAD_COUNT)
 	{
 		init(errorTexturePath);
 	}
 
 	SpriteRenderer::SpriteRenderer(Renderer& renderer, const std::string& errorTexturePath,
 		const std::string& vertPath, const std::string& fragPath) :
-		m_renderer(renderer)
+		m_renderer(renderer), m_immediateSprites(sizeof(SpriteVertex) * 4, IMMEDIATE_CHUNK_QUAD_COUNT)
 	{
 		try
 		{
@@ -40,42 +55,49 @@ namespace ZVK
 	{
 		ZDevice* pDevice = Core::GetCore().GetDevice();
 
-		vkDestroyBuffer(pDevice->GetDevice(), m_uniformBuffer, nullptr);
-		vkFreeMemory(pDevice->GetDevice(), m_uniformMemory, nullptr);
+		m_renderer.RemoveUpdateVertexFnc(m_uploadFncID);
 
-		for (auto cmd : m_uploadUpdatedVerticesCmds)
+		for (auto& batch : m_batches)
 		{
-			m_renderer.RemoveUpdateVertexCmd(cmd);
-			if (cmd)
+			if (batch.RenderInfo.Buffer != VK_NULL_HANDLE)
 			{
-				delete cmd;
-				cmd = nullptr;
+				vkDestroyBuffer(pDevice->GetDevice(), batch.RenderInfo.Buffer, nullptr);
+				vkFreeMemory(pDevice->GetDevice(), batch.RenderInfo.BufferMemory, nullptr);
 			}
+
+			for (std::vector<BakedDraw>& frameBakedDraws : batch.BakedDraws)
+				for (BakedDraw& bakedDraw : frameBakedDraws)
+					if (bakedDraw.CmdBuffer != VK_NULL_HANDLE)
+						vkFreeCommandBuffers(pDevice->GetDevice(), Core::GetCore().GetCmdPool(), 1, &bakedDraw.CmdBuffer);
 		}
 
-		for (auto cmd : m_spriteRendererCmds)
+		for (auto& instanceData : m_instanceInfos)
 		{
-			m_renderer.RemoveRenderCmd(cmd);
-			if (cmd)
-			{
-				delete cmd;
-				cmd = nullptr;
-			}
+			if (!instanceData.IsBufferCreated) continue;
+
+			vkDestroyBuffer(pDevice->GetDevice(), instanceData.Buffer, nullptr);
+			vkFreeMemory(pDevice->GetDevice(), instanceData.BufferMemory, nullptr);
 		}
 
-		for (auto& renderData : m_renderInfos)
+		if (m_canDeleteInstancedPipeline && p_instancedPipeline)
+			delete p_instancedPipeline;
+
+		if (m_bakedViewBuffer != VK_NULL_HANDLE)
 		{
-			vkDestroyBuffer(pDevice->GetDevice(), renderData.Buffer, nullptr);
-			vkFreeMemory(pDevice->GetDevice(), renderData.BufferMemory, nullptr);
+			vkUnmapMemory(pDevice->GetDevice(), m_bakedViewMemory);
+			vkDestroyBuffer(pDevice->GetDevice(), m_bakedViewBuffer, nullptr);
+			vkFreeMemory(pDevice->GetDevice(), m_bakedViewMemory, nullptr);
 		}
 
+		// The baked views' sets are freed with the pipeline's pool
+		if (m_canDeleteBakedPipeline && p_bakedPipeline)
+			delete p_bakedPipeline;
+
 		vkDestroySampler(pDevice->GetDevice(), m_sampler, nullptr);
 	}
 
 	void SpriteRenderer::init(const std::string& errorTexturePath)
 	{
-		createUniformBuffer();
-
 		p_errorTexture = std::make_shared<Texture2D>(errorTexturePath);
 
 		m_swapchainRecreateEvent = std::bind(&SpriteRenderer::swapchainRecreateEvent,
@@ -137,9 +159,15 @@ namespace ZVK
 			m_scissorExtent = Core::GetCore().GetSwapchain()->GetSwapchainExtent();
 		}
 
-		m_textureData = std::make_unique<TextureData>(TextureData{});
+		// Sprites without a texture use the error texture
+		m_errorTextureSlot = Core::GetCore().GetTextureRegistry()->Register(*p_errorTexture);
 
 		allocateDescriptorInfo();
+		updateDescriptorWrites();
+
+		m_uploadFncID = m_renderer.AddUpdateVertexFnc([this]() { uploadBatches(); });
+
+		SetImmediateLayer(m_immediateLayer);
 	}
 
 	void SpriteRenderer::Draw(std::vector<std::shared_ptr<Sprite>>& sprites, const Mat4& pv,
@@ -147,729 +175,1364 @@ namespace ZVK
 	{
 		if (sprites.empty()) return;
 
+		DrawBatch(loadList(sprites, canUpdateVertexBuffer), pv);
+	}
+
+	void SpriteRenderer::Draw(std::vector<std::shared_ptr<Sprite>>& sprites, const Camera& cam,
+		const bool canUpdateVertexBuffer)
+	{
+		if (sprites.empty()) return;
+
+		DrawBatch(loadList(sprites, canUpdateVertexBuffer), cam);
+	}
+
+	BatchID SpriteRenderer::GetListBatch(std::vector<std::shared_ptr<Sprite>>& sprites,
+		const bool canUpdateVertexBuffer)
+	{
+		return loadList(sprites, canUpdateVertexBuffer);
+	}
+
+	BatchID SpriteRenderer::loadList(std::vector<std::shared_ptr<Sprite>>& sprites,
+		const bool canUpdateVertexBuffer)
+	{
 		auto spriteList = m_loadedLists.find(&sprites);
-		bool isFound = false;
 
 		if (spriteList == m_loadedLists.end())
 		{
-			m_loadedLists[&sprites] = { (uint32_t)sprites.size(), m_listCount++ };
+			m_loadedLists[&sprites] = { (uint32_t)sprites.size(), CreateBatch(canUpdateVertexBuffer) };
 			spriteList = m_loadedLists.find(&sprites);
 		}
 		else if (spriteList->second.ListSize != (uint32_t)sprites.size())
 		{
-			// This is inefficient but it works
-			for (SpriteRendererCmd* rCmd : m_spriteRendererCmds)
-			{
-				m_renderer.RemoveRenderCmd(rCmd);
+			// Only this list's batch is rebuilt, its buffers are reused
+			ClearBatch(spriteList->second.Index);
 
-				if (rCmd != nullptr)
-				{
-					delete rCmd;
-					rCmd = nullptr;
-				}
-			}
+			spriteList->second.ListSize = (uint32_t)sprites.size();
+			spriteList->second.IsListAdded = false;
+		}
 
-			for (UploadUpdatedSpriteVerticesCmd* updateVCmd : m_uploadUpdatedVerticesCmds)
-			{
-				m_renderer.RemoveUpdateVertexCmd(updateVCmd);
+		ListInfo& listInfo = spriteList->second;
 
-				if (updateVCmd != nullptr)
-				{
-					delete updateVCmd;
-					updateVCmd = nullptr;
-				}
-			}
+		if (!listInfo.IsListAdded)
+		{
+			for (const std::shared_ptr<Sprite>& sprite : sprites)
+				AddSprite(listInfo.Index, sprite);
 
-			for (auto& renderData : m_renderInfos)
-			{
-				vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), renderData.Buffer, nullptr);
-				vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), renderData.BufferMemory, nullptr);
-			}
+			listInfo.IsListAdded = true;
 
-			changedListIndex = spriteList->second.Index;
+			if (!m_batches[listInfo.Index].CanUpdateVertices)
+				BakeBatch(listInfo.Index);
+		}
 
-			m_spriteRendererCmds.clear();
-			m_uploadUpdatedVerticesCmds.clear();
-			m_renderInfos.clear();
-			m_updateVerticesCmds.clear();
-			m_textureData->DescriptorImageInfos.clear();
-			m_textureData->BindingInfos.clear();
-			m_textureData->TextureCount = 0;
-			m_listCount = 0;
-			spriteList->second.ListSize = (uint32_t)sprites.size();
+		return listInfo.Index;
+	}
 
-			for (auto& [key, val] : m_loadedLists)
-				val.IsListAdded = false;
+	BatchID SpriteRenderer::CreateBatch(const bool canUpdateVertexBuffer)
+	{
+		BatchID batchID;
 
-			return;
+		if (!m_freeBatchIDs.empty())
+		{
+			batchID = m_freeBatchIDs.back();
+			m_freeBatchIDs.pop_back();
+		}
+		else
+		{
+			batchID = (BatchID)m_batches.size();
+			m_batches.push_back(SpriteBatch{});
 		}
-		else if (spriteList->second.IsListAdded == true)
-			isFound = true;
 
-		if (changedListIndex >= 0 && spriteList->second.Index > changedListIndex)
-			return;
-		else if (spriteList->second.Index == changedListIndex)
-			changedListIndex = -1;
+		SpriteBatch& batch = m_batches[batchID];
 
-		if (!isFound)
-		{
-			createTextureData(sprites);
+		batch.CanUpdateVertices = canUpdateVertexBuffer;
+		batch.IsAlive = true;
 
-			// Add new list to the render data 
-			// Create a new one if we go over the max quad count
-			if (!m_renderInfos.empty() &&
-				m_renderInfos[m_renderInfos.size() - 1].SpriteCount < MAX_QUAD_COUNT)
-			{
-				uint32_t renderIndex = (uint32_t)m_renderInfos.size() - 1;
+		return batchID;
+	}
 
-				RenderData& rData = m_renderInfos[renderIndex];
+	void SpriteRenderer::DestroyBatch(BatchID batchID)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-				uint32_t spriteIndex = 0;
+		SpriteBatch& batch = m_batches[batchID];
 
-				if (rData.SpriteCount + (uint32_t)sprites.size() > MAX_QUAD_COUNT)
-				{
-					// Make sure we caculate for a list size greater than MAX_QUAD_COUNT
-					// We also need to account for a list size less than MAX_QUAD_COUNT
+		// Frames in flight might still be drawing the batch
+		if (batch.RenderInfo.Buffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(batch.RenderInfo.Buffer, batch.RenderInfo.BufferMemory);
 
-					std::vector<std::shared_ptr<Sprite>> tempSprites;
+		for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+		{
+			for (BakedDraw& bakedDraw : batch.BakedDraws[frame])
+			{
+				if (bakedDraw.CmdBuffer != VK_NULL_HANDLE)
+					m_renderer.FreeCommandBuffer(bakedDraw.CmdBuffer);
 
-					uint32_t amountAdded = 0;
-					for (size_t i = 0; rData.SpriteCount + i < MAX_QUAD_COUNT; ++i)
-					{
-						tempSprites.push_back(sprites[i]);
-						++amountAdded;
-					}
+				// The slot is only written again in the same frame index, once its fence was waited on
+				if (bakedDraw.ViewSlot != INVALID_BATCH_SLOT)
+					m_bakedViewSlots[frame].Free(bakedDraw.ViewSlot);
+			}
+		}
 
-					rData.SpriteInfos.push_back(SpriteData{});
-					spriteIndex = (uint32_t)m_renderInfos[renderIndex].SpriteInfos.size() - 1;
+		removeBatchDraws(batchID);
 
-					rData.SpriteInfos[spriteIndex].CanUpdateVertices = canUpdateVertexBuffer;
+		batch = SpriteBatch{};
+		m_freeBatchIDs.push_back(batchID);
+	}
 
-					populateVertices(tempSprites, renderIndex, spriteIndex);
+	void SpriteRenderer::ClearBatch(BatchID batchID)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-					if (canUpdateVertexBuffer)
-					{
-						std::copy(tempSprites.begin(), tempSprites.end(),
-							std::back_inserter(rData.Sprites));
-					}
+		SpriteBatch& batch = m_batches[batchID];
 
-					rData.SpriteCount += (uint32_t)tempSprites.size();
+		batch.Sprites.clear();
+		batch.Versions.clear();
+		batch.Slots.Clear();
 
-					std::vector<std::shared_ptr<Sprite>>
-						newSprites(std::next(sprites.begin() + amountAdded - 1), sprites.end());
+		batch.Bounds.Clear();
+		batch.BoundsVersions.clear();
+		batch.Visible.clear();
 
-					SpriteRendererCmd* cmd = new SpriteRendererCmd(this, 
-						(uint32_t)sprites.size() * 6, renderIndex, spriteIndex);
-					m_spriteRendererCmds.push_back(cmd);
-					m_renderer.AddRenderCmd(cmd);
+		batch.RenderInfo.Vertices.clear();
+		batch.RenderInfo.QuadCount = 0;
+		batch.RenderInfo.DirtySlots.clear();
+		batch.RenderInfo.DrawOrder.clear();
 
-					if (amountAdded != sprites.size())
-						drawRecursive(newSprites, canUpdateVertexBuffer);
-				}
-				else
-				{
-					rData.SpriteInfos.push_back(SpriteData{});
+		removeBatchDraws(batchID);
 
-					spriteIndex = (uint32_t)m_renderInfos[renderIndex].SpriteInfos.size() - 1;
+		// Its draws are recorded again if it's baked again since the buffer will have changed
+		batch.BakedTextures.clear();
+		batch.IsBaked = false;
+		batch.IsBakeUploaded = false;
+	}
 
-					populateVertices(sprites, renderIndex, spriteIndex);
+	BatchHandle SpriteRenderer::AddSprite(BatchID batchID, const std::shared_ptr<Sprite>& sprite)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive)
+			throw std::runtime_error("Can't add a sprite to a batch that doesn't exist!");
 
-					if (canUpdateVertexBuffer)
-						std::copy(sprites.begin(), sprites.end(), 
-							std::back_inserter(rData.Sprites));
+		SpriteBatch& batch = m_batches[batchID];
 
-					rData.SpriteInfos[spriteIndex].CanUpdateVertices = canUpdateVertexBuffer;
+		if (batch.IsBaked)
+			throw std::runtime_error("Can't add a sprite to a baked batch!");
 
-					rData.SpriteCount += (uint32_t)sprites.size();
+		uint32_t slot = batch.Slots.Allocate();
 
-					SpriteRendererCmd* cmd = new SpriteRendererCmd(this,
-						(uint32_t)sprites.size() * 6, renderIndex, spriteIndex);
-					m_spriteRendererCmds.push_back(cmd);
-					m_renderer.AddRenderCmd(cmd);
-				}
-			}
-			else
-				drawRecursive(sprites, canUpdateVertexBuffer);
+		if (slot >= (uint32_t)batch.Sprites.size())
+		{
+			batch.Sprites.resize(slot + 1);
+			batch.Versions.resize(slot + 1);
+
+			batch.Bounds.Resize(slot + 1);
+			batch.BoundsVersions.resize(slot + 1);
+			batch.Visible.resize(slot + 1);
+		}
 
-			for (uint32_t i = 0; i < (uint32_t)m_renderInfos.size(); ++i)
-				createBuffer(i);
+		batch.Sprites[slot] = sprite;
 
-			updateDescriptorWrites();
+		RenderData& rData = batch.RenderInfo;
 
-			spriteList->second.IsListAdded = true;
+		if (slot >= rData.QuadCount)
+		{
+			rData.QuadCount = slot + 1;
+			rData.Vertices.resize(rData.QuadCount * 4);
+
+			if (rData.QuadCount > rData.QuadCapacity)
+				growRenderData(rData, rData.QuadCount);
 		}
 
-		for (auto updateVCmd : m_updateVerticesCmds)
-			updateVCmd->Execute();
+		populateVertices(batch, slot);
 
-		updateUBO(pv);
+		return { batchID, slot };
 	}
 
-	void SpriteRenderer::Draw(std::vector<std::shared_ptr<Sprite>>& sprites, const Camera& cam,
-		const bool canUpdateVertexBuffer)
+	void SpriteRenderer::RemoveSprite(BatchHandle handle)
+	{
+		if (!handle.IsValid() || handle.Batch >= (BatchID)m_batches.size()) return;
+
+		SpriteBatch& batch = m_batches[handle.Batch];
+
+		if (!batch.IsAlive || batch.IsBaked || handle.Slot >= (uint32_t)batch.Sprites.size() ||
+			!batch.Sprites[handle.Slot])
+			return;
+
+		batch.Sprites[handle.Slot] = nullptr;
+		batch.Slots.Free(handle.Slot);
+
+		batch.Bounds.SetEmpty(handle.Slot);
+
+		RenderData& rData = batch.RenderInfo;
+
+		// A zeroed quad has no area so nothing is drawn until the slot is reused
+		std::fill(rData.Vertices.begin() + handle.Slot * 4,
+			rData.Vertices.begin() + handle.Slot * 4 + 4, SpriteVertex{});
+
+		rData.MarkDirty(handle.Slot);
+	}
+
+	void SpriteRenderer::UpdateSprite(BatchHandle handle)
+	{
+		if (!handle.IsValid() || handle.Batch >= (BatchID)m_batches.size()) return;
+
+		SpriteBatch& batch = m_batches[handle.Batch];
+
+		if (!batch.IsAlive || batch.IsBaked || handle.Slot >= (uint32_t)batch.Sprites.size() ||
+			!batch.Sprites[handle.Slot])
+			return;
+
+		populateVertices(batch, handle.Slot);
+	}
+
+	void SpriteRenderer::BakeBatch(BatchID batchID)
 	{
-		Draw(sprites, cam.GetPV(), canUpdateVertexBuffer);
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
+
+		createBakedViews();
+
+		// Uploaded with the next frame's uploads
+		m_batches[batchID].IsBaked = true;
 	}
 
-	void SpriteRenderer::drawRecursive(std::vector<std::shared_ptr<Sprite>>& sprites, 
-		bool canUpdateVertexBuffer)
+	void SpriteRenderer::DrawBatch(BatchID batchID, const Mat4& pv)
 	{
-		if (sprites.size() == 0) return;
+		drawBatch(batchID, pv, nullptr);
+	}
 
-		// Create render data for the shape list 
-		// and create more if we go past the max quad count
-		m_renderInfos.push_back(RenderData{});
-		size_t index = m_renderInfos.size() - 1;
+	void SpriteRenderer::DrawBatch(BatchID batchID, const Mat4& pv, const Vec4& visibleRect)
+	{
+		drawBatch(batchID, pv, &visibleRect);
+	}
 
-		size_t spritesSize = (sprites.size() > MAX_QUAD_COUNT) ? MAX_QUAD_COUNT : sprites.size();
+	void SpriteRenderer::DrawBatch(BatchID batchID, const Camera& cam)
+	{
+		Vec4 visibleRect = cam.GetVisibleRect();
+		drawBatch(batchID, cam.GetPV(), &visibleRect);
+	}
 
-		std::vector<std::shared_ptr<Sprite>> tempSprites(sprites.begin(), 
-			std::next(sprites.begin() + spritesSize - 1));
+	void SpriteRenderer::drawBatch(BatchID batchID, const Mat4& pv, const Vec4* pVisibleRect)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
 
-		m_renderInfos[index].SpriteInfos.push_back(SpriteData{});
-		populateVertices(tempSprites, (uint32_t)index, 0);
+		SpriteBatch& batch = m_batches[batchID];
+		RenderData& rData = batch.RenderInfo;
+		uint32_t slotCount = (uint32_t)batch.Sprites.size();
 
-		SpriteRendererCmd* cmd = new SpriteRendererCmd(this, (uint32_t)sprites.size() * 6,
-			(uint32_t)index, 0);
-		m_spriteRendererCmds.push_back(cmd);
-		m_renderer.AddRenderCmd(cmd);
+		BatchDraw batchDraw;
+		batchDraw.Batch = batchID;
+		batchDraw.View = makeView(pv);
+
+		// Counted for every batch since the batch might be baked before the frame's draws are added
+		batchDraw.BakedDrawIndex = batch.FrameDrawCount++;
+
+		// Baked batches are always drawn in full
+		if (batch.IsBaked)
+		{
+			m_batchDraws.push_back(batchDraw);
+			return;
+		}
 
-		m_renderInfos[index].SpriteCount = (uint32_t)spritesSize;
+		batchDraw.IsCulled = pVisibleRect != nullptr;
 
-		if (canUpdateVertexBuffer)
+		if (batchDraw.IsCulled)
 		{
-			m_renderInfos[index].Sprites.resize(spritesSize);
-			m_renderInfos[index].Sprites.assign(tempSprites.begin(), tempSprites.end());
+			// Bounds are cheaper to keep current than vertices so they're updated for every change
+			if (batch.CanUpdateVertices)
+			{
+				for (uint32_t slot = 0; slot < slotCount; ++slot)
+				{
+					const std::shared_ptr<Sprite>& sprite = batch.Sprites[slot];
+
+					if (!sprite || sprite->GetVersion() == batch.BoundsVersions[slot]) continue;
+
+					batch.Bounds.Set(slot, *sprite);
+					batch.BoundsVersions[slot] = sprite->GetVersion();
+				}
+			}
 
-			m_renderInfos[index].SpriteInfos[0].CanUpdateVertices = true;
+			uint32_t visibleCount = CullQuadBounds(batch.Bounds, slotCount, *pVisibleRect, batch.Visible.data());
 
-			m_updateVerticesCmds.emplace_back(std::make_unique<UpdateVerticesCmd>(*this,
-				m_renderInfos[index].Sprites, (uint32_t)index));
+			m_frameCullStats.TestedCount += batch.Slots.GetUsedCount();
+			m_frameCullStats.CulledCount += batch.Slots.GetUsedCount() - visibleCount;
 		}
 
-		UploadUpdatedSpriteVerticesCmd* uploadUpdatedCmd =
-			new UploadUpdatedSpriteVerticesCmd(this, (uint32_t)index);
-		m_uploadUpdatedVerticesCmds.push_back(uploadUpdatedCmd);
-		m_renderer.AddUpdateVertexCmd(uploadUpdatedCmd);
+		// Only sprites that were changed since their vertices were built are rebuilt
+		if (batch.CanUpdateVertices)
+		{
+			m_changedSlots.clear();
 
-		if (sprites.size() < MAX_QUAD_COUNT)
-			return;
+			// Registering textures and setting the error texture can't be done in parallel
+			for (uint32_t slot = 0; slot < slotCount; ++slot)
+			{
+				const std::shared_ptr<Sprite>& sprite = batch.Sprites[slot];
 
-		std::vector<std::shared_ptr<Sprite>> newSprites;
-		newSprites.reserve(sprites.size() - MAX_QUAD_COUNT);
-		for (size_t i = MAX_QUAD_COUNT; i < sprites.size(); ++i)
-			newSprites.push_back(sprites[i]);
+				if (!sprite || sprite->GetVersion() == batch.Versions[slot]) continue;
 
-		drawRecursive(newSprites, canUpdateVertexBuffer);
-	}
+				// Culled sprites keep their old version so they're rebuilt once they're visible
+				if (batchDraw.IsCulled && !batch.Visible[slot]) continue;
 
-	void SpriteRenderer::draw(uint32_t indexCount, uint32_t renderDataIndex, 
-		uint32_t spriteDataIndex)
-	{
-		ZSwapchain* pSwapchain = Core::GetCore().GetSwapchain();
+				registerTexture(sprite);
 
-		RenderData& rData = m_renderInfos[renderDataIndex];
-		SpriteData& sData = rData.SpriteInfos[spriteDataIndex];
-		
-		VkViewport viewport{};
-		viewport.x = m_viewportInfo.x;
-		viewport.y = m_viewportInfo.y;
-		viewport.width = m_viewportInfo.z;
-		viewport.height = m_viewportInfo.w;
-		viewport.minDepth = 0.f;
-		viewport.maxDepth = 1.f;
+				if (!sprite->GetTexture())
+					sprite->SetTexture(p_errorTexture);
 
-		VkRect2D scissor{};
-		scissor.offset = { m_scissorOffset.x, m_scissorOffset.y };
-		scissor.extent = m_scissorExtent;
+				m_changedSlots.push_back(slot);
+			}
 
-		vkCmdSetViewport(m_renderer.GetCurrentCommandBuffer(), 0, 1, &viewport);
-		vkCmdSetScissor(m_renderer.GetCurrentCommandBuffer(), 0, 1, &scissor);
+			// Each range only writes the vertices and versions of its own slots
+			m_renderer.GetWorkerPool()->ParallelFor((uint32_t)m_changedSlots.size(), MIN_PARALLEL_QUAD_COUNT,
+				[this, &batch](uint32_t begin, uint32_t end)
+				{ buildQuads(batch, &m_changedSlots[begin], end - begin); });
 
-		vkCmdBindPipeline(m_renderer.GetCurrentCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS, p_pipeline->GetPipeline());
+			rData.DirtySlots.insert(rData.DirtySlots.end(), m_changedSlots.begin(), m_changedSlots.end());
+		}
 
-		vkCmdBindDescriptorSets(m_renderer.GetCurrentCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS, p_pipeline->GetPipelineLayout(),
-			0, 1, &m_descriptorSet,
-			0, nullptr);
+		if (batchDraw.IsCulled)
+		{
+			batchDraw.FirstVisibleSlot = (uint32_t)m_visibleSlots.size();
 
-		VkBuffer vertexBuffers[] = { rData.Buffer };
-		VkDeviceSize offsets[] = { sData.StartVertex };
+			for (uint32_t slot = 0; slot < slotCount; ++slot)
+				if (batch.Visible[slot]) m_visibleSlots.push_back(slot);
 
-		vkCmdBindVertexBuffers(m_renderer.GetCurrentCommandBuffer(), 0, 1, vertexBuffers, offsets);
+			batchDraw.VisibleSlotCount = (uint32_t)m_visibleSlots.size() - batchDraw.FirstVisibleSlot;
+		}
 
-		vkCmdBindIndexBuffer(m_renderer.GetCurrentCommandBuffer(),
-			rData.Buffer, sData.StartIndex,
-			VK_INDEX_TYPE_UINT32);
+		m_batchDraws.push_back(batchDraw);
+	}
 
-		vkCmdDrawIndexed(m_renderer.GetCurrentCommandBuffer(), 
-			(uint32_t)sData.Indices.size(), 1, 0, 0, 0);
+	void SpriteRenderer::removeBatchDraws(BatchID batchID)
+	{
+		m_batchDraws.erase(std::remove_if(m_batchDraws.begin(), m_batchDraws.end(),
+			[batchID](const BatchDraw& batchDraw) { return batchDraw.Batch == batchID; }), m_batchDraws.end());
 	}
 
-	void SpriteRenderer::createTextureData(std::vector<std::shared_ptr<Sprite>>& sprites)
+	uint32_t SpriteRenderer::GetBatchSize(BatchID batchID) const
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return 0;
+
+		return m_batches[batchID].Slots.GetUsedCount();
+	}
+
+	void SpriteRenderer::SetBatchLayer(BatchID batchID, uint8_t layer)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
+
+		m_batches[batchID].Layer = layer;
+	}
+
+	void SpriteRenderer::SetBatchBlendMode(BatchID batchID, BlendMode blendMode)
+	{
+		if (batchID >= (BatchID)m_batches.size() || !m_batches[batchID].IsAlive) return;
+
+		m_batches[batchID].Blend = blendMode;
+	}
+
+	void SpriteRenderer::DrawInstanced(std::vector<std::shared_ptr<Sprite>>& sprites, const Mat4& pv,
+		const bool canUpdateInstanceBuffer)
 	{
 		if (sprites.empty()) return;
 
-		std::vector<std::pair<uint32_t, uint32_t>> existingTextures;
-		std::vector<std::shared_ptr<Texture2D>> newTextures;
-		
-		newTextures.reserve(5);
+		if (!p_instancedPipeline)
+		{
+			p_instancedPipeline = new SpritePipeline("resources/shaders/spir-v/SpriteInstancedVert.spv",
+				"resources/shaders/spir-v/SpriteFrag.spv", nullptr, SpriteVertexLayout::INSTANCED);
+			m_canDeleteInstancedPipeline = true;
+		}
 
-		uint32_t maxTextureSlots = Core::GetCore().GetMaxTextureSlots();
+		auto spriteList = m_loadedInstancedLists.find(&sprites);
 
-		if (m_textureData->TextureCount == 0)
+		if (spriteList == m_loadedInstancedLists.end())
 		{
-			VkDescriptorImageInfo errorImageInfo{};
-			errorImageInfo.sampler = p_errorTexture->GetSampler();
-			errorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			errorImageInfo.imageView = p_errorTexture->GetImageView();
+			m_instanceInfos.push_back(InstanceData{});
+			uint32_t index = (uint32_t)m_instanceInfos.size() - 1;
 
-			m_textureData->DescriptorImageInfos.push_back(errorImageInfo);
-			m_textureData->BindingInfos.emplace_back(std::make_pair(p_errorTexture->GetID(), 0));
-			++m_textureData->TextureCount;
+			m_loadedInstancedLists[&sprites] = { (uint32_t)sprites.size(), index };
+			spriteList = m_loadedInstancedLists.find(&sprites);
 		}
 
-		std::copy(m_textureData->BindingInfos.begin(), m_textureData->BindingInfos.end(),
-			std::back_inserter(existingTextures));
+		ListInfo& listInfo = spriteList->second;
+		InstanceData& iData = m_instanceInfos[listInfo.Index];
 
-		// Figure out what textures have and haven't been added
-		for (size_t i = 0; i < sprites.size(); ++i)
+		// Unlike the per vertex path a new list size only needs this list to be rebuilt
+		bool isRebuilt = !listInfo.IsListAdded || listInfo.ListSize != (uint32_t)sprites.size();
+		bool isNowStatic = !canUpdateInstanceBuffer && (iData.CanUpdateInstances || !iData.IsBufferCreated);
+
+		iData.CanUpdateInstances = canUpdateInstanceBuffer;
+
+		if (isRebuilt)
 		{
-			if (!sprites[i]->GetTexture())
-				continue;
+			createTextureData(sprites);
 
-			uint32_t spriteID = sprites[i]->GetTextureID();
+			listInfo.ListSize = (uint32_t)sprites.size();
+			listInfo.IsListAdded = true;
+		}
 
-			bool isFound = false;
-			for (auto& [textureID, slotID] : existingTextures)
-			{
-				if (spriteID == textureID)
-				{
-					isFound = true;
-					break;
-				}
-			}
+		if (isRebuilt || isNowStatic || canUpdateInstanceBuffer)
+			populateInstances(sprites, listInfo.Index);
 
-			if (isFound)
-				continue;
+		// Dynamic instances are written to the renderer's ring buffer when drawn,
+		// static ones get their own buffer
+		if (!canUpdateInstanceBuffer && (isRebuilt || isNowStatic))
+			createInstanceBuffer(listInfo.Index);
 
-			existingTextures.push_back(std::make_pair(spriteID, 0));
+		m_instanceInfos[listInfo.Index].Views.push_back(makeView(pv));
+	}
 
-			newTextures.push_back(sprites[i]->GetTexture());
+	void SpriteRenderer::DrawInstanced(std::vector<std::shared_ptr<Sprite>>& sprites, const Camera& cam,
+		const bool canUpdateInstanceBuffer)
+	{
+		DrawInstanced(sprites, cam.GetPV(), canUpdateInstanceBuffer);
+	}
 
-			if ((uint32_t)newTextures.size() + m_textureData->TextureCount > maxTextureSlots)
-				throw std::runtime_error("Out of texture slots, consider using a texture atlas!");
-		}
+	void SpriteRenderer::SetInstancedPipeline(SpritePipeline* pPipeline)
+	{
+		if (pPipeline->GetVertexLayout() != SpriteVertexLayout::INSTANCED)
+			throw std::runtime_error("The instanced sprite pipeline must use SpriteVertexLayout::INSTANCED!");
 
-		// Add new textures
-		for(auto newTexture : newTextures)
-		{
-			VkDescriptorImageInfo textureImageInfo{};
-			textureImageInfo.sampler = newTexture->GetSampler();
-			textureImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			textureImageInfo.imageView = newTexture->GetImageView();
+		if (m_canDeleteInstancedPipeline && p_instancedPipeline)
+			delete p_instancedPipeline;
 
-			m_textureData->DescriptorImageInfos.push_back(textureImageInfo);
-			m_textureData->BindingInfos.emplace_back(std::make_pair(
-				newTexture->GetID(),
-				(uint32_t)m_textureData->DescriptorImageInfos.size() - 1
-			));
-			++m_textureData->TextureCount;
-		}
+		p_instancedPipeline = pPipeline;
+		m_canDeleteInstancedPipeline = false;
 	}
 
-	void SpriteRenderer::populateVertices(std::vector<std::shared_ptr<Sprite>>& sprites, 
-		uint32_t renderDataIndex, uint32_t spriteDataIndex)
+	void SpriteRenderer::SetBakedPipeline(SpritePipeline* pPipeline)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
-		SpriteData& sData = rData.SpriteInfos[spriteDataIndex];
+		if (pPipeline->GetVertexLayout() != SpriteVertexLayout::BAKED)
+			throw std::runtime_error("The baked sprite pipeline must use SpriteVertexLayout::BAKED!");
+
+		if (m_canDeleteBakedPipeline && p_bakedPipeline)
+			delete p_bakedPipeline;
 
-		rData.TotalVerticeSize = 0;
+		p_bakedPipeline = pPipeline;
+		m_canDeleteBakedPipeline = false;
+
+		// The sets came from the old pipeline's pool, the draws are recorded again with the new pipeline
+		// and allocate their sets from its pool
+		for (std::vector<VkDescriptorSet>& frameSets : m_bakedViewSets)
+			frameSets.clear();
+	}
 
-		for (std::shared_ptr<Sprite> sprite : sprites)
+	void SpriteRenderer::DrawPool(const SpritePool& pool, const Mat4& pv, uint8_t layer)
+	{
+		auto loadedPool = m_loadedPools.find(&pool);
+
+		if (loadedPool == m_loadedPools.end())
 		{
-			float width = sprite->GetWidth();
-			float height = sprite->GetHeight();
-			float depth = sprite->GetDepth();
-			float x = sprite->GetX();
-			float y = sprite->GetY();
-			float z = sprite->GetZ();
+			uint32_t poolDrawIndex = (uint32_t)m_poolDraws.size();
 
-			int rangedID = 0;
-			
-			if (sprite->GetTexture())
-			{
-				for (auto& [textureID, slotID] : m_textureData->BindingInfos)
-				{
-					if (textureID == sprite->GetTextureID())
-					{
-						rangedID = slotID;
-						break;
-					}
-				}
-			}
+			m_poolDraws.push_back(PoolDraw{});
 
-			bool isScaled = sprite->GetScaleX() != 1.f || sprite->GetScaleY() != 1.f || sprite->GetScaleZ() != 1.f;
-			bool isRotated = sprite->GetRotationX() != 0.f || sprite->GetRotationY() != 0.f || sprite->GetRotationZ() != 0.f;
+			loadedPool = m_loadedPools.emplace(&pool, poolDrawIndex).first;
+		}
 
-			bool isZRotated = sprite->GetRotationZ() > 0.f;
+		PoolDraw& poolDraw = m_poolDraws[loadedPool->second];
 
-			Vec3 posBL(x, y, z + depth);
-			Vec3 posBR(x + width, y, z + depth);
-			Vec3 posTR(x + width, y + height, z + depth);
-			Vec3 posTL(x, y + height, z + depth);
+		// The vertices are written with the batches' uploads
+		poolDraw.pPool = &pool;
+		poolDraw.Views.push_back(makeView(pv));
 
-			if (isScaled || isRotated)
-			{
-				float halfW = width / 2.f;
-				float halfH = height / 2.f;
-
-				// Set positions to be the origin so we rotate around that
-				// We have to subtract by our sprite position because of our mvp
-				Vec2 tempTL((posTL.x - x) - halfW, (posTL.y - y) - halfH);
-				Vec2 tempTR((posTR.x - x) - halfW, (posTR.y - y) - halfH);
-				Vec2 tempBL((posBL.x - x) - halfW, (posBL.y - y) - halfH);
-				Vec2 tempBR((posBR.x - x) - halfW, (posBR.y - y) - halfH);
-
-				// Create our translation matrices
-				Mat4 scaleMat = Mat4::Scale(sprite->GetScaleX(), sprite->GetScaleY(), sprite->GetScaleZ());
-				Mat4 rotateXMat = Mat4::RotateX(sprite->GetRotationX());
-				Mat4 rotateYMat = Mat4::RotateY(sprite->GetRotationY());
-				Mat4 rotateZMat = Mat4::RotateZ(sprite->GetRotationZ());
-
-				Mat4 translateMat = scaleMat * (rotateXMat * rotateYMat * rotateZMat);
-
-				// Rotate the positions
-				tempTR = translateMat * tempTR;
-				tempTL = translateMat * tempTL;
-				tempBL = translateMat * tempBL;
-				tempBR = translateMat * tempBR;
-
-				// Set the positions back to their original position 
-				// (doing it how we did will rotate around the center of the sprite)
-				// We also have to add back our subtracted sprite positions because of the mvp
-				posTR = Vec3((tempTR.x + x) + halfW, (tempTR.y + y) + halfH, posTR.z);
-				posTL = Vec3((tempTL.x + x) + halfW, (tempTL.y + y) + halfH, posTL.z);
-				posBL = Vec3((tempBL.x + x) + halfW, (tempBL.y + y) + halfH, posBL.z);
-				posBR = Vec3((tempBR.x + x) + halfW, (tempBR.y + y) + halfH, posBR.z);
-			}
+		poolDraw.SortKey = MakeSortKey(layer, BlendMode::CUTOUT, p_pipeline->GetID(), loadedPool->second, 0.f);
+	}
 
-			SpriteVertex topRight;
-			SpriteVertex topLeft;
-			SpriteVertex bottomLeft;
-			SpriteVertex bottomRight;
+	void SpriteRenderer::DrawPool(const SpritePool& pool, const Camera& cam, uint8_t layer)
+	{
+		DrawPool(pool, cam.GetPV(), layer);
+	}
 
-			topRight.pos = posTR;
-			topRight.colour = sprite->GetColour();
-			topRight.texCoord = { sprite->GetUVInfo().x, sprite->GetUVInfo().w };
-			topRight.texIndex = rangedID;
+	void SpriteRenderer::queueDraws()
+	{
+		// Every call gets its own packets with its own view
+		for (const BatchDraw& batchDraw : m_batchDraws)
+			queueBatch(batchDraw);
 
-			topLeft.pos = posTL;
-			topLeft.colour = sprite->GetColour();
-			topLeft.texCoord = { sprite->GetUVInfo().z, sprite->GetUVInfo().w };
-			topLeft.texIndex = rangedID;
+		m_batchDraws.clear();
+		m_visibleSlots.clear();
 
-			bottomLeft.pos = posBL;
-			bottomLeft.colour = sprite->GetColour();
-			bottomLeft.texCoord = { sprite->GetUVInfo().z, sprite->GetUVInfo().y };
-			bottomLeft.texIndex = rangedID;
+		for (uint32_t i = 0; i < (uint32_t)m_instanceInfos.size(); ++i)
+			queueInstanced(i);
 
-			bottomRight.pos = posBR;
-			bottomRight.colour = sprite->GetColour();
-			bottomRight.texCoord = { sprite->GetUVInfo().x, sprite->GetUVInfo().y };
-			bottomRight.texIndex = rangedID;
+		for (uint32_t i = 0; i < (uint32_t)m_poolDraws.size(); ++i)
+			queuePool(i);
 
-			if (!sprite->GetTexture())
-				sprite->SetTexture(p_errorTexture);
+		queueImmediate();
+	}
 
-			sData.Vertices.push_back(topRight);
-			sData.Vertices.push_back(topLeft);
-			sData.Vertices.push_back(bottomLeft);
-			sData.Vertices.push_back(bottomRight);
-		}
+	void SpriteRenderer::queueBatch(const BatchDraw& batchDraw)
+	{
+		const SpriteBatch& batch = m_batches[batchDraw.Batch];
+		const RenderData& rData = batch.RenderInfo;
 
-		uint32_t offset = 0;
-		for (size_t i = 0; i < sprites.size(); ++i)
+		if (rData.QuadCount == 0 || (batchDraw.IsCulled && batchDraw.VisibleSlotCount == 0)) return;
+
+		DrawPacket packet{};
+		packet.SortKey = batch.SortKey;
+
+		if (batch.IsBaked)
 		{
-			sData.Indices.push_back(offset);
-			sData.Indices.push_back(1 + offset);
-			sData.Indices.push_back(2 + offset);
-			sData.Indices.push_back(2 + offset);
-			sData.Indices.push_back(3 + offset);
-			sData.Indices.push_back(offset);
+			// Executes the draw's recording, it was brought up to date when the batch was uploaded
+			packet.Type = DrawPacketType::EXECUTE;
+			packet.CmdBuffer = batch.BakedDraws[m_renderer.GetCurFrame()][batchDraw.BakedDrawIndex].CmdBuffer;
 
-			offset += 4;
+			m_renderer.AddDrawPacket(packet);
+			return;
 		}
 
-		// Since all our vertices and indices are in one buffer we need data extract it at the correct places
+		setBatchState(packet, p_pipeline, batchDraw.View);
+		packet.VertexBuffer = rData.Buffer;
 
-		if (rData.SpriteInfos.size() > 1)
+		if (batchDraw.IsCulled || batch.Blend == BlendMode::TRANSLUCENT)
 		{
-			sData.StartVertex =
-				m_renderInfos[renderDataIndex].SpriteInfos[spriteDataIndex - 1].StartVertex +
-				m_renderInfos[renderDataIndex].SpriteInfos[spriteDataIndex - 1].SizeOfVerticesInBytes();
+			// Only the visible quads get indices, translucent ones follow the back to front
+			// order so blending comes out right
+			const uint32_t* pDrawSlots = batchDraw.IsCulled ? &m_visibleSlots[batchDraw.FirstVisibleSlot] :
+				rData.DrawOrder.data();
+			uint32_t drawSlotCount = batchDraw.IsCulled ? batchDraw.VisibleSlotCount : rData.QuadCount;
+
+			m_renderer.SetQuadIndices(packet, pDrawSlots, drawSlotCount);
+
+			packet.Type = DrawPacketType::DRAW_INDEXED;
+			packet.Count = drawSlotCount * 6;
+			packet.InstanceCount = 1;
+
+			m_renderer.AddDrawPacket(packet);
+			return;
 		}
-		else
-			sData.StartIndex = 0;
 
-		uint32_t indexOffset = 0;
-		for (auto& data : rData.SpriteInfos)
+		queueQuadChunks(packet, rData.QuadCount);
+	}
+
+	void SpriteRenderer::queuePool(uint32_t poolDrawIndex)
+	{
+		PoolDraw& poolDraw = m_poolDraws[poolDrawIndex];
+
+		// Every call draws the same streamed vertices
+		for (const DrawView& view : poolDraw.Views)
 		{
-			SpriteData& lastData = rData.SpriteInfos[rData.SpriteInfos.size() - 1];
+			if (poolDraw.QuadCount == 0) continue;
+
+			DrawPacket packet{};
+			packet.SortKey = poolDraw.SortKey;
+			packet.IsTransient = VK_TRUE; // Streamed into the dynamic vertex buffer
+
+			setBatchState(packet, p_pipeline, view);
+			packet.VertexBuffer = poolDraw.Vertices.Buffer;
+			packet.VertexOffset = poolDraw.Vertices.Offset;
 
-			data.StartIndex = lastData.StartVertex +
-				(sizeof(SpriteVertex) * lastData.Vertices.size()) + indexOffset;
-			indexOffset += (uint32_t)data.SizeOfIndicesInBytes();
+			queueQuadChunks(packet, poolDraw.QuadCount);
 		}
+
+		poolDraw.Views.clear();
 	}
 
-	void SpriteRenderer::allocateDescriptorInfo()
+	void SpriteRenderer::DrawSprite(const Sprite& sprite, const Mat4& pv)
 	{
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = p_pipeline->GetDescriptorPool();
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = p_pipeline->GetDescriptorSetLayoutPtr();
+		std::shared_ptr<Texture2D> texture = sprite.GetTexture();
 
-		if (vkAllocateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
-			&allocInfo, &m_descriptorSet) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate descriptor sets!");
+		uint16_t texIndex = (uint16_t)(texture ?
+			Core::GetCore().GetTextureRegistry()->Register(*texture) : m_errorTextureSlot);
 
-		p_pipeline->SetIsDescriptorSetAllocated(true);
+		QuadCornerBatch corners;
+		corners.Count = 0;
+
+		AddQuad(corners, sprite);
+		TransformQuadCorners(corners);
+
+		SpriteVertex* pQuad = (SpriteVertex*)m_immediateSprites.Begin(*m_renderer.GetDynamicVertexBuffer(), 1,
+			makeView(pv));
+
+		writeQuad(pQuad, corners, 0, sprite.GetZ() + sprite.GetDepth(), sprite.GetColour(), sprite.GetUVInfo(),
+			texIndex);
+
+		m_immediateSprites.End(1);
 	}
 
-	void SpriteRenderer::createBuffer(uint32_t renderDataIndex)
+	void SpriteRenderer::SetImmediateLayer(uint8_t layer)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		m_immediateLayer = layer;
 
-		if (rData.SpriteInfos.empty()) return;
+		m_immediateSortKey = MakeSortKey(m_immediateLayer, BlendMode::CUTOUT, p_pipeline->GetID(),
+			IMMEDIATE_SORT_STATE_ID, 0.f);
+	}
 
-		if (rData.IsBufferCreated)
+	void SpriteRenderer::queueImmediate()
+	{
+		for (const ImmediateDrawList::Draw& immediateDraw : m_immediateSprites.GetDraws())
 		{
-			vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), rData.Buffer, nullptr);
-			vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), rData.BufferMemory, nullptr);
+			if (immediateDraw.Count == 0) continue;
+
+			DrawPacket packet{};
+			packet.SortKey = m_immediateSortKey;
+			packet.IsTransient = VK_TRUE;
+
+			setBatchState(packet, p_pipeline, immediateDraw.View);
+			packet.VertexBuffer = immediateDraw.Buffer;
+			packet.VertexOffset = immediateDraw.Offset;
+
+			queueQuadChunks(packet, immediateDraw.Count);
 		}
 
-		VkDeviceSize bufferSize = 0;
+		// The packets point into the dynamic vertex buffer, the list starts over next frame
+		m_immediateSprites.Clear();
+	}
+
+	void SpriteRenderer::updateBakedDraw(SpriteBatch& batch, const BatchDraw& batchDraw)
+	{
+		if (batch.RenderInfo.QuadCount == 0) return;
 
-		rData.TotalVerticeSize = 0;
-		for (auto& data : rData.SpriteInfos)
+		std::vector<BakedDraw>& frameBakedDraws = batch.BakedDraws[m_renderer.GetCurFrame()];
+
+		if (batchDraw.BakedDrawIndex >= (uint32_t)frameBakedDraws.size())
+			frameBakedDraws.resize(batchDraw.BakedDrawIndex + 1);
+
+		BakedDraw& bakedDraw = frameBakedDraws[batchDraw.BakedDrawIndex];
+		const DrawView& view = batchDraw.View;
+
+		if (bakedDraw.ViewSlot == INVALID_BATCH_SLOT)
+			bakedDraw.ViewSlot = allocateBakedView(m_renderer.GetCurFrame());
+
+		// The frame's fence was waited on so the GPU is done reading last use's view projection
+		memcpy((char*)p_bakedViews + bakedViewOffset(m_renderer.GetCurFrame(), bakedDraw.ViewSlot),
+			&view.ViewProjection, sizeof(Mat4));
+
+		bool isOutOfDate = bakedDraw.CmdBuffer == VK_NULL_HANDLE ||
+			bakedDraw.Pipeline != p_bakedPipeline->GetPipeline() ||
+			bakedDraw.TextureSet != Core::GetCore().GetTextureRegistry()->GetDescriptorSet() ||
+			bakedDraw.RenderPass != Core::GetCore().GetSwapchain()->GetRenderPass() ||
+			bakedDraw.VertexBuffer != batch.RenderInfo.Buffer ||
+			bakedDraw.IndexBuffer != m_renderer.GetQuadIndexBuffer() ||
+			memcmp(&bakedDraw.Viewport, &view.Viewport, sizeof(VkViewport)) != 0 ||
+			memcmp(&bakedDraw.Scissor, &view.Scissor, sizeof(VkRect2D)) != 0;
+
+		if (isOutOfDate)
 		{
-			bufferSize += data.SizeInBytes();
-			rData.TotalVerticeSize += (uint32_t)data.SizeOfVerticesInBytes();
+			bakedDraw.Viewport = view.Viewport;
+			bakedDraw.Scissor = view.Scissor;
+
+			recordBakedDraw(batch, bakedDraw);
 		}
+	}
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+	void SpriteRenderer::recordBakedDraw(SpriteBatch& batch, BakedDraw& bakedDraw)
+	{
+		const RenderData& rData = batch.RenderInfo;
 
-		Core::GetCore().CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
+		if (bakedDraw.CmdBuffer == VK_NULL_HANDLE)
+			bakedDraw.CmdBuffer = m_renderer.AllocateSecondaryCommandBuffer();
 
-		void* data;
-		vkMapMemory(Core::GetCore().GetDevice()->GetDevice(),
-			stagingBufferMemory, 0, bufferSize, 0, &data);
+		// Reusable, the kept command buffers of every swapchain image that uses this frame index execute it,
+		// so it's begun with simultaneous use instead of one time submit
+		m_renderer.BeginSecondaryCommandBuffer(bakedDraw.CmdBuffer, true);
 
-		// Create the vertices
-		for (auto& spriteInfo : rData.SpriteInfos)
-			memcpy((char*)data + spriteInfo.StartVertex, spriteInfo.Vertices.data(), spriteInfo.SizeOfVerticesInBytes());
+		// The command buffer starts with nothing bound, not whatever the frame's encoders have
+		CommandEncoder encoder(bakedDraw.CmdBuffer);
 
-		// Create the indices
-		for (auto& spriteInfo : rData.SpriteInfos)
-			memcpy((char*)data + spriteInfo.StartIndex, spriteInfo.Indices.data(), spriteInfo.SizeOfIndicesInBytes());
+		DrawPacket packet{};
+		packet.Viewport = bakedDraw.Viewport;
+		packet.Scissor = bakedDraw.Scissor;
 
-		vkUnmapMemory(Core::GetCore().GetDevice()->GetDevice(), stagingBufferMemory);
+		packet.Pipeline = p_bakedPipeline->GetPipeline();
+		packet.PipelineLayout = p_bakedPipeline->GetPipelineLayout();
 
-		Core::GetCore().CreateBuffer(bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			rData.Buffer, rData.BufferMemory);
+		// Secondary command buffers don't inherit push constants, the view projection is read from the slot
+		packet.DescriptorSets[0] = getBakedViewSet(m_renderer.GetCurFrame(), bakedDraw.ViewSlot);
+		packet.DescriptorSets[1] = Core::GetCore().GetTextureRegistry()->GetDescriptorSet();
+		packet.DescriptorSetCount = 2;
 
-		Core::GetCore().CopyBuffer(stagingBuffer, rData.Buffer, bufferSize);
+		packet.VertexBuffer = rData.Buffer;
 
-		vkDestroyBuffer(Core::GetCore().GetDevice()->GetDevice(), stagingBuffer, nullptr);
-		vkFreeMemory(Core::GetCore().GetDevice()->GetDevice(), stagingBufferMemory, nullptr);
+		// Baked quads are stored in draw order so the shared indices work for translucent batches too
+		m_renderer.SetQuadIndexBuffer(packet, std::min(rData.QuadCount, (uint32_t)MAX_QUADS_PER_DRAW));
 
-		rData.IsBufferCreated = true;
+		packet.Type = DrawPacketType::DRAW_INDEXED;
+		packet.InstanceCount = 1;
+
+		// Every chunk uses the same indices and offsets its vertices instead
+		for (uint32_t firstQuad = 0; firstQuad < rData.QuadCount; firstQuad += MAX_QUADS_PER_DRAW)
+		{
+			packet.Count = std::min(rData.QuadCount - firstQuad, (uint32_t)MAX_QUADS_PER_DRAW) * 6;
+			packet.BaseVertex = (int32_t)(firstQuad * 4);
+
+			Renderer::RecordDrawPacket(encoder, packet);
+		}
+
+		if (vkEndCommandBuffer(bakedDraw.CmdBuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to record baked batch!");
+
+		bakedDraw.Pipeline = p_bakedPipeline->GetPipeline();
+		bakedDraw.TextureSet = Core::GetCore().GetTextureRegistry()->GetDescriptorSet();
+		bakedDraw.RenderPass = Core::GetCore().GetSwapchain()->GetRenderPass();
+		bakedDraw.VertexBuffer = rData.Buffer;
+		bakedDraw.IndexBuffer = m_renderer.GetQuadIndexBuffer();
+
+		// The frames the renderer kept execute the old recording
+		m_renderer.InvalidateRecordCache();
 	}
 
-	void SpriteRenderer::createUniformBuffer()
+	void SpriteRenderer::createBakedViews()
 	{
-		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+		if (!p_bakedPipeline)
+		{
+			p_bakedPipeline = new SpritePipeline("resources/shaders/spir-v/SpriteBakedVert.spv",
+				"resources/shaders/spir-v/SpriteFrag.spv", nullptr, SpriteVertexLayout::BAKED);
+			m_canDeleteBakedPipeline = true;
+		}
 
-		Core::GetCore().CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		if (m_bakedViewBuffer != VK_NULL_HANDLE) return;
+
+		VkPhysicalDeviceProperties physicalDeviceProperties{};
+		vkGetPhysicalDeviceProperties(Core::GetCore().GetDevice()->GetPhysicalDevice(),
+			&physicalDeviceProperties);
+
+		// Every slot is bound at its own offset
+		VkDeviceSize alignment = physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+		m_bakedViewStride = (sizeof(Mat4) + alignment - 1) & ~(alignment - 1);
+
+		VkDeviceSize size = bakedViewOffset(MAX_FRAMES_IN_FLIGHT, 0);
+
+		Core::GetCore().CreateBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			m_uniformBuffer, m_uniformMemory);
+			m_bakedViewBuffer, m_bakedViewMemory);
+
+		// Mapped for the lifetime of the buffer
+		if (vkMapMemory(Core::GetCore().GetDevice()->GetDevice(), m_bakedViewMemory, 0,
+			size, 0, &p_bakedViews) != VK_SUCCESS)
+			throw std::runtime_error("Failed to map baked view buffer memory!");
 	}
 
-	void SpriteRenderer::updateDescriptorWrites()
+	uint32_t SpriteRenderer::allocateBakedView(uint32_t frame)
 	{
-		std::array<VkWriteDescriptorSet, 3> setWrites{};
+		uint32_t slot = m_bakedViewSlots[frame].Allocate();
+
+		if (slot >= MAX_BAKED_SPRITE_DRAWS)
+		{
+			m_bakedViewSlots[frame].Free(slot);
+			throw std::runtime_error("Too many baked sprite draws in a frame, see MAX_BAKED_SPRITE_DRAWS!");
+		}
+
+		return slot;
+	}
+
+	VkDescriptorSet SpriteRenderer::getBakedViewSet(uint32_t frame, uint32_t slot)
+	{
+		std::vector<VkDescriptorSet>& frameSets = m_bakedViewSets[frame];
+
+		if (slot >= (uint32_t)frameSets.size())
+			frameSets.resize(slot + 1, VK_NULL_HANDLE);
+
+		if (frameSets[slot] != VK_NULL_HANDLE) return frameSets[slot];
 
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = p_bakedPipeline->GetDescriptorPool();
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = p_bakedPipeline->GetDescriptorSetLayoutPtr();
+
+		if (vkAllocateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
+			&allocInfo, &frameSets[slot]) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate baked view descriptor set!");
+
+		p_bakedPipeline->SetIsDescriptorSetAllocated(true);
+
+		// The slot's view projection changes but its offset doesn't, so the set is only written once
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_uniformBuffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);
+		bufferInfo.buffer = m_bakedViewBuffer;
+		bufferInfo.offset = bakedViewOffset(frame, slot);
+		bufferInfo.range = sizeof(Mat4);
+
+		std::array<VkWriteDescriptorSet, 2> setWrites{};
 
-		setWrites[0] = {};
 		setWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		setWrites[0].dstBinding = 0;
 		setWrites[0].dstArrayElement = 0;
 		setWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		setWrites[0].descriptorCount = 1;
 		setWrites[0].pBufferInfo = &bufferInfo;
-		setWrites[0].dstSet = m_descriptorSet;
+		setWrites[0].dstSet = frameSets[slot];
 
-		setWrites[1] = {};
 		setWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		setWrites[1].dstBinding = 1;
 		setWrites[1].dstArrayElement = 0;
 		setWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
 		setWrites[1].descriptorCount = 1;
-		setWrites[1].pBufferInfo = 0;
 		setWrites[1].pImageInfo = &m_samplerImageInfo;
-		setWrites[1].dstSet = m_descriptorSet;
-
-		setWrites[2] = {};
-		setWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		setWrites[2].dstBinding = 2;
-		setWrites[2].dstArrayElement = 0;
-		setWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		setWrites[2].descriptorCount = static_cast<uint32_t>(m_textureData->DescriptorImageInfos.size());
-		setWrites[2].pBufferInfo = 0;
-		setWrites[2].pImageInfo = m_textureData->DescriptorImageInfos.data();
-		setWrites[2].dstSet = m_descriptorSet;
+		setWrites[1].dstSet = frameSets[slot];
 
 		vkUpdateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
 			static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+
+		return frameSets[slot];
+	}
+
+	DrawView SpriteRenderer::makeView(const Mat4& viewProjection) const
+	{
+		return MakeDrawView(viewProjection, m_viewportInfo, m_scissorOffset, m_scissorExtent);
+	}
+
+	void SpriteRenderer::setBatchState(DrawPacket& packet, const IPipeline* pPipeline,
+		const DrawView& view) const
+	{
+		packet.Viewport = view.Viewport;
+		packet.Scissor = view.Scissor;
+
+		packet.Pipeline = pPipeline->GetPipeline();
+		packet.PipelineLayout = pPipeline->GetPipelineLayout();
+
+		// Both sprite pipelines use the same descriptor set layout
+		packet.DescriptorSets[0] = m_descriptorSet;
+		packet.DescriptorSets[1] = Core::GetCore().GetTextureRegistry()->GetDescriptorSet();
+		packet.DescriptorSetCount = 2;
+
+		SpritePushConstants pushConstants{};
+		pushConstants.pv = view.ViewProjection;
+
+		packet.PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
+		packet.PushConstantSize = sizeof(SpritePushConstants);
+		memcpy(packet.PushConstants, &pushConstants, sizeof(SpritePushConstants));
+	}
+
+	void SpriteRenderer::queueQuadChunks(DrawPacket packet, uint32_t quadCount)
+	{
+		m_renderer.SetQuadIndexBuffer(packet, std::min(quadCount, (uint32_t)MAX_QUADS_PER_DRAW));
+
+		packet.Type = DrawPacketType::DRAW_INDEXED;
+		packet.InstanceCount = 1;
+
+		// Every chunk uses the same indices and offsets its vertices instead
+		for (uint32_t firstQuad = 0; firstQuad < quadCount; firstQuad += MAX_QUADS_PER_DRAW)
+		{
+			packet.Count = std::min(quadCount - firstQuad, (uint32_t)MAX_QUADS_PER_DRAW) * 6;
+			packet.BaseVertex = (int32_t)(firstQuad * 4);
+
+			m_renderer.AddDrawPacket(packet);
+		}
+	}
+
+	void SpriteRenderer::queueInstanced(uint32_t instanceDataIndex)
+	{
+		InstanceData& iData = m_instanceInfos[instanceDataIndex];
+
+		if (iData.Views.empty()) return;
+
+		if (iData.Instances.empty() || (!iData.CanUpdateInstances && !iData.IsBufferCreated))
+		{
+			iData.Views.clear();
+			return;
+		}
+
+		DrawPacket packet{};
+
+		// 6 vertices for the quad, the corners come from gl_VertexIndex
+		packet.Type = DrawPacketType::DRAW;
+		packet.Count = 6;
+		packet.InstanceCount = (uint32_t)iData.Instances.size();
+		packet.VertexBuffer = iData.Buffer;
+
+		// Copied once a frame however many times the list is drawn
+		if (iData.CanUpdateInstances)
+		{
+			RingAllocation allocation = m_renderer.GetDynamicVertexBuffer()->Allocate(iData.SizeInBytes());
+
+			memcpy(allocation.pData, iData.Instances.data(), iData.SizeInBytes());
+
+			packet.VertexBuffer = allocation.Buffer;
+			packet.VertexOffset = allocation.Offset;
+			packet.IsTransient = VK_TRUE;
+		}
+
+		for (const DrawView& view : iData.Views)
+		{
+			setBatchState(packet, p_instancedPipeline, view);
+			m_renderer.AddDrawPacket(packet);
+		}
+
+		iData.Views.clear();
+	}
+
+	void SpriteRenderer::createTextureData(std::vector<std::shared_ptr<Sprite>>& sprites)
+	{
+		for (const std::shared_ptr<Sprite>& sprite : sprites)
+			registerTexture(sprite);
+	}
+
+	int SpriteRenderer::registerTexture(const std::shared_ptr<Sprite>& sprite)
+	{
+		if (!sprite->GetTexture())
+			return (int)m_errorTextureSlot;
+
+		return (int)Core::GetCore().GetTextureRegistry()->Register(*sprite->GetTexture());
+	}
+
+	void SpriteRenderer::populateVertices(SpriteBatch& batch, uint32_t slot)
+	{
+		const std::shared_ptr<Sprite>& sprite = batch.Sprites[slot];
+
+		registerTexture(sprite);
+
+		if (!sprite->GetTexture())
+			sprite->SetTexture(p_errorTexture);
+
+		// Sets the version after SetTexture so giving the sprite the error texture doesn't count as a change
+		buildQuads(batch, &slot, 1);
+
+		batch.Bounds.Set(slot, *sprite);
+		batch.BoundsVersions[slot] = sprite->GetVersion();
+
+		batch.RenderInfo.MarkDirty(slot);
+	}
+
+	void SpriteRenderer::buildQuads(SpriteBatch& batch, const uint32_t* pSlots, uint32_t count)
+	{
+		QuadCornerBatch corners;
+
+		for (uint32_t first = 0; first < count; first += QUAD_BATCH_SIZE)
+		{
+			uint32_t blockCount = std::min(count - first, (uint32_t)QUAD_BATCH_SIZE);
+
+			corners.Count = 0;
+
+			for (uint32_t i = 0; i < blockCount; ++i)
+				AddQuad(corners, *batch.Sprites[pSlots[first + i]]);
+
+			TransformQuadCorners(corners);
+
+			for (uint32_t i = 0; i < blockCount; ++i)
+			{
+				uint32_t slot = pSlots[first + i];
+				const std::shared_ptr<Sprite>& sprite = batch.Sprites[slot];
+
+				writeQuad(&batch.RenderInfo.Vertices[slot * 4], corners, i, sprite->GetZ() + sprite->GetDepth(),
+					sprite->GetColour(), sprite->GetUVInfo(), (uint16_t)findTextureSlot(sprite));
+
+				batch.Versions[slot] = sprite->GetVersion();
+			}
+		}
+	}
+
+	void SpriteRenderer::writeQuad(SpriteVertex* pQuad, const QuadCornerBatch& corners, uint32_t quad, float z,
+		const Vec4& colour, const Vec4& uvInfo, uint16_t texIndex)
+	{
+		int16_t depth = PackDepth(z);
+		uint32_t packedColour = PackColour(colour);
+
+		uint16_t right = PackUnorm16(uvInfo.x);
+		uint16_t bottom = PackUnorm16(uvInfo.y);
+		uint16_t left = PackUnorm16(uvInfo.z);
+		uint16_t top = PackUnorm16(uvInfo.w);
+
+		// Top right, top left, bottom left, bottom right like the corners
+		uint16_t texCoords[4][2] = { { right, top }, { left, top }, { left, bottom }, { right, bottom } };
+
+		for (uint32_t corner = 0; corner < 4; ++corner)
+		{
+			pQuad[corner].pos = Vec2(corners.CornerX[quad * 4 + corner], corners.CornerY[quad * 4 + corner]);
+			pQuad[corner].depth = depth;
+			pQuad[corner].texIndex = texIndex;
+			pQuad[corner].texCoord[0] = texCoords[corner][0];
+			pQuad[corner].texCoord[1] = texCoords[corner][1];
+			pQuad[corner].colour = packedColour;
+		}
+	}
+
+	void SpriteRenderer::populateInstances(std::vector<std::shared_ptr<Sprite>>& sprites,
+		uint32_t instanceDataIndex)
+	{
+		InstanceData& iData = m_instanceInfos[instanceDataIndex];
+
+		iData.Instances.resize(sprites.size());
+
+		for (size_t i = 0; i < sprites.size(); ++i)
+		{
+			const std::shared_ptr<Sprite>& sprite = sprites[i];
+			SpriteInstance& instance = iData.Instances[i];
+
+			Vec4 uvInfo = sprite->GetUVInfo();
+
+			// The sprite is scaled and rotated around its center
+			instance.center = Vec2(sprite->GetX() + sprite->GetWidth() * 0.5f, sprite->GetY() + sprite->GetHeight() * 0.5f);
+			instance.depth = PackDepth(sprite->GetZ() + sprite->GetDepth());
+			instance.texIndex = (uint16_t)findTextureSlot(sprite);
+			instance.size = Vec2(sprite->GetWidth() * sprite->GetScaleX(), sprite->GetHeight() * sprite->GetScaleY());
+			instance.rotation = sprite->GetRotationZ();
+			instance.uvInfo[0] = PackUnorm16(uvInfo.x);
+			instance.uvInfo[1] = PackUnorm16(uvInfo.y);
+			instance.uvInfo[2] = PackUnorm16(uvInfo.z);
+			instance.uvInfo[3] = PackUnorm16(uvInfo.w);
+			instance.colour = PackColour(sprite->GetColour());
+
+			if (!sprite->GetTexture())
+				sprite->SetTexture(p_errorTexture);
+		}
+	}
+
+	int SpriteRenderer::findTextureSlot(const std::shared_ptr<Sprite>& sprite)
+	{
+		if (!sprite->GetTexture())
+			return (int)m_errorTextureSlot;
+
+		int slot = Core::GetCore().GetTextureRegistry()->FindSlot(sprite->GetTextureID());
+
+		return slot >= 0 ? slot : (int)m_errorTextureSlot;
+	}
+
+	void SpriteRenderer::allocateDescriptorInfo()
+	{
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = p_pipeline->GetDescriptorPool();
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = p_pipeline->GetDescriptorSetLayoutPtr();
+
+		if (vkAllocateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
+			&allocInfo, &m_descriptorSet) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate descriptor sets!");
+
+		p_pipeline->SetIsDescriptorSetAllocated(true);
+	}
+
+	void SpriteRenderer::growRenderData(RenderData& rData, uint32_t quadCount)
+	{
+		uint32_t newCapacity = std::max(rData.QuadCapacity * 2, (uint32_t)MIN_BATCH_QUAD_CAPACITY);
+		while (newCapacity < quadCount)
+			newCapacity *= 2;
+
+		// Frames in flight might still be drawing from the old buffer
+		if (rData.Buffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(rData.Buffer, rData.BufferMemory);
+
+		// Filled by uploadBatches, the indices come from the renderer's shared quad index buffer
+		Core::GetCore().CreateBuffer(sizeof(SpriteVertex) * 4 * newCapacity,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rData.Buffer, rData.BufferMemory);
+
+		rData.Vertices.reserve(newCapacity * 4);
+		rData.QuadCapacity = newCapacity;
+		rData.IsBufferRecreated = true;
 	}
 
-	void SpriteRenderer::updateBuffer(uint32_t renderDataIndex)
+	void SpriteRenderer::createInstanceBuffer(uint32_t instanceDataIndex)
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		InstanceData& iData = m_instanceInfos[instanceDataIndex];
 
-		VkDeviceSize bufferSize = rData.TotalVerticeSize;
+		if (iData.Instances.empty()) return;
+
+		// Only recreate the buffer when the list outgrows it
+		if (!iData.IsBufferCreated || iData.InstanceCapacity < (uint32_t)iData.Instances.size())
+		{
+			// Frames in flight and the command buffers the renderer keeps might still use it
+			if (iData.IsBufferCreated)
+				m_renderer.DestroyBuffer(iData.Buffer, iData.BufferMemory);
+
+			iData.InstanceCapacity = (uint32_t)iData.Instances.size();
+
+			Core::GetCore().CreateBuffer(sizeof(SpriteInstance) * iData.InstanceCapacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				iData.Buffer, iData.BufferMemory);
+
+			iData.IsBufferCreated = true;
+		}
 
 		void* data;
 		vkMapMemory(Core::GetCore().GetDevice()->GetDevice(),
-			rData.BufferMemory, 0, bufferSize, 0, &data);
+			iData.BufferMemory, 0, iData.SizeInBytes(), 0, &data);
 
-		for (auto& spriteInfo : rData.SpriteInfos)
-			memcpy((char*)data + spriteInfo.StartVertex, spriteInfo.Vertices.data(), spriteInfo.SizeOfVerticesInBytes());
+		memcpy(data, iData.Instances.data(), iData.SizeInBytes());
 
-		vkUnmapMemory(Core::GetCore().GetDevice()->GetDevice(), rData.BufferMemory);
+		vkUnmapMemory(Core::GetCore().GetDevice()->GetDevice(), iData.BufferMemory);
 	}
 
-	void SpriteRenderer::updateUBO(const Mat4& pv)
+	void SpriteRenderer::updateDescriptorWrites()
 	{
-		ZDevice* pDevice = Core::GetCore().GetDevice();
+		std::array<VkWriteDescriptorSet, 1> setWrites{};
 
-		UniformBufferObject ubo{};
-		ubo.pv = pv;
+		setWrites[0] = {};
+		setWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrites[0].dstBinding = 1;
+		setWrites[0].dstArrayElement = 0;
+		setWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		setWrites[0].descriptorCount = 1;
+		setWrites[0].pBufferInfo = 0;
+		setWrites[0].pImageInfo = &m_samplerImageInfo;
+		setWrites[0].dstSet = m_descriptorSet;
 
-		void* data;
-		vkMapMemory(pDevice->GetDevice(), m_uniformMemory, 0, sizeof(ubo), 0, &data);
-		memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(pDevice->GetDevice(), m_uniformMemory);
+		vkUpdateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(),
+			static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
 	}
 
-	void SpriteRenderer::updateVertices(std::vector<std::shared_ptr<Sprite>>& sprites,
-		uint32_t renderDataIndex)
+	void SpriteRenderer::uploadBatches()
 	{
-		RenderData& rData = m_renderInfos[renderDataIndex];
+		m_cullStats = m_frameCullStats;
+		m_frameCullStats = CullStats();
+
+		m_immediateStats = ImmediateStats();
+
+		for (const ImmediateDrawList::Draw& immediateDraw : m_immediateSprites.GetDraws())
+		{
+			m_immediateStats.QuadCount += immediateDraw.Count;
+			m_immediateStats.DrawCount += immediateDraw.Count > 0 ? 1 : 0;
+		}
 
-		if (rData.Sprites.size() == 0) return;
+		streamPools();
 
-		size_t i = 0;
-		uint32_t sIndex = 0;
-		for (std::shared_ptr<Sprite> sprite : rData.Sprites)
+		for (BatchID batchID = 0; batchID < (BatchID)m_batches.size(); ++batchID)
 		{
-			// Once we finish updating one set of vertices we want to update the next
-			if (i >= rData.SpriteInfos[sIndex].Vertices.size())
+			SpriteBatch& batch = m_batches[batchID];
+
+			if (!batch.IsAlive) continue;
+
+			// The draws' indices into BakedDraws start over next frame
+			batch.FrameDrawCount = 0;
+
+			// Baked batches are only uploaded once
+			if (batch.IsBaked)
+			{
+				if (!batch.IsBakeUploaded)
+					uploadBakedBatch(batchID);
+
+				continue;
+			}
+
+			RenderData& rData = batch.RenderInfo;
+
+			if (batch.Blend == BlendMode::TRANSLUCENT)
+				sortQuads(batch);
+
+			updateSortKey(batchID);
+
+			// A new buffer starts out empty so every quad is uploaded
+			if (rData.IsBufferRecreated)
 			{
-				++sIndex;
+				m_renderer.UploadToBuffer(rData.Buffer, 0, rData.Vertices.data(),
+					sizeof(SpriteVertex) * rData.Vertices.size());
+
+				rData.IsBufferRecreated = false;
+				rData.DirtySlots.clear();
+			}
+
+			if (rData.DirtySlots.empty()) continue;
 
-				for (int i = sIndex; i < rData.SpriteInfos.size(); ++i)
+			std::sort(rData.DirtySlots.begin(), rData.DirtySlots.end());
+
+			// Only the slots that were added, removed or updated since the last frame,
+			// slots close to each other are copied together to keep the copy count down
+			uint32_t rangeStart = rData.DirtySlots[0];
+			uint32_t rangeEnd = rangeStart + 1;
+
+			for (size_t i = 1; i <= rData.DirtySlots.size(); ++i)
+			{
+				if (i < rData.DirtySlots.size() && rData.DirtySlots[i] <= rangeEnd + DIRTY_SLOT_MERGE_GAP)
 				{
-					if (rData.SpriteInfos[sIndex].CanUpdateVertices)
-						break;
+					rangeEnd = std::max(rangeEnd, rData.DirtySlots[i] + 1);
+					continue;
+				}
 
-					++sIndex;
+				m_renderer.UploadToBuffer(rData.Buffer, sizeof(SpriteVertex) * rangeStart * 4,
+					&rData.Vertices[rangeStart * 4], sizeof(SpriteVertex) * (rangeEnd - rangeStart) * 4);
+
+				if (i < rData.DirtySlots.size())
+				{
+					rangeStart = rData.DirtySlots[i];
+					rangeEnd = rangeStart + 1;
 				}
+			}
+
+			rData.DirtySlots.clear();
+		}
+
+		for (const BatchDraw& batchDraw : m_batchDraws)
+		{
+			SpriteBatch& batch = m_batches[batchDraw.Batch];
 
-				i = 0;
+			if (batch.IsBaked)
+			{
+				updateBakedDraw(batch, batchDraw);
+				continue;
 			}
 
-			float width = sprite->GetWidth();
-			float height = sprite->GetHeight();
-			float depth = sprite->GetDepth();
-			float x = sprite->GetX();
-			float y = sprite->GetY();
-			float z = sprite->GetZ();
+			// Keeps the visible slots of translucent draws back to front
+			if (!batchDraw.IsCulled || batchDraw.VisibleSlotCount == 0 || batch.Blend != BlendMode::TRANSLUCENT)
+				continue;
+
+			uint32_t* pVisibleSlots = &m_visibleSlots[batchDraw.FirstVisibleSlot];
+
+			std::fill(batch.Visible.begin(), batch.Visible.end(), (uint8_t)0);
+
+			for (uint32_t i = 0; i < batchDraw.VisibleSlotCount; ++i)
+				batch.Visible[pVisibleSlots[i]] = 1;
+
+			uint32_t count = 0;
+
+			for (uint32_t slot : batch.RenderInfo.DrawOrder)
+				if (batch.Visible[slot]) pVisibleSlots[count++] = slot;
+		}
+
+		queueDraws();
+	}
+
+	void SpriteRenderer::streamPools()
+	{
+		for (PoolDraw& poolDraw : m_poolDraws)
+		{
+			poolDraw.QuadCount = 0;
+
+			if (poolDraw.Views.empty()) continue;
 
-			bool isScaled = sprite->GetScaleX() != 1.f || sprite->GetScaleY() != 1.f || sprite->GetScaleZ() != 1.f;
-			bool isRotated = sprite->GetRotationX() != 0.f || sprite->GetRotationY() != 0.f || sprite->GetRotationZ() != 0.f;
+			const SpritePool& pool = *poolDraw.pPool;
+			uint32_t spriteCount = pool.GetCount();
 
-			Vec3 posBL(x, y, z + depth);
-			Vec3 posBR(x + width, y, z + depth);
-			Vec3 posTR(x + width, y + height, z + depth);
-			Vec3 posTL(x, y + height, z + depth);
+			if (spriteCount == 0) continue;
 
-			if (isScaled || isRotated)
+			// Allocated up front since the ring can't be allocated from the worker threads
+			poolDraw.Vertices = m_renderer.GetDynamicVertexBuffer()->Allocate(sizeof(SpriteVertex) * 4 * spriteCount);
+			poolDraw.QuadCount = spriteCount;
+
+			SpriteVertex* pVertices = (SpriteVertex*)poolDraw.Vertices.pData;
+
+			m_renderer.GetWorkerPool()->ParallelFor(spriteCount, MIN_PARALLEL_QUAD_COUNT,
+				[this, &pool, pVertices](uint32_t begin, uint32_t end)
+				{ buildPoolQuads(pool, begin, end - begin, pVertices); });
+		}
+	}
+
+	void SpriteRenderer::buildPoolQuads(const SpritePool& pool, uint32_t first, uint32_t count,
+		SpriteVertex* pVertices) const
+	{
+		const float* pPosX = pool.GetPosXData();
+		const float* pPosY = pool.GetPosYData();
+		const float* pZ = pool.GetZData();
+		const float* pWidth = pool.GetWidthData();
+		const float* pHeight = pool.GetHeightData();
+		const float* pRotation = pool.GetRotationData();
+		const float* pScaleX = pool.GetScaleXData();
+		const float* pScaleY = pool.GetScaleYData();
+		const Vec4* pColours = pool.GetColourData();
+		const Vec4* pUVInfos = pool.GetUVInfoData();
+		const uint32_t* pTextureSlots = pool.GetTextureSlotData();
+
+		QuadCornerBatch corners;
+
+		for (uint32_t blockFirst = first; blockFirst < first + count; blockFirst += QUAD_BATCH_SIZE)
+		{
+			uint32_t blockCount = std::min(first + count - blockFirst, (uint32_t)QUAD_BATCH_SIZE);
+
+			corners.Count = 0;
+
+			for (uint32_t sprite = blockFirst; sprite < blockFirst + blockCount; ++sprite)
+				AddQuad(corners, pPosX[sprite], pPosY[sprite], pWidth[sprite], pHeight[sprite],
+					pRotation[sprite], pScaleX[sprite], pScaleY[sprite]);
+
+			TransformQuadCorners(corners);
+
+			for (uint32_t i = 0; i < blockCount; ++i)
 			{
-				float halfW = width / 2.f;
-				float halfH = height / 2.f;
-
-				// Set positions to be the origin so we rotate around that
-				// We have to subtract by our sprite position because of our mvp
-				Vec2 tempTL((posTL.x - x) - halfW, (posTL.y - y) - halfH);
-				Vec2 tempTR((posTR.x - x) - halfW, (posTR.y - y) - halfH);
-				Vec2 tempBL((posBL.x - x) - halfW, (posBL.y - y) - halfH);
-				Vec2 tempBR((posBR.x - x) - halfW, (posBR.y - y) - halfH);
-
-				// Create our translation matrices
-				Mat4 scaleMat = Mat4::Scale(sprite->GetScaleX(), sprite->GetScaleY(), sprite->GetScaleZ());
-				Mat4 rotateXMat = Mat4::RotateX(sprite->GetRotationX());
-				Mat4 rotateYMat = Mat4::RotateY(sprite->GetRotationY());
-				Mat4 rotateZMat = Mat4::RotateZ(sprite->GetRotationZ());
-
-				Mat4 translateMat = scaleMat * (rotateXMat * rotateYMat * rotateZMat);
-
-				// Rotate the positions
-				tempTR = translateMat * tempTR;
-				tempTL = translateMat * tempTL;
-				tempBL = translateMat * tempBL;
-				tempBR = translateMat * tempBR;
-
-				// Set the positions back to their original position 
-				// (doing it how we did will rotate around the center of the sprite)
-				// We also have to add back our subtracted sprite positions because of the mvp
-				posTR = Vec3((tempTR.x + x) + halfW, (tempTR.y + y) + halfH, posTR.z);
-				posTL = Vec3((tempTL.x + x) + halfW, (tempTL.y + y) + halfH, posTL.z);
-				posBL = Vec3((tempBL.x + x) + halfW, (tempBL.y + y) + halfH, posBL.z);
-				posBR = Vec3((tempBR.x + x) + halfW, (tempBR.y + y) + halfH, posBR.z);
+				uint32_t sprite = blockFirst + i;
+
+				uint32_t texIndex = pTextureSlots[sprite] == INVALID_TEXTURE_SLOT ?
+					m_errorTextureSlot : pTextureSlots[sprite];
+
+				writeQuad(&pVertices[sprite * 4], corners, i, pZ[sprite], pColours[sprite], pUVInfos[sprite],
+					(uint16_t)texIndex);
 			}
+		}
+	}
 
-			rData.SpriteInfos[sIndex].Vertices[i].pos = posTR;
-			rData.SpriteInfos[sIndex].Vertices[i].colour = sprite->GetColour();
-			rData.SpriteInfos[sIndex].Vertices[i].texCoord = { sprite->GetUVInfo().x, sprite->GetUVInfo().w };
+	void SpriteRenderer::uploadBakedBatch(BatchID batchID)
+	{
+		SpriteBatch& batch = m_batches[batchID];
+		RenderData& rData = batch.RenderInfo;
+
+		if (batch.Blend == BlendMode::TRANSLUCENT)
+			sortQuads(batch);
+
+		updateSortKey(batchID);
+
+		// Freed slots are left out
+		std::vector<SpriteVertex> vertices;
+		vertices.reserve(batch.Slots.GetUsedCount() * 4);
+
+		for (uint32_t i = 0; i < rData.QuadCount; ++i)
+		{
+			uint32_t slot = batch.Blend == BlendMode::TRANSLUCENT ? rData.DrawOrder[i] : i;
+
+			if (!batch.Sprites[slot]) continue;
+
+			vertices.insert(vertices.end(), rData.Vertices.begin() + slot * 4, rData.Vertices.begin() + slot * 4 + 4);
+
+			if (batch.Sprites[slot]->GetTexture())
+				batch.BakedTextures.push_back(batch.Sprites[slot]->GetTexture());
+		}
+
+		std::sort(batch.BakedTextures.begin(), batch.BakedTextures.end());
+		batch.BakedTextures.erase(std::unique(batch.BakedTextures.begin(), batch.BakedTextures.end()),
+			batch.BakedTextures.end());
+
+		// Frames in flight might still be drawing from the old buffer
+		if (rData.Buffer != VK_NULL_HANDLE)
+			m_renderer.DestroyBuffer(rData.Buffer, rData.BufferMemory);
+
+		rData.Buffer = VK_NULL_HANDLE;
+		rData.BufferMemory = VK_NULL_HANDLE;
+		rData.QuadCount = (uint32_t)vertices.size() / 4;
+		rData.QuadCapacity = rData.QuadCount;
+		rData.IsBufferRecreated = false;
+
+		// Never written again so it's only device local, the vertices are staged in the dynamic vertex buffer
+		if (rData.QuadCount > 0)
+		{
+			Core::GetCore().CreateBuffer(sizeof(SpriteVertex) * vertices.size(),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rData.Buffer, rData.BufferMemory);
 
-			rData.SpriteInfos[sIndex].Vertices[i + 1].pos = posTL;
-			rData.SpriteInfos[sIndex].Vertices[i + 1].colour = sprite->GetColour();
-			rData.SpriteInfos[sIndex].Vertices[i + 1].texCoord = { sprite->GetUVInfo().z, sprite->GetUVInfo().w };
+			m_renderer.UploadToBuffer(rData.Buffer, 0, vertices.data(), sizeof(SpriteVertex) * vertices.size());
+		}
+
+		// The vertices only live on the GPU now
+		std::vector<SpriteVertex>().swap(rData.Vertices);
+		std::vector<uint32_t>().swap(rData.DirtySlots);
+		std::vector<uint32_t>().swap(rData.DrawOrder);
+
+		std::vector<std::shared_ptr<Sprite>>().swap(batch.Sprites);
+		std::vector<uint32_t>().swap(batch.Versions);
+		std::vector<uint32_t>().swap(batch.BoundsVersions);
+		std::vector<uint8_t>().swap(batch.Visible);
+		batch.Bounds = QuadBounds();
+
+		batch.IsBakeUploaded = true;
+	}
 
-			rData.SpriteInfos[sIndex].Vertices[i + 2].pos = posBL;
-			rData.SpriteInfos[sIndex].Vertices[i + 2].colour = sprite->GetColour();
-			rData.SpriteInfos[sIndex].Vertices[i + 2].texCoord = { sprite->GetUVInfo().z, sprite->GetUVInfo().y };
+	void SpriteRenderer::sortQuads(SpriteBatch& batch)
+	{
+		RenderData& rData = batch.RenderInfo;
 
-			rData.SpriteInfos[sIndex].Vertices[i + 3].pos = posBR;
-			rData.SpriteInfos[sIndex].Vertices[i + 3].colour = sprite->GetColour();
-			rData.SpriteInfos[sIndex].Vertices[i + 3].texCoord = { sprite->GetUVInfo().x, sprite->GetUVInfo().y };
+		// Sprites usually move a little each frame so last frame's order is close to sorted
+		if (rData.DrawOrder.size() != rData.QuadCount)
+		{
+			rData.DrawOrder.resize(rData.QuadCount);
 
-			i += 4;
+			for (uint32_t i = 0; i < rData.QuadCount; ++i)
+				rData.DrawOrder[i] = i;
 		}
+
+		m_depthKeys.resize(rData.QuadCount);
+
+		// Inverted so the furthest sprite comes first
+		for (uint32_t i = 0; i < rData.QuadCount; ++i)
+			m_depthKeys[i] = ~DepthToSortBits(UnpackDepth(rData.Vertices[rData.DrawOrder[i] * 4].depth));
+
+		m_depthSorter.Sort(m_depthKeys, rData.DrawOrder);
+	}
+
+	void SpriteRenderer::updateSortKey(BatchID batchID)
+	{
+		SpriteBatch& batch = m_batches[batchID];
+		const RenderData& rData = batch.RenderInfo;
+
+		// Cutout batches rely on the depth test so only translucent batches are ordered by depth
+		float depth = 0.f;
+		if (batch.Blend == BlendMode::TRANSLUCENT && !rData.DrawOrder.empty())
+			depth = UnpackDepth(rData.Vertices[rData.DrawOrder[0] * 4].depth);
+
+		batch.SortKey = MakeSortKey(batch.Layer, batch.Blend, p_pipeline->GetID(), batchID, depth);
 	}
 
 	void SpriteRenderer::swapchainRecreateEvent(SwapchainRecreateEvent& e)
@@ -11,21 +11,18 @@
 
 namespace ZVK
 {
-	//std::queue<uint32_t> Texture2D::s_freedIDs;
+	std::queue<uint32_t> Texture2D::s_freedIDs;
 	uint32_t Texture2D::s_idCounter = 0;
 
 	Texture2D::Texture2D()
 		: m_width(0), m_height(0), m_mipLevels(0)
 	{ 
-		m_id = s_idCounter;
-
-		++s_idCounter;
+		m_id = nextID();
 	}
 
 	Texture2D::Texture2D(const std::string& filePath, VkFormat colourFormat)
 	{
-		m_id = s_idCounter;
-		++s_idCounter;
+		m_id = nextID();
 
 		LoadTexture(filePath, colourFormat);
 	}
@@ -38,6 +35,22 @@ namespace ZVK
 
 		vkDestroyImage(device, m_image, nullptr);
 		vkFreeMemory(device, m_imageMemory, nullptr);
+
+		if (TextureRegistry* pRegistry = Core::GetCore().GetTextureRegistry())
+			pRegistry->Release(m_id);
+
+		s_freedIDs.push(m_id);
+	}
+
+	uint32_t Texture2D::nextID()
+	{
+		if (s_freedIDs.empty())
+			return s_idCounter++;
+
+		uint32_t id = s_freedIDs.front();
+		s_freedIDs.pop();
+
+		return id;
 	}
 
 	// VK_FORMAT_R8G8B8A8_UNORM
@@ -0,0 +1,249 @@
+#include "../../Headers/Render/TextureRegistry.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../Headers/Core/Core.h"
+
+namespace ZVK
+{
+	TextureRegistry::TextureRegistry()
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		indexingProperties.pNext = nullptr;
+
+		VkPhysicalDeviceProperties2 deviceProperties2{};
+		deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		deviceProperties2.pNext = &indexingProperties;
+
+		vkGetPhysicalDeviceProperties2(pDevice->GetPhysicalDevice(), &deviceProperties2);
+
+		m_maxCapacity = std::min({ pDevice->GetMaxTextureSlots(),
+			indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			(uint32_t)MAX_TEXTURE_REGISTRY_CAPACITY });
+
+		createDescriptorSetLayout();
+		grow(MIN_TEXTURE_REGISTRY_CAPACITY);
+	}
+
+	TextureRegistry::~TextureRegistry()
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		for (RetiredPool& retired : m_retiredPools)
+			vkDestroyDescriptorPool(pDevice->GetDevice(), retired.Pool, nullptr);
+
+		vkDestroyDescriptorPool(pDevice->GetDevice(), m_descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(pDevice->GetDevice(), m_descriptorSetLayout, nullptr);
+	}
+
+	uint32_t TextureRegistry::Register(const Texture2D& texture)
+	{
+		uint32_t textureID = texture.GetID();
+
+		int32_t existingSlot = FindSlot(textureID);
+		if (existingSlot >= 0)
+			return (uint32_t)existingSlot;
+
+		uint32_t slot = allocateSlot();
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = texture.GetSampler();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = texture.GetImageView();
+
+		m_imageInfos[slot] = imageInfo;
+
+		if (textureID >= (uint32_t)m_slotsByID.size())
+			m_slotsByID.resize(textureID + 1, -1);
+
+		m_slotsByID[textureID] = (int32_t)slot;
+		++m_textureCount;
+
+		writeSlots(slot, 1);
+
+		return slot;
+	}
+
+	void TextureRegistry::Release(uint32_t textureID)
+	{
+		int32_t slot = FindSlot(textureID);
+		if (slot < 0)
+			return;
+
+		m_slotsByID[textureID] = -1;
+		m_imageInfos[slot].imageView = VK_NULL_HANDLE;
+		--m_textureCount;
+
+		m_releasedSlots.push_back({ (uint32_t)slot, MAX_FRAMES_IN_FLIGHT });
+	}
+
+	void TextureRegistry::BeginFrame()
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		for (size_t i = 0; i < m_releasedSlots.size();)
+		{
+			if (--m_releasedSlots[i].FramesLeft > 0)
+			{
+				++i;
+				continue;
+			}
+
+			m_freeSlots.push_back(m_releasedSlots[i].Slot);
+
+			m_releasedSlots[i] = m_releasedSlots.back();
+			m_releasedSlots.pop_back();
+		}
+
+		for (size_t i = 0; i < m_retiredPools.size();)
+		{
+			if (--m_retiredPools[i].FramesLeft > 0)
+			{
+				++i;
+				continue;
+			}
+
+			vkDestroyDescriptorPool(pDevice->GetDevice(), m_retiredPools[i].Pool, nullptr);
+
+			m_retiredPools[i] = m_retiredPools.back();
+			m_retiredPools.pop_back();
+		}
+	}
+
+	void TextureRegistry::createDescriptorSetLayout()
+	{
+		// The array is sized to the bound, each set only allocates the registry's current capacity
+		VkDescriptorBindingFlagsEXT bindFlags =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT extendedInfo{};
+		extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		extendedInfo.bindingCount = 1;
+		extendedInfo.pBindingFlags = &bindFlags;
+		extendedInfo.pNext = nullptr;
+
+		VkDescriptorSetLayoutBinding sampledImageLayoutBinding{};
+		sampledImageLayoutBinding.binding = TEXTURE_REGISTRY_BINDING;
+		sampledImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		sampledImageLayoutBinding.descriptorCount = m_maxCapacity;
+		sampledImageLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		sampledImageLayoutBinding.pImmutableSamplers = nullptr;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &sampledImageLayoutBinding;
+		layoutInfo.pNext = &extendedInfo;
+
+		if (vkCreateDescriptorSetLayout(Core::GetCore().GetDevice()->GetDevice(), &layoutInfo,
+			nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create texture registry descriptor set layout!");
+	}
+
+	void TextureRegistry::grow(uint32_t minCapacity)
+	{
+		ZDevice* pDevice = Core::GetCore().GetDevice();
+
+		uint32_t newCapacity = std::max(m_capacity * 2, (uint32_t)MIN_TEXTURE_REGISTRY_CAPACITY);
+		while (newCapacity < minCapacity)
+			newCapacity *= 2;
+
+		newCapacity = std::min(newCapacity, m_maxCapacity);
+
+		// Commands recorded this frame (and the frames still in flight) may have the old set bound
+		if (m_descriptorPool != VK_NULL_HANDLE)
+			m_retiredPools.push_back({ m_descriptorPool, MAX_FRAMES_IN_FLIGHT });
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		poolSize.descriptorCount = newCapacity;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = 1;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+		if (vkCreateDescriptorPool(pDevice->GetDevice(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create texture registry descriptor pool!");
+
+		VkDescriptorSetVariableDescriptorCountAllocateInfoEXT countInfo{};
+		countInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+		countInfo.descriptorSetCount = 1;
+		countInfo.pDescriptorCounts = &newCapacity;
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &m_descriptorSetLayout;
+		allocInfo.pNext = &countInfo;
+
+		if (vkAllocateDescriptorSets(pDevice->GetDevice(), &allocInfo, &m_descriptorSet) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate texture registry descriptor set!");
+
+		m_capacity = newCapacity;
+		m_imageInfos.resize(m_capacity);
+
+		// Released slots point at destroyed image views so only the runs of live slots are written
+		for (uint32_t first = 0; first < m_slotCount;)
+		{
+			if (m_imageInfos[first].imageView == VK_NULL_HANDLE)
+			{
+				++first;
+				continue;
+			}
+
+			uint32_t last = first + 1;
+			while (last < m_slotCount && m_imageInfos[last].imageView != VK_NULL_HANDLE)
+				++last;
+
+			writeSlots(first, last - first);
+			first = last;
+		}
+	}
+
+	void TextureRegistry::writeSlots(uint32_t first, uint32_t count)
+	{
+		VkWriteDescriptorSet setWrite{};
+		setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrite.dstSet = m_descriptorSet;
+		setWrite.dstBinding = TEXTURE_REGISTRY_BINDING;
+		setWrite.dstArrayElement = first;
+		setWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		setWrite.descriptorCount = count;
+		setWrite.pImageInfo = &m_imageInfos[first];
+
+		vkUpdateDescriptorSets(Core::GetCore().GetDevice()->GetDevice(), 1, &setWrite, 0, nullptr);
+	}
+
+	uint32_t TextureRegistry::allocateSlot()
+	{
+		if (!m_freeSlots.empty())
+		{
+			uint32_t slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+
+			return slot;
+		}
+
+		if (m_slotCount == m_capacity)
+		{
+			if (m_capacity == m_maxCapacity)
+				throw std::runtime_error("Out of texture slots, consider using a texture atlas!");
+
+			grow(m_slotCount + 1);
+		}
+
+		return m_slotCount++;
+	}
+}
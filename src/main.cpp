@@ -1,6 +1,10 @@
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
 
 #include "../Headers/Core/Core.h"
+#include "../Headers/Core/Timer.h"
 
 #include "../Headers/Render/Texture2D.h"
 #include "../Headers/Render/Sprite.h"
@@ -16,9 +20,10 @@
 #include "../Headers/Shapes/Rectangle.h"
 #include "../Headers/Shapes/Circle.h"
 
-int main()
+int main(int argc, char** argv)
 {
 	ZVK::Vec4 randomColour();
+	void writePPM(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height);
 
 	srand((unsigned int)time(0));
 
@@ -43,9 +48,29 @@ int main()
 
 	std::string sPath = "resources/shaders/spir-v/";
 
+	// --headless renders headlessFrameCount frames without a window and writes the last one to headless.ppm.
+	// --static skips the immediate particles and keeps the shapes and light still, nothing changes
+	// between frames so the renderer can submit the frames it recorded again
+	bool isHeadless = false;
+	bool isStatic = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+			isHeadless = true;
+		else if (strcmp(argv[i], "--static") == 0)
+			isStatic = true;
+	}
+
+	const uint32_t headlessFrameCount = 600;
+	uint32_t renderedFrameCount = 0;
+
 	try
 	{
-		core.Init("Example App", 1280, 720);
+		if (isHeadless)
+			core.InitHeadless("Example App", 1280, 720);
+		else
+			core.Init("Example App", 1280, 720);
 
 		// Set sprites
 		{
@@ -104,18 +129,40 @@ int main()
 		ZVK::SpriteRenderer spriteRenderer(renderer, &spritePipeline, "resources/textures/error.png");
 		ZVK::ShapeRenderer shapeRenderer(renderer, &lightPipeline);
 
+		// The lights are see through and have to be drawn over the shapes, cutout lists are ordered
+		// by batch so the light list is made translucent to be drawn after them
+		shapeRenderer.SetBatchBlendMode(shapeRenderer.GetListBatch(lights), ZVK::BlendMode::TRANSLUCENT);
+
 		sprites[0]->SetRotationZ(ToRadians(35.f));
 		sprites[1]->SetScaleX(-1.f);
 
+		// Immediate draws are timed to report how many quads a millisecond they're appended at
+		const uint32_t particleCount = 1024;
+		ZVK::Timer immediateTimer;
+		ZVK::Timer reportTimer;
+		int64_t immediateMicroseconds = 0;
+		uint32_t immediateQuadCount = 0;
+
+		// Frames are averaged over the same second, the fence wait is the time the CPU was stalled on the GPU
+		int64_t frameMicroseconds = 0;
+		int64_t fenceWaitMicroseconds = 0;
+		uint32_t frameCount = 0;
+
+		// Frames that submitted the command buffers of an earlier frame, immediate draws make every frame record
+		ZVK::RecordCacheStats lastCacheStats;
+
 		float shapeRotation = 0.f;
-		while (!core.GetWindow().ShouldClose())
+		while (isHeadless ? renderedFrameCount < headlessFrameCount : !core.GetWindow().ShouldClose())
 		{
-			glfwPollEvents();
+			if (!isHeadless)
+				glfwPollEvents();
 
 			cam.Update();
 
-			for (auto rect : shapes)
-				rect->SetRotation(shapeRotation);
+			// Setting a shape's rotation changes its version even when the rotation is the same
+			if (!isStatic)
+				for (auto rect : shapes)
+					rect->SetRotation(shapeRotation);
 
 			// Make the light follow the mouse cursor
 			ZVK::Vec2 lightPos = ZVK::Vec2(
@@ -126,6 +173,10 @@ int main()
 
 			renderer.Begin();
 
+			frameMicroseconds += renderer.GetFrameStats().FrameMicroseconds;
+			fenceWaitMicroseconds += renderer.GetFrameStats().FenceWaitMicroseconds;
+			++frameCount;
+
 			// Sprites, Camera/MVP, CanUpdateVertices
 			spriteRenderer.Draw(sprites, cam.GetPV(), false);
 
@@ -133,12 +184,67 @@ int main()
 			shapeRenderer.Draw(shapes, cam, true);
 			shapeRenderer.Draw(lights, cam.GetPV());
 
+			// Immediate mode, nothing is kept after the frame. Immediate draws make every frame record
+			if (!isStatic)
+			{
+				immediateTimer.Restart();
+
+				for (uint32_t i = 0; i < particleCount; ++i)
+				{
+					float angle = shapeRotation * 10.f + (float)i * 0.05f;
+					float distance = 32.f + (float)(i % 256);
+
+					shapeRenderer.DrawQuad(Vec3(960.f + cosf(angle) * distance, 360.f + sinf(angle) * distance, -0.1f),
+						Vec2(4.f, 4.f), Vec4(1.f, (float)(i % 256) / 255.f, 0.2f, 1.f), cam.GetPV(), angle);
+				}
+
+				shapeRenderer.DrawCircle(Vec3(960.f, 360.f, -0.1f), 24.f, Vec4(1.f, 0.8f, 0.2f, 1.f), cam.GetPV());
+
+				immediateMicroseconds += immediateTimer.Restart();
+				immediateQuadCount += particleCount + 1;
+			}
+
+			if (reportTimer.GetElapsedTime() >= 1000000 && frameCount > 0)
+			{
+				if (immediateMicroseconds > 0)
+					std::cout << "Immediate mode: " <<
+						(double)immediateQuadCount / ((double)immediateMicroseconds / 1000.0) << " quads/ms\n";
+
+				std::cout << "Frame: " << (double)frameMicroseconds / 1000.0 / frameCount << " ms, waiting on the GPU: " <<
+					(double)fenceWaitMicroseconds / 1000.0 / frameCount << " ms\n";
+
+				const ZVK::RecordCacheStats& cacheStats = renderer.GetRecordCacheStats();
+
+				std::cout << "Recorded frames reused: " << cacheStats.HitCount - lastCacheStats.HitCount << " of " <<
+					(cacheStats.HitCount + cacheStats.RecordCount) - (lastCacheStats.HitCount + lastCacheStats.RecordCount) << "\n";
+
+				lastCacheStats = cacheStats;
+
+				reportTimer.Restart();
+				immediateMicroseconds = 0;
+				immediateQuadCount = 0;
+				frameMicroseconds = 0;
+				fenceWaitMicroseconds = 0;
+				frameCount = 0;
+			}
+
 			renderer.End();
+			++renderedFrameCount;
 
+			if (!isStatic)
+			{
+				lights[0]->SetPos(Vec3(lightPos, -0.5f));
+				shapeRotation += ToRadians(0.1f);
+			}
+		}
 
-			lights[0]->SetPos(Vec3(lightPos, -0.5f));
+		if (isHeadless)
+		{
+			std::vector<uint8_t> pixels;
+			renderer.ReadPixels(pixels);
 
-			shapeRotation += ToRadians(0.1f);
+			VkExtent2D extent = core.GetSwapchain()->GetSwapchainExtent();
+			writePPM("headless.ppm", pixels, extent.width, extent.height);
 		}
 	}
 	catch (std::exception e)
@@ -152,4 +258,14 @@ int main()
 ZVK::Vec4 randomColour()
 {
 	return { (float)rand() / RAND_MAX, (float)rand() / RAND_MAX, (float)rand() / RAND_MAX, 1.f };
+}
+
+// Binary PPM, the alpha of the RGBA pixels is dropped
+void writePPM(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+{
+	std::ofstream file(path, std::ios::binary);
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	for (size_t i = 0; i < (size_t)width * height; ++i)
+		file.write((const char*)&pixels[i * 4], 3);
 }
\ No newline at end of file